@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "GOP.h"
 #include "USTC_CG.h"
 #include "Utils/Logging/Logging.h"
@@ -28,6 +30,12 @@ struct GOperandComponent {
 
    protected:
     GOperandBase* attached_operand;
+
+   private:
+    friend class GOperandBase;
+    // Set once a copy of an operand refers to this component too. It is never cleared, the
+    // operands holding it clone it before writing.
+    mutable std::atomic<bool> shared = false;
 };
 
 // DeclareComponent(OpenMeshComponent);
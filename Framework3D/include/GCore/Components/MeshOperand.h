@@ -1,8 +1,11 @@
 #pragma once
+#include <mutex>
 #include <string>
 
 #include "GCore/Components.h"
 #include "GCore/GOP.h"
+#include "GCore/HalfEdgeTopology.h"
+#include "GCore/Triangulation.h"
 #include "pxr/usd/usdGeom/xform.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
@@ -21,7 +24,28 @@ struct USTC_CG_API MeshComponent : public GOperandComponent {
     pxr::VtArray<pxr::GfVec2f> texcoordsArray;
     pxr::VtArray<pxr::GfVec3f> displayColor;
 
+    // Built on first use, then kept, and shared with the copies of the component, as long as
+    // faceVertexCounts, faceVertexIndices and the vertex count are unchanged. The topology holds
+    // the face arrays, so writing to them detaches them from it and the next call rebuilds it.
+    std::shared_ptr<const HalfEdgeTopology> half_edge_topology() const;
+    HalfEdgeMesh half_edge_mesh() const
+    {
+        return { half_edge_topology(), vertices };
+    }
+
+    // Kept like the topology, as long as the face arrays and, for faces of more than three
+    // vertices, the vertices are unchanged. It comes from Triangulation::get, so the render
+    // delegates reuse it for the same arrays.
+    std::shared_ptr<const Triangulation> triangulation() const;
+
     GOperandComponentHandle copy(GOperandBase* operand) const override;
+
+   private:
+    mutable std::mutex topology_mutex_;
+    mutable std::shared_ptr<const HalfEdgeTopology> topology_;
+    // Holds the buffer the topology was built from, like the topology holds the indices.
+    mutable pxr::VtArray<int> topology_face_vertex_counts_;
+    mutable std::shared_ptr<const Triangulation> triangulation_;
 };
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
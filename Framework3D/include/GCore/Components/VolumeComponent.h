@@ -1,17 +1,62 @@
 #pragma once
 
+#include <openvdb/openvdb.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
 #include "GCore/Components.h"
 #include "GCore/GOP.h"
 #include "USTC_CG.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
-class USTC_CG_API VolumeComponet : public GOperandComponent {
+// Named OpenVDB grids of any type. Copies of the component share the grids, and a grid is never
+// modified while shared: writable_grid copies it first if anything else holds it.
+class USTC_CG_API VolumeComponent : public GOperandComponent {
    public:
-    explicit VolumeComponet(GOperandBase* attached_operand) : GOperandComponent(attached_operand)
-    {
-    }
+    // The grid the nodes read and write a signed distance field as.
+    static constexpr const char* surface = "surface";
+
+    explicit VolumeComponent(GOperandBase* attached_operand);
 
     GOperandComponentHandle copy(GOperandBase* operand) const override;
     std::string to_string() const override;
+
+    // Null when there is no grid of that name and type.
+    template<typename GridType>
+    typename GridType::ConstPtr grid(const std::string& name) const;
+    template<typename GridType>
+    typename GridType::Ptr writable_grid(const std::string& name);
+
+    void set_grid(const std::string& name, openvdb::GridBase::Ptr grid);
+    void remove_grid(const std::string& name);
+    std::vector<std::string> grid_names() const;
+
+   private:
+    std::map<std::string, openvdb::GridBase::Ptr> grids_;
 };
+
+template<typename GridType>
+typename GridType::ConstPtr VolumeComponent::grid(const std::string& name) const
+{
+    auto found = grids_.find(name);
+    if (found == grids_.end()) {
+        return nullptr;
+    }
+    return openvdb::gridConstPtrCast<GridType>(found->second);
+}
+
+template<typename GridType>
+typename GridType::Ptr VolumeComponent::writable_grid(const std::string& name)
+{
+    auto found = grids_.find(name);
+    if (found == grids_.end() || !openvdb::gridPtrCast<GridType>(found->second)) {
+        return nullptr;
+    }
+    if (found->second.use_count() > 1) {
+        found->second = found->second->deepCopyGrid();
+    }
+    return openvdb::gridPtrCast<GridType>(found->second);
+}
 USTC_CG_NAMESPACE_CLOSE_SCOPE
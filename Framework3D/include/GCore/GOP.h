@@ -4,6 +4,9 @@
 
 #include <memory>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 #include <pxr/usd/sdf/path.h>
 #include <pxr/usd/usd/stage.h>
 
@@ -15,6 +18,9 @@ using GOperandComponentHandle = std::shared_ptr<GOperandComponent>;
 
 using GOperandBaseHandle = std::shared_ptr<GOperandBase>;
 
+// Components are shared between copies of an operand and treated as immutable while shared: the
+// first write access through an operand clones the component for it (copy on write). Components
+// are looked up by their exact type.
 class USTC_CG_API GOperandBase
 {
 public:
@@ -46,42 +52,64 @@ public:
 
     virtual std::string to_string() const;
 
-
+    // Read access, the component may be shared with other operands.
+    template<typename OperandType>
+    std::shared_ptr<const OperandType> get_component(size_t idx = 0) const;
+    // Write access, clones the component first if it is shared. Keep the returned pointer for
+    // further writes: a copy of this operand taken in between shares the component again.
     template<typename OperandType>
-    std::shared_ptr<OperandType> get_component(size_t idx = 0) const;
+    std::shared_ptr<OperandType> get_component(size_t idx = 0);
+
     void attach_component(const GOperandComponentHandle& component);
     void detach_component(const GOperandComponentHandle& component);
 
+    // For reading only.
     [[nodiscard]] const std::vector<GOperandComponentHandle>&
     get_components() const
     {
         return components_;
     }
 
+#ifndef NDEBUG
+    // Number of components cloned by write accesses, over all operands.
+    static size_t component_clone_count();
+#endif
+
 protected:
     std::vector<GOperandComponentHandle> components_;
+
+private:
+    // -1 when there is no such component.
+    ptrdiff_t find_component(const std::type_info& type, size_t idx) const;
+    void unshare_component(size_t position);
+    void add_component(const GOperandComponentHandle& component);
+    void rebuild_component_index();
+
+    // Positions in components_ of the components of each type, in attachment order.
+    std::unordered_map<std::type_index, std::vector<size_t>> component_index_;
 };
 
 template<typename OperandType>
-std::shared_ptr<OperandType> GOperandBase::get_component(size_t idx) const
+std::shared_ptr<const OperandType> GOperandBase::get_component(size_t idx) const
+{
+    auto position = find_component(typeid(OperandType), idx);
+    if (position < 0)
+    {
+        return nullptr;
+    }
+    return std::static_pointer_cast<const OperandType>(components_[position]);
+}
+
+template<typename OperandType>
+std::shared_ptr<OperandType> GOperandBase::get_component(size_t idx)
 {
-    size_t counter = 0;
-    for (int i = 0; i < components_.size(); ++i)
+    auto position = find_component(typeid(OperandType), idx);
+    if (position < 0)
     {
-        auto ptr = std::dynamic_pointer_cast<OperandType>(components_[i]);
-        if (ptr)
-        {
-            if (counter < idx)
-            {
-                counter++;
-            }
-            else
-            {
-                return ptr;
-            }
-        }
+        return nullptr;
     }
-    return nullptr;
+    unshare_component(position);
+    return std::static_pointer_cast<OperandType>(components_[position]);
 }
 
 
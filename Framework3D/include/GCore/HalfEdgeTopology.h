@@ -0,0 +1,111 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/vt/array.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Half-edge connectivity of a polygon mesh, stored as flat arrays.
+//
+// Half-edges are the face corners: half-edge h starts at faceVertexIndices[h] and belongs to the
+// face whose corners contain h, so the mesh arrays are used as they are and nothing is stored
+// per vertex but one outgoing half-edge. There are no half-edges outside the faces: opposite is -1
+// on the boundary, and also on non-manifold or inconsistently oriented edges, which are then
+// treated as boundary.
+struct USTC_CG_API HalfEdgeTopology {
+    HalfEdgeTopology(
+        const pxr::VtArray<int>& faceVertexCounts,
+        const pxr::VtArray<int>& faceVertexIndices,
+        size_t vertex_count);
+
+    size_t n_vertices() const
+    {
+        return vertex_half_edge.size();
+    }
+    size_t n_faces() const
+    {
+        return face_half_edge.size() - 1;
+    }
+    size_t n_half_edges() const
+    {
+        return next.size();
+    }
+    size_t n_edges() const
+    {
+        return edge_half_edge.size();
+    }
+
+    int from_vertex(int h) const
+    {
+        return face_vertex_indices[h];
+    }
+    int to_vertex(int h) const
+    {
+        return face_vertex_indices[next[h]];
+    }
+    bool is_boundary_half_edge(int h) const
+    {
+        return opposite[h] < 0;
+    }
+    bool is_boundary_vertex(int v) const
+    {
+        return vertex_half_edge[v] < 0 || opposite[vertex_half_edge[v]] < 0;
+    }
+    bool is_boundary_edge(int e) const
+    {
+        return opposite[edge_half_edge[e]] < 0;
+    }
+
+    // Visits the half-edges going out of v, one per adjacent face. On the boundary the first one
+    // has no opposite.
+    template<typename Function>
+    void for_each_outgoing(int v, Function&& function) const
+    {
+        int start = vertex_half_edge[v];
+        if (start < 0) {
+            return;
+        }
+        int h = start;
+        do {
+            function(h);
+            h = opposite[prev[h]];
+        } while (h >= 0 && h != start);
+    }
+
+    // Shares the buffer of the mesh.
+    pxr::VtArray<int> face_vertex_indices;
+
+    // Per half-edge.
+    std::vector<int> next;
+    std::vector<int> prev;
+    std::vector<int> opposite;
+    std::vector<int> face;
+    std::vector<int> edge;
+
+    // First half-edge of each face, with the half-edge count appended.
+    std::vector<int> face_half_edge;
+    // An outgoing half-edge of each vertex, on the boundary if the vertex is. -1 if isolated.
+    std::vector<int> vertex_half_edge;
+    // A half-edge of each edge.
+    std::vector<int> edge_half_edge;
+
+    // Edges shared by more than two faces, or by two faces that do not agree on orientation.
+    size_t non_manifold_edges = 0;
+};
+
+// The topology of a mesh together with its positions, both shared with the mesh.
+struct HalfEdgeMesh {
+    std::shared_ptr<const HalfEdgeTopology> topology;
+    pxr::VtArray<pxr::GfVec3f> positions;
+
+    const HalfEdgeTopology* operator->() const
+    {
+        return topology.get();
+    }
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/vt/array.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Triangles of a polygon mesh, with the face corner each triangle corner comes from, so that
+// face-varying values follow the triangles.
+//
+// A face of n corners gives n - 2 triangles, wound like the face. Quads are split along the
+// diagonal from a convex corner, larger polygons are ear-clipped in their plane, so non-convex
+// faces stay inside their outline. Faces no ear can be clipped from, such as degenerate or
+// self-intersecting ones, are finished as fans. Faces are triangulated in parallel, each into the
+// range the prefix sum of the triangle counts gives it.
+struct USTC_CG_API Triangulation {
+    // Cached by the buffers of the arrays. The points only matter for faces of more than three
+    // corners, so a triangle mesh with moving points keeps its triangulation. The nodes and the
+    // render delegates see the same buffers through the stage, so they share the result.
+    static std::shared_ptr<const Triangulation> get(
+        const pxr::VtArray<int>& faceVertexCounts,
+        const pxr::VtArray<int>& faceVertexIndices,
+        const pxr::VtArray<pxr::GfVec3f>& points);
+
+    Triangulation(
+        const pxr::VtArray<int>& faceVertexCounts,
+        const pxr::VtArray<int>& faceVertexIndices,
+        const pxr::VtArray<pxr::GfVec3f>& points);
+
+    // Whether it was built from these arrays, or from others of the same buffers.
+    bool is_for(
+        const pxr::VtArray<int>& faceVertexCounts,
+        const pxr::VtArray<int>& faceVertexIndices,
+        const pxr::VtArray<pxr::GfVec3f>& points) const;
+
+    size_t n_triangles() const
+    {
+        return triangle_faces.size();
+    }
+
+    // Three per triangle: the vertices, and their positions in faceVertexIndices.
+    pxr::VtArray<int> triangle_vertices;
+    pxr::VtArray<int> triangle_corners;
+    // The face of each triangle.
+    pxr::VtArray<int> triangle_faces;
+    // First triangle of each face, with the triangle count appended.
+    std::vector<int> face_triangles;
+
+    // Values per face corner, to values per triangle corner.
+    template<typename T>
+    pxr::VtArray<T> face_varying(const pxr::VtArray<T>& values) const;
+    // Values per face, to values per triangle.
+    template<typename T>
+    pxr::VtArray<T> uniform(const pxr::VtArray<T>& values) const;
+
+   private:
+    // Held so that their buffers, which identify them in the cache, are not reused.
+    pxr::VtArray<int> face_vertex_counts_;
+    pxr::VtArray<int> face_vertex_indices_;
+    pxr::VtArray<pxr::GfVec3f> points_;
+    bool uses_points_ = false;
+};
+
+template<typename T>
+pxr::VtArray<T> Triangulation::face_varying(const pxr::VtArray<T>& values) const
+{
+    pxr::VtArray<T> result(triangle_corners.size());
+    T* data = result.data();
+    for (size_t i = 0; i < triangle_corners.size(); ++i) {
+        data[i] = values[triangle_corners[i]];
+    }
+    return result;
+}
+
+template<typename T>
+pxr::VtArray<T> Triangulation::uniform(const pxr::VtArray<T>& values) const
+{
+    pxr::VtArray<T> result(triangle_faces.size());
+    T* data = result.data();
+    for (size_t i = 0; i < triangle_faces.size(); ++i) {
+        data[i] = values[triangle_faces[i]];
+    }
+    return result;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -27,6 +27,8 @@ class NodeSystem {
 
     float cached_last_time_code();
     void set_required_time_code(float time_code_to_render);
+    // Simulates up to end_time_code at once, so the timeline can then play the cached frames.
+    void bake(float end_time_code);
 
 protected:
     std::string window_name;
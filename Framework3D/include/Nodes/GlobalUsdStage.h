@@ -1,6 +1,10 @@
 #pragma once
+#include <pxr/usd/sdf/path.h>
 #include <pxr/usd/usd/stage.h>
 
+#include <functional>
+#include <set>
+
 #include "USTC_CG.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
@@ -13,6 +17,16 @@ struct GlobalUsdStage {
 
     static constexpr int timeCodesPerSecond = 30;
 
+    // Prims the geometry nodes wrote during the current execution. Instead of clearing the stage
+    // before executing, the prims that were not written again are removed after it, so the prims
+    // that are written again only see their changed attributes.
+    static std::set<pxr::SdfPath> written_prims;
+
+    // Nodes that keep something open across the frames of a simulation (e.g. files being
+    // exported to) let go of it when the simulation stops: when playback pauses, a bake ends,
+    // or the tree starts over.
+    static void on_simulation_stopped(std::function<void()> callback);
+    static void simulation_stopped();
 };
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
\ No newline at end of file
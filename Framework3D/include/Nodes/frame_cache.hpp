@@ -0,0 +1,75 @@
+#pragma once
+#include <filesystem>
+#include <map>
+
+#include "USTC_CG.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/usd/stage.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+struct FrameCacheStatistics {
+    size_t frames = 0;
+    size_t frames_on_disk = 0;
+    // Estimated size of the frames held in memory.
+    size_t bytes = 0;
+};
+
+// Keeps what a simulation has written under a root prim of the stage for every time code, so the
+// timeline can go back to any simulated frame without running the tree again.
+//
+// A frame is a copy of the specs under the root in an anonymous layer. Beyond the memory budget,
+// the least recently shown frames are exported once to a crate file in the cache directory and
+// dropped; USD maps crate files into memory when they are opened again. Files are never rewritten:
+// storing a time code again writes a new file.
+class SimulationFrameCache {
+   public:
+    SimulationFrameCache(
+        const pxr::SdfPath& root,
+        size_t budget_bytes,
+        std::filesystem::path directory);
+    SimulationFrameCache(const SimulationFrameCache&) = delete;
+    SimulationFrameCache& operator=(const SimulationFrameCache&) = delete;
+    ~SimulationFrameCache();
+
+    // Snapshots the root of the stage as the frame of time_code, which the stage then shows.
+    void store(float time_code, const pxr::UsdStageRefPtr& stage);
+    // Puts the latest frame at or before time_code back on the stage, unless it is the one the
+    // stage already shows. Returns false if there is no such frame.
+    bool restore(float time_code, const pxr::UsdStageRefPtr& stage);
+
+    // Forgets every frame and deletes their files.
+    void clear();
+
+    void set_budget(size_t budget_bytes);
+    const FrameCacheStatistics& statistics() const
+    {
+        return statistics_;
+    }
+
+   private:
+    struct Frame {
+        // Null when the frame is only on disk.
+        pxr::SdfLayerRefPtr layer;
+        size_t bytes = 0;
+        size_t last_used = 0;
+        std::filesystem::path file;
+    };
+
+    pxr::SdfLayerRefPtr load(Frame& frame);
+    void evict_to_budget(const Frame* keep);
+    void erase(std::map<float, Frame>::iterator frame);
+
+    const pxr::SdfPath root_;
+    size_t budget_bytes_;
+    std::filesystem::path directory_;
+
+    std::map<float, Frame> frames_;
+    const Frame* shown_ = nullptr;
+    size_t use_counter_ = 0;
+    size_t file_counter_ = 0;
+    FrameCacheStatistics statistics_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
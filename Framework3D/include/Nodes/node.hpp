@@ -46,6 +46,12 @@ struct NodeTypeInfo {
     NodeDeclareFunction declare;
     ExecFunction node_execute;
     bool ALWAYS_REQUIRED = false;
+    // The outputs only depend on the inputs, so an executor may reuse them while the inputs are
+    // unchanged. Clear it for nodes that read state their inputs do not carry.
+    bool CACHE_OUTPUTS = true;
+    // The node may execute on a worker thread, concurrently with other nodes. Not for nodes that
+    // use the GL context or edit shared state such as the global stage.
+    bool THREAD_SAFE = false;
 
     std::unique_ptr<NodeDeclaration> static_declaration;
 };
@@ -70,6 +76,10 @@ struct Node {
 
     std::function<void()> override_left_pane_info = nullptr;
 
+    // Socket indices resolved by ExeParams, keyed by the address of the identifier.
+    mutable std::vector<std::pair<const char*, int>> input_index_cache;
+    mutable std::vector<std::pair<const char*, int>> output_index_cache;
+
     bool has_available_linked_inputs = false;
     bool has_available_linked_outputs = false;
 
@@ -21,6 +21,9 @@ class SocketDeclaration : public ItemDeclaration {
     SocketType type;
     std::string name;
     std::string identifier;
+    // An unlinked optional input without a default value passes a default constructed value,
+    // instead of keeping the node from running.
+    bool optional = false;
 
     virtual NodeSocket* build(NodeTree* ntree, Node* node) const = 0;
 
@@ -49,6 +52,13 @@ class SocketDeclarationBuilder : public BaseSocketDeclarationBuilder {
     SocketDecl* decl_;
 
     friend class NodeDeclarationBuilder;
+
+   public:
+    Self& optional()
+    {
+        decl_->optional = true;
+        return static_cast<Self&>(*this);
+    }
 };
 
 class NodeDeclaration {
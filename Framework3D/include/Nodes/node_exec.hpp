@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <utility>
 #include <vector>
 
 #include "USTC_CG.h"
@@ -30,6 +31,33 @@ struct ExeParams {
         return value;
     }
 
+    /**
+     * Read the input value in place, without copying it. The reference is valid until the node
+     * returns.
+     */
+    template<typename T>
+    const T& get_input_ref(const char* identifier) const
+    {
+        const int index = this->get_input_index(identifier);
+        return *static_cast<const T*>(inputs_[index].get());
+    }
+
+    /**
+     * Get the input value to modify it. Every input holds its own value, forwarded from the
+     * output linked to it, so the value is moved out when the executor does not read the inputs
+     * after the execution, and copied otherwise. Take each input at most once.
+     */
+    template<typename T>
+    T take_input(const char* identifier)
+    {
+        const int index = this->get_input_index(identifier);
+        T& value = *static_cast<T*>(inputs_[index].get());
+        if (inputs_movable_) {
+            return std::move(value);
+        }
+        return value;
+    }
+
     /**
      * Store the output value for the given socket identifier.
      */
@@ -51,6 +79,7 @@ struct ExeParams {
    private:
     std::vector<GMutablePointer> inputs_;
     std::vector<GMutablePointer> outputs_;
+    bool inputs_movable_ = false;
 };
 
 // This executes a tree. The execution strategy is left to its children.
@@ -0,0 +1,81 @@
+#pragma once
+#include <map>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "Utils/Functions/GenericPointer.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+struct Node;
+struct NodeTree;
+
+struct NodeCacheStatistics {
+    size_t hits = 0;
+    size_t recomputes = 0;
+    size_t evictions = 0;
+    // Estimated size of the outputs held by the cache.
+    size_t bytes = 0;
+};
+
+// Memoizes node outputs across executions of a tree.
+//
+// Every execution of a node gives its outputs a version. The key of a node hashes its type, the
+// values of its unlinked inputs and the versions of the outputs linked to it, so editing a socket
+// changes the key of its node only, and the new version it then gets changes the keys downstream.
+// Nodes whose key is unchanged copy their cached outputs instead of executing.
+//
+// Nodes that are ALWAYS_REQUIRED or not CACHE_OUTPUTS, and nodes with outputs that cannot be
+// copied, always execute and always get a new version.
+class NodeOutputCache {
+   public:
+    explicit NodeOutputCache(size_t budget_bytes) : budget_bytes_(budget_bytes)
+    {
+    }
+    NodeOutputCache(const NodeOutputCache&) = delete;
+    NodeOutputCache& operator=(const NodeOutputCache&) = delete;
+    ~NodeOutputCache();
+
+    bool is_cacheable(const Node* node) const;
+
+    // Only meaningful once the upstream nodes of this execution have been looked up or stored.
+    size_t compute_key(const Node* node) const;
+
+    // On a hit, copies the cached outputs into `outputs`, in the order of node->outputs.
+    bool lookup(const Node* node, size_t key, const std::vector<GMutablePointer>& outputs);
+    // Keeps a copy of the outputs of a node that has just been executed, evicting the least
+    // recently used outputs beyond the budget.
+    void store(const Node* node, size_t key, const std::vector<GMutablePointer>& outputs);
+    // The node has been executed without being cached, or has failed.
+    void invalidate(const Node* node);
+
+    // Forgets the nodes that are no longer in the tree.
+    void prune(const NodeTree* tree);
+    void clear();
+
+    void set_budget(size_t budget_bytes);
+    const NodeCacheStatistics& statistics() const
+    {
+        return statistics_;
+    }
+
+   private:
+    struct Entry {
+        size_t key = 0;
+        size_t version = 0;
+        // Empty when not cached or evicted. The version stays valid as long as the key does.
+        std::vector<GMutablePointer> outputs;
+        size_t bytes = 0;
+        size_t last_used = 0;
+    };
+
+    void release_outputs(Entry& entry);
+    void evict_to_budget();
+
+    std::map<const Node*, Entry> entries_;
+    size_t version_counter_ = 0;
+    size_t use_counter_ = 0;
+    size_t budget_bytes_;
+    NodeCacheStatistics statistics_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,10 +1,12 @@
 #pragma once
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include "USTC_CG.h"
 #include "Utils/Functions/GenericPointer.hpp"
 #include "node_exec.hpp"
+#include "node_exec_cache.hpp"
 #include "node_tree.hpp"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
@@ -23,7 +25,9 @@ struct RuntimeOutputState {
 };
 
 // Provide single threaded execution. The aim of this executor is simplicity and
-// robustness.
+// robustness. Once the tree is prepared, the execution of a node only reads the shared state and
+// writes the states of its own sockets and the inputs linked to them, so that subclasses may
+// execute independent nodes concurrently.
 
 class EagerNodeTreeExecutor : public NodeTreeExecutor {
    public:
@@ -35,9 +39,20 @@ class EagerNodeTreeExecutor : public NodeTreeExecutor {
     void sync_node_from_external_storage(NodeSocket* socket, void* data) override;
     void sync_node_to_external_storage(NodeSocket* socket, void* data) override;
 
+    // Reuse the outputs of nodes whose inputs have not changed since a previous execution, see
+    // NodeOutputCache. Off by default: the outputs must stay valid between executions.
+    void enable_output_cache(size_t budget_bytes);
+    // nullptr when the output cache is off.
+    const NodeOutputCache* output_cache() const
+    {
+        return output_cache_.get();
+    }
+
    protected:
     virtual ExeParams prepare_params(NodeTree* tree, Node* node);
     virtual bool execute_node(NodeTree* tree, Node* node);
+    bool execute_node_cached(NodeTree* tree, Node* node);
+    bool inputs_available(Node* node);
     void forward_output_to_input(Node* node);
     void clear();
 
@@ -48,6 +63,11 @@ class EagerNodeTreeExecutor : public NodeTreeExecutor {
     std::vector<NodeSocket*> input_of_nodes_to_execute;
     std::vector<NodeSocket*> output_of_nodes_to_execute;
     ptrdiff_t nodes_to_execute_count = 0;
+    // ExeParams::take_input may move the inputs out. Off for executors that read the inputs after
+    // their node has executed.
+    bool take_inputs_by_move = true;
+    std::unique_ptr<NodeOutputCache> output_cache_;
+    std::mutex output_cache_mutex_;
 };
 
 std::unique_ptr<EagerNodeTreeExecutor> CreateEagerNodeTreeExecutorRender();
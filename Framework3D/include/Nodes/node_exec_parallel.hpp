@@ -0,0 +1,16 @@
+#pragma once
+#include "node_exec_eager.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Executes the independent branches of a tree concurrently. A node is dispatched to the work
+// pool once all the nodes linked to its inputs are done. Nodes whose type is not THREAD_SAFE run
+// on the thread calling execute_tree, which is the one holding the GL context if there is one.
+class ParallelNodeTreeExecutor : public EagerNodeTreeExecutor {
+   public:
+    void execute_tree(NodeTree* tree) override;
+};
+
+std::unique_ptr<EagerNodeTreeExecutor> CreateParallelNodeTreeExecutor();
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
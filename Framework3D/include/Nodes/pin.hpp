@@ -49,6 +49,8 @@ struct NodeSocket {
     PinKind in_out;
 
     void* default_value = nullptr;
+    // From the declaration, see SocketDeclaration::optional.
+    bool optional = false;
 
     NodeSocket(int id = 0) : ID(id), Node(nullptr), in_out(PinKind::Input)
     {
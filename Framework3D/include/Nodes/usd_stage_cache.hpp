@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+#include "USTC_CG.h"
+#include "pxr/base/vt/value.h"
+#include "pxr/usd/sdf/path.h"
+#include "pxr/usd/usd/attribute.h"
+#include "pxr/usd/usd/stage.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Opens a file read-only, populated with only the prim at prim_path, its ancestors and its
+// descendants. The stage is shared by every call with the same file and prim until the file is
+// modified, so reading a frame of a time-sampled file does not parse and compose it again. Returns
+// null if the file cannot be opened.
+pxr::UsdStageRefPtr open_cached_stage(const std::string& file_name, const pxr::SdfPath& prim_path);
+
+// Reads the value of an attribute of a cached stage at time. The value last read from the
+// attribute is reused when time resolves to the same sample, so across the frames of an animation
+// only the attributes that change are read again. Array values are shared, not copied.
+bool read_cached_attribute(
+    const pxr::UsdAttribute& attribute,
+    pxr::UsdTimeCode time,
+    pxr::VtValue* value);
+
+template<typename T>
+bool read_cached_attribute(const pxr::UsdAttribute& attribute, pxr::UsdTimeCode time, T* value)
+{
+    pxr::VtValue read;
+    if (!read_cached_attribute(attribute, time, &read) || !read.IsHolding<T>()) {
+        return false;
+    }
+    *value = read.UncheckedGet<T>();
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
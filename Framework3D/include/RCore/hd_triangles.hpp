@@ -0,0 +1,121 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "GCore/Triangulation.h"
+#include "USTC_CG.h"
+#include "pxr/base/gf/vec2d.h"
+#include "pxr/base/gf/vec2f.h"
+#include "pxr/base/gf/vec2i.h"
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/gf/vec3i.h"
+#include "pxr/base/gf/vec4d.h"
+#include "pxr/base/gf/vec4f.h"
+#include "pxr/base/gf/vec4i.h"
+#include "pxr/base/tf/diagnostic.h"
+#include "pxr/base/vt/types.h"
+#include "pxr/base/vt/value.h"
+#include "pxr/imaging/hd/meshTopology.h"
+#include "pxr/imaging/hd/meshUtil.h"
+#include "pxr/imaging/hd/tokens.h"
+#include "pxr/usd/sdf/path.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// The triangles of a Hydra mesh, from the triangulation the nodes share, in the layout of
+// HdMeshUtil::ComputeTriangleIndices: hole faces are dropped and left-handed faces are flipped.
+// A topology that cannot be triangulated is warned about and gives no triangles.
+struct HdTriangles {
+    HdTriangles(
+        const pxr::HdMeshTopology& topology,
+        const pxr::VtVec3fArray& points,
+        const pxr::SdfPath& id)
+        : face_corner_count(topology.GetFaceVertexIndices().size())
+    {
+        std::shared_ptr<const Triangulation> triangulation;
+        try {
+            triangulation = Triangulation::get(
+                topology.GetFaceVertexCounts(), topology.GetFaceVertexIndices(), points);
+        }
+        catch (const std::runtime_error& error) {
+            TF_WARN("[%s] %s", id.GetText(), error.what());
+            return;
+        }
+
+        std::vector<bool> holes(topology.GetFaceVertexCounts().size());
+        for (int face : topology.GetHoleIndices()) {
+            if (face >= 0 && static_cast<size_t>(face) < holes.size()) {
+                holes[face] = true;
+            }
+        }
+        const bool flip = topology.GetOrientation() != pxr::HdTokens->rightHanded;
+
+        indices.reserve(triangulation->n_triangles());
+        primitive_params.reserve(triangulation->n_triangles());
+        corners.reserve(3 * triangulation->n_triangles());
+        for (size_t t = 0; t < triangulation->n_triangles(); ++t) {
+            const int face = triangulation->triangle_faces[t];
+            if (holes[face]) {
+                continue;
+            }
+            int order[3] = { 0, 1, 2 };
+            if (flip) {
+                std::swap(order[1], order[2]);
+            }
+            pxr::GfVec3i triangle;
+            for (int k = 0; k < 3; ++k) {
+                triangle[k] = triangulation->triangle_vertices[3 * t + order[k]];
+                corners.push_back(triangulation->triangle_corners[3 * t + order[k]]);
+            }
+            indices.push_back(triangle);
+            primitive_params.push_back(pxr::HdMeshUtil::EncodeCoarseFaceParam(face, 0));
+        }
+    }
+
+    // Values per face corner to values per triangle corner. False if the value is not an array of
+    // a value per face corner, of scalars or vectors of int, float or double.
+    bool triangulate_face_varying(const pxr::VtValue& value, pxr::VtValue* triangulated) const
+    {
+        return gather<float>(value, triangulated) || gather<pxr::GfVec2f>(value, triangulated) ||
+               gather<pxr::GfVec3f>(value, triangulated) ||
+               gather<pxr::GfVec4f>(value, triangulated) || gather<double>(value, triangulated) ||
+               gather<pxr::GfVec2d>(value, triangulated) ||
+               gather<pxr::GfVec3d>(value, triangulated) ||
+               gather<pxr::GfVec4d>(value, triangulated) || gather<int>(value, triangulated) ||
+               gather<pxr::GfVec2i>(value, triangulated) ||
+               gather<pxr::GfVec3i>(value, triangulated) ||
+               gather<pxr::GfVec4i>(value, triangulated);
+    }
+
+    pxr::VtVec3iArray indices;
+    // Coarse face params, for HdMeshUtil::DecodeFaceIndexFromCoarseFaceParam.
+    pxr::VtIntArray primitive_params;
+    // The face corner of each triangle corner, three per triangle.
+    pxr::VtIntArray corners;
+    size_t face_corner_count;
+
+   private:
+    template<typename T>
+    bool gather(const pxr::VtValue& value, pxr::VtValue* triangulated) const
+    {
+        if (!value.IsHolding<pxr::VtArray<T>>()) {
+            return false;
+        }
+        const auto& values = value.UncheckedGet<pxr::VtArray<T>>();
+        if (values.size() < face_corner_count) {
+            return false;
+        }
+        pxr::VtArray<T> result(corners.size());
+        T* data = result.data();
+        for (size_t i = 0; i < corners.size(); ++i) {
+            data[i] = values[corners[i]];
+        }
+        *triangulated = pxr::VtValue(std::move(result));
+        return true;
+    }
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
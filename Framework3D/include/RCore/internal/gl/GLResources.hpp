@@ -22,7 +22,9 @@ struct ShaderDesc {
     friend bool operator==(const ShaderDesc& lhs, const ShaderDesc& rhs)
     {
         return lhs.vertexPath == rhs.vertexPath && lhs.fragmentPath == rhs.fragmentPath &&
-               lhs.lastWriteTime == rhs.lastWriteTime;
+               lhs.computePath == rhs.computePath && lhs.vertexVersion == rhs.vertexVersion &&
+               lhs.fragmentVersion == rhs.fragmentVersion &&
+               lhs.computeVersion == rhs.computeVersion;
     }
 
     friend bool operator!=(const ShaderDesc& lhs, const ShaderDesc& rhs)
@@ -34,21 +36,33 @@ struct ShaderDesc {
 
     void set_fragment_path(const std::filesystem::path& fragment_path);
 
-   private:
-    void update_last_write_time(const std::filesystem::path& path);
+    // A desc with a compute path builds a compute program, the other paths are ignored.
+    void set_compute_path(const std::filesystem::path& compute_path);
 
+   private:
     friend ShaderHandle createShader(const ShaderDesc& desc);
     std::filesystem::path vertexPath;
     std::filesystem::path fragmentPath;
-    std::filesystem::file_time_type lastWriteTime;
+    std::filesystem::path computePath;
+    // From shader_file_watcher, so that editing a source gives a new desc.
+    std::uint64_t vertexVersion = 0;
+    std::uint64_t fragmentVersion = 0;
+    std::uint64_t computeVersion = 0;
 };
 
 struct ShaderResource {
     ShaderDesc desc;
     Shader shader;
+    // The previous version of this program, drawn with while the new one links.
+    ShaderHandle fallback;
+
+    ShaderResource(const char* vertexPath, const char* fragmentPath, const Shader* fallback_shader)
+        : shader(vertexPath, fragmentPath, fallback_shader)
+    {
+    }
 
-    ShaderResource(const char* vertexPath, const char* fragmentPath)
-        : shader(vertexPath, fragmentPath)
+    ShaderResource(const char* computePath, const Shader* fallback_shader)
+        : shader(computePath, fallback_shader)
     {
     }
 
@@ -67,10 +81,16 @@ struct TextureDesc {
     pxr::HdFormat format;
 
     unsigned array_size = 1;
+    // Allocates a GL_TEXTURE_2D_ARRAY even when array_size is 1.
+    bool layered = false;
+    // Depth-only storage (GL_DEPTH_COMPONENT32F). format must be HdFormatFloat32.
+    bool depth_only = false;
 
     friend bool operator==(const TextureDesc& lhs, const TextureDesc& rhs)
     {
-        return lhs.size == rhs.size && lhs.format == rhs.format && lhs.array_size == rhs.array_size;
+        return lhs.size == rhs.size && lhs.format == rhs.format &&
+               lhs.array_size == rhs.array_size && lhs.layered == rhs.layered &&
+               lhs.depth_only == rhs.depth_only;
     }
 
     friend bool operator!=(const TextureDesc& lhs, const TextureDesc& rhs)
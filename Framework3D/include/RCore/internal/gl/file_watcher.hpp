@@ -0,0 +1,56 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "USTC_CG.h"
+
+#ifdef __linux__
+#include <atomic>
+#include <thread>
+#endif
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Tracks modifications of files without touching the file system on every query. On Linux the
+// parent directories are watched with inotify from a background thread. Elsewhere the
+// modification time is polled, at most once per pollInterval for each file.
+class FileWatcher {
+   public:
+    FileWatcher();
+    ~FileWatcher();
+
+    // Changes whenever the file is written, created, replaced or removed. The first call for a
+    // path starts watching it.
+    std::uint64_t version(const std::filesystem::path& path);
+
+    static constexpr std::chrono::milliseconds pollInterval{ 500 };
+
+   private:
+    struct Entry {
+        std::uint64_t version = 0;
+        std::filesystem::file_time_type write_time;
+        std::chrono::steady_clock::time_point checked;
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> files_;
+
+#ifdef __linux__
+    void watch_directory(const std::filesystem::path& directory);
+    void run();
+
+    int fd_ = -1;
+    std::unordered_map<int, std::filesystem::path> directories_;
+    std::atomic<bool> stop_ = false;
+    std::thread thread_;
+#endif
+};
+
+// Watches the shader sources of ShaderDesc.
+extern FileWatcher shader_file_watcher;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,16 @@
+#pragma once
+#include <functional>
+
+#include "USTC_CG.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// GL objects kept in globals, such as the caches of the render nodes, cannot be freed by their
+// destructors: static destruction runs after the GL context is gone. Their owners register a
+// release function instead, which the render delegate runs on teardown with its context current.
+//
+// Registering is meant for static initialization, release_gl_objects() for the GL thread.
+bool register_gl_release(std::function<void()> release);
+void release_gl_objects();
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,7 +1,10 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "USTC_CG.h"
 #include "pxr/base/gf/matrix2f.h"
@@ -13,15 +16,26 @@
 #include "pxr/imaging/garch/glApi.h"
 USTC_CG_NAMESPACE_OPEN_SCOPE
 
+// Linked programs are cached on disk with glGetProgramBinary, keyed by the source and the driver.
+// On a cache miss the program links in the background when GL_KHR_parallel_shader_compile is
+// available; until then use() binds the fallback program (or one that draws nothing) and the
+// uniform setters target it.
 class Shader {
    public:
     unsigned int ID;
     // constructor generates the shader on the fly
 
-    Shader(const char *vertexPath, const char *fragmentPath);
+    Shader(const char *vertexPath, const char *fragmentPath, const Shader *fallback = nullptr);
+    // Compute program.
+    explicit Shader(const char *computePath, const Shader *fallback = nullptr);
+    ~Shader();
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
     // activate the shader
 
     void use() const;
+    // Whether linking finished, successfully or not.
+    bool ready() const;
     // utility uniform functions
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
@@ -38,15 +52,30 @@ class Shader {
 
     std::string get_error()
     {
+        ready();
         return error_string;
     }
 
 private:
-    std::string error_string;
-    std::ostringstream error_stream;
+    // ID once ready, the fallback before.
+    GLuint program() const;
+    void build(const std::vector<std::pair<GLenum, std::string>> &sources, const Shader *fallback);
+    void finishLink() const;
+    bool loadBinary();
+    void saveBinary() const;
+
+    mutable bool is_ready = false;
+    mutable bool is_linked = false;
+    // (type, shader) compiled but not yet checked.
+    mutable std::vector<std::pair<GLenum, GLuint>> stages;
+    GLuint fallback_program = 0;
+    std::uint64_t cache_key = 0;
+
+    mutable std::string error_string;
+    mutable std::ostringstream error_stream;
 
     // utility function for checking shader compilation/linking errors.
 
-    void checkCompileErrors(GLuint shader, std::string type);
+    void checkCompileErrors(GLuint shader, std::string type) const;
 };
 USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,106 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/work/dispatcher.h"
+#include "pxr/imaging/garch/glApi.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Pixels of a texture level 0, bottom row first as GL returns them.
+struct ReadbackImage {
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    std::vector<unsigned char> pixels;
+};
+
+using ReadbackCallback = std::function<void(ReadbackImage&)>;
+
+// Copies textures to the CPU without stalling the pipeline. A request issues a glReadPixels into
+// a pixel pack buffer; update() maps the buffer once its fence signals, at the latest
+// frameLatency frames later, and hands the pixels over. Pack buffers are recycled between
+// requests of the same size.
+//
+// Everything except the futures and the file writes runs on the GL thread.
+class TextureReadback {
+   public:
+    // Frames after which a readback is completed even if the GPU has not caught up, waiting on
+    // its fence.
+    static constexpr int frameLatency = 3;
+
+    // The callback runs from a later update(). Depth textures are read with GL_DEPTH_COMPONENT.
+    void request(
+        GLuint texture,
+        int width,
+        int height,
+        GLenum format,
+        GLenum type,
+        ReadbackCallback callback);
+    // Do not wait on the future from the GL thread: it is fulfilled by update() or flush().
+    std::future<ReadbackImage> request(
+        GLuint texture,
+        int width,
+        int height,
+        GLenum format = GL_RGBA,
+        GLenum type = GL_UNSIGNED_BYTE);
+
+    // Reads the texture back and encodes it to path with HioImage on a worker thread. .exr and
+    // .hdr files are written as float, other formats as 8 bits.
+    void request_to_file(GLuint texture, int width, int height, const std::string& path);
+
+    // Completes the readbacks whose copy has landed. Call once per frame.
+    void update();
+
+    // Completes every pending readback, waiting for the GPU.
+    void flush();
+
+    // Flushes, waits for the file writes and frees the pack buffers. Call before the GL context
+    // goes away.
+    void release();
+
+    size_t pending() const
+    {
+        return pending_.size();
+    }
+
+   private:
+    struct PackBuffer {
+        GLuint buffer;
+        size_t size;
+    };
+
+    struct Pending {
+        PackBuffer pack;
+        GLsync fence;
+        int frame;
+        ReadbackImage image;
+        ReadbackCallback callback;
+    };
+
+    // Unused pack buffers kept for later requests.
+    static constexpr size_t maxFreeBuffers = 8;
+
+    PackBuffer acquire_buffer(size_t size);
+    void complete(Pending& pending);
+
+    GLuint framebuffer_ = 0;
+    int frame_ = 0;
+    std::deque<Pending> pending_;
+    std::vector<PackBuffer> free_buffers_;
+
+    pxr::WorkDispatcher writers_;
+};
+
+extern TextureReadback texture_readback;
+
+// The pattern with its first run of '#' replaced by the frame number, padded with zeros to the
+// length of the run, e.g. "frame_####.png" to "frame_0042.png". Without '#' it is unchanged.
+std::string frame_file_path(const std::string& pattern, int frame);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
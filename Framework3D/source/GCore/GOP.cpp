@@ -1,9 +1,20 @@
 #include "GCore/GOP.h"
 
+#include <atomic>
+
 #include "GCore/Components.h"
 #include "pxr/usd/usdGeom/xform.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
+#ifndef NDEBUG
+static std::atomic<size_t> component_clone_counter = 0;
+
+size_t GOperandBase::component_clone_count()
+{
+    return component_clone_counter;
+}
+#endif
+
 GOperandBase::GOperandBase(const GOperandBase& operand)
 {
     *(this) = operand;
@@ -16,8 +27,12 @@ GOperandBase::GOperandBase(GOperandBase&& operand) noexcept
 
 GOperandBase& GOperandBase::operator=(const GOperandBase& operand)
 {
-    for (auto&& operand_component : operand.components_) {
-        this->components_.push_back(operand_component->copy(this));
+    if (this != &operand) {
+        for (auto&& operand_component : operand.components_) {
+            operand_component->shared = true;
+        }
+        components_ = operand.components_;
+        component_index_ = operand.component_index_;
     }
 
     return *this;
@@ -26,6 +41,7 @@ GOperandBase& GOperandBase::operator=(const GOperandBase& operand)
 GOperandBase& GOperandBase::operator=(GOperandBase&& operand) noexcept
 {
     this->components_ = std::move(operand.components_);
+    this->component_index_ = std::move(operand.component_index_);
     //this->stage = operand.stage;
     //operand.stage.Reset();
 
@@ -35,8 +51,8 @@ GOperandBase& GOperandBase::operator=(GOperandBase&& operand) noexcept
 void GOperandBase::copy_to(GOperandBaseHandle handle)
 {
     for (auto&& component : components_) {
-        auto cp_component = component->copy(handle.get());
-        handle->attach_component(cp_component);
+        component->shared = true;
+        handle->add_component(component);
     }
 
     //handle->stage = stage;
@@ -62,13 +78,48 @@ void GOperandBase::attach_component(const GOperandComponentHandle& component)
             "know what you are doing",
             Warning);
     }
-    components_.push_back(component);
+    add_component(component);
 }
 
 void GOperandBase::detach_component(const GOperandComponentHandle& component)
 {
     auto iter = std::find(components_.begin(), components_.end(), component);
     components_.erase(iter);
+    rebuild_component_index();
+}
+
+ptrdiff_t GOperandBase::find_component(const std::type_info& type, size_t idx) const
+{
+    auto found = component_index_.find(type);
+    if (found == component_index_.end() || idx >= found->second.size()) {
+        return -1;
+    }
+    return found->second[idx];
+}
+
+void GOperandBase::unshare_component(size_t position)
+{
+    auto& component = components_[position];
+    if (component->shared) {
+        component = component->copy(this);
+#ifndef NDEBUG
+        component_clone_counter++;
+#endif
+    }
+}
+
+void GOperandBase::add_component(const GOperandComponentHandle& component)
+{
+    component_index_[typeid(*component)].push_back(components_.size());
+    components_.push_back(component);
+}
+
+void GOperandBase::rebuild_component_index()
+{
+    component_index_.clear();
+    for (size_t i = 0; i < components_.size(); ++i) {
+        component_index_[typeid(*components_[i])].push_back(i);
+    }
 }
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,165 @@
+#include "GCore/HalfEdgeTopology.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Stable LSD radix sort of the keys, carrying the values along, on the bytes at the given shifts.
+// Each pass counts the digits of blocks of keys in parallel, then scatters the blocks in parallel
+// to the offsets the counts give them.
+static void radix_sort(
+    std::vector<uint64_t>& keys,
+    std::vector<int>& values,
+    const std::vector<int>& shifts)
+{
+    constexpr size_t block_size = 1 << 16;
+    const size_t count = keys.size();
+    const size_t block_count = (count + block_size - 1) / block_size;
+
+    std::vector<uint64_t> sorted_keys(count);
+    std::vector<int> sorted_values(count);
+    std::vector<std::array<size_t, 256>> offsets(block_count);
+
+    for (int shift : shifts) {
+        pxr::WorkParallelForN(block_count, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                auto& histogram = offsets[block];
+                histogram.fill(0);
+                size_t last = std::min(count, (block + 1) * block_size);
+                for (size_t i = block * block_size; i < last; ++i) {
+                    ++histogram[(keys[i] >> shift) & 0xff];
+                }
+            }
+        });
+
+        size_t total = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (size_t block = 0; block < block_count; ++block) {
+                size_t digit_count = offsets[block][digit];
+                offsets[block][digit] = total;
+                total += digit_count;
+            }
+        }
+
+        pxr::WorkParallelForN(block_count, [&](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; ++block) {
+                auto& position = offsets[block];
+                size_t last = std::min(count, (block + 1) * block_size);
+                for (size_t i = block * block_size; i < last; ++i) {
+                    size_t target = position[(keys[i] >> shift) & 0xff]++;
+                    sorted_keys[target] = keys[i];
+                    sorted_values[target] = values[i];
+                }
+            }
+        });
+
+        keys.swap(sorted_keys);
+        values.swap(sorted_values);
+    }
+}
+
+HalfEdgeTopology::HalfEdgeTopology(
+    const pxr::VtArray<int>& faceVertexCounts,
+    const pxr::VtArray<int>& faceVertexIndices,
+    size_t vertex_count)
+    : face_vertex_indices(faceVertexIndices)
+{
+    const size_t face_count = faceVertexCounts.size();
+    const size_t half_edge_count = faceVertexIndices.size();
+    const int* counts = faceVertexCounts.cdata();
+    const int* indices = faceVertexIndices.cdata();
+
+    face_half_edge.resize(face_count + 1);
+    face_half_edge[0] = 0;
+    for (size_t f = 0; f < face_count; ++f) {
+        face_half_edge[f + 1] = face_half_edge[f] + counts[f];
+    }
+    if (static_cast<size_t>(face_half_edge.back()) != half_edge_count) {
+        throw std::runtime_error("Face vertex counts do not add up to the face vertex indices.");
+    }
+
+    next.resize(half_edge_count);
+    prev.resize(half_edge_count);
+    face.resize(half_edge_count);
+    edge.resize(half_edge_count);
+    opposite.assign(half_edge_count, -1);
+
+    // An edge key holds the smaller vertex index in its high half.
+    std::vector<uint64_t> keys(half_edge_count);
+    std::vector<int> half_edges(half_edge_count);
+    std::atomic<bool> out_of_range = false;
+
+    pxr::WorkParallelForN(face_count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const int first = face_half_edge[f];
+            const int last = face_half_edge[f + 1];
+            for (int h = first; h < last; ++h) {
+                const int n = h + 1 == last ? first : h + 1;
+                next[h] = n;
+                prev[h] = h == first ? last - 1 : h - 1;
+                face[h] = static_cast<int>(f);
+
+                const uint64_t a = static_cast<unsigned>(indices[h]);
+                const uint64_t b = static_cast<unsigned>(indices[n]);
+                if (a >= vertex_count || b >= vertex_count) {
+                    out_of_range = true;
+                }
+                keys[h] = a < b ? (a << 32 | b) : (b << 32 | a);
+                half_edges[h] = h;
+            }
+        }
+    });
+    if (out_of_range) {
+        throw std::runtime_error("Face vertex index out of range.");
+    }
+
+    // Only the bytes that can hold a vertex index are sorted on.
+    std::vector<int> shifts;
+    for (int shift = 0; shift < 32 && (uint64_t(1) << shift) < vertex_count; shift += 8) {
+        shifts.push_back(shift);
+    }
+    for (size_t i = 0, low_byte_count = shifts.size(); i < low_byte_count; ++i) {
+        shifts.push_back(shifts[i] + 32);
+    }
+    radix_sort(keys, half_edges, shifts);
+
+    // Runs of equal keys are the edges.
+    edge_half_edge.reserve(half_edge_count / 2 + 1);
+    for (size_t i = 0; i < half_edge_count;) {
+        size_t j = i + 1;
+        while (j < half_edge_count && keys[j] == keys[i]) {
+            ++j;
+        }
+
+        const int e = static_cast<int>(edge_half_edge.size());
+        edge_half_edge.push_back(half_edges[i]);
+        for (size_t k = i; k < j; ++k) {
+            edge[half_edges[k]] = e;
+        }
+
+        if (j - i == 2 && indices[half_edges[i]] != indices[half_edges[i + 1]]) {
+            opposite[half_edges[i]] = half_edges[i + 1];
+            opposite[half_edges[i + 1]] = half_edges[i];
+        }
+        else if (j - i >= 2) {
+            ++non_manifold_edges;
+        }
+        i = j;
+    }
+
+    // Boundary half-edges come first in the fans of for_each_outgoing.
+    vertex_half_edge.assign(vertex_count, -1);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        int& outgoing = vertex_half_edge[indices[h]];
+        if (outgoing < 0 || opposite[h] < 0) {
+            outgoing = static_cast<int>(h);
+        }
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -15,6 +15,32 @@ std::string MeshComponent::to_string() const
     return out.str();
 }
 
+std::shared_ptr<const HalfEdgeTopology> MeshComponent::half_edge_topology() const
+{
+    std::lock_guard lock(topology_mutex_);
+    bool current = topology_ &&
+                   topology_face_vertex_counts_.cdata() == faceVertexCounts.cdata() &&
+                   topology_face_vertex_counts_.size() == faceVertexCounts.size() &&
+                   topology_->face_vertex_indices.cdata() == faceVertexIndices.cdata() &&
+                   topology_->face_vertex_indices.size() == faceVertexIndices.size() &&
+                   topology_->n_vertices() == vertices.size();
+    if (!current) {
+        topology_ = std::make_shared<HalfEdgeTopology>(
+            faceVertexCounts, faceVertexIndices, vertices.size());
+        topology_face_vertex_counts_ = faceVertexCounts;
+    }
+    return topology_;
+}
+
+std::shared_ptr<const Triangulation> MeshComponent::triangulation() const
+{
+    std::lock_guard lock(topology_mutex_);
+    if (!triangulation_ || !triangulation_->is_for(faceVertexCounts, faceVertexIndices, vertices)) {
+        triangulation_ = Triangulation::get(faceVertexCounts, faceVertexIndices, vertices);
+    }
+    return triangulation_;
+}
+
 GOperandComponentHandle MeshComponent::copy(GOperandBase* operand) const
 {
     auto ret = std::make_shared<MeshComponent>(operand);
@@ -26,6 +52,11 @@ GOperandComponentHandle MeshComponent::copy(GOperandBase* operand) const
     ret->texcoordsArray = this->texcoordsArray;
     ret->normals = this->normals;
     ret->displayColor = this->displayColor;
+
+    std::lock_guard lock(topology_mutex_);
+    ret->topology_ = topology_;
+    ret->topology_face_vertex_counts_ = topology_face_vertex_counts_;
+    ret->triangulation_ = triangulation_;
     return ret;
 }
 
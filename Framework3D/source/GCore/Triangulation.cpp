@@ -0,0 +1,289 @@
+#include "GCore/Triangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+
+#include "pxr/base/gf/vec2d.h"
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static double cross(const pxr::GfVec2d& a, const pxr::GfVec2d& b)
+{
+    return a[0] * b[1] - a[1] * b[0];
+}
+
+// Whether p is in the triangle abc, counterclockwise, or on its border.
+static bool in_triangle(
+    const pxr::GfVec2d& p,
+    const pxr::GfVec2d& a,
+    const pxr::GfVec2d& b,
+    const pxr::GfVec2d& c)
+{
+    return cross(b - a, p - a) >= 0 && cross(c - b, p - b) >= 0 && cross(a - c, p - c) >= 0;
+}
+
+namespace {
+
+// Triangulates one face at a time into the given triangles, reusing its buffers.
+class FaceTriangulator {
+   public:
+    FaceTriangulator(const int* indices, const pxr::VtArray<pxr::GfVec3f>& points)
+        : indices_(indices),
+          points_(points)
+    {
+    }
+
+    // Writes count - 2 triangles of face corners, starting at first_corner, to triangles.
+    void triangulate(int first_corner, int count, int* triangles)
+    {
+        corner_ = first_corner;
+        triangles_ = triangles;
+        if (count == 3) {
+            emit(0, 1, 2);
+        }
+        else if (!project(count)) {
+            fan(count);
+        }
+        else if (count == 4) {
+            // The diagonal has to go through the reflex corner, if there is one.
+            auto reflex = [&](int k) {
+                const auto& p = planar_[k];
+                return cross(p - planar_[(k + 3) % 4], planar_[(k + 1) % 4] - p) < 0;
+            };
+            if (reflex(1) || reflex(3)) {
+                emit(0, 1, 3);
+                emit(1, 2, 3);
+            }
+            else {
+                emit(0, 1, 2);
+                emit(0, 2, 3);
+            }
+        }
+        else {
+            clip_ears(count);
+        }
+    }
+
+   private:
+    void emit(int a, int b, int c)
+    {
+        *triangles_++ = corner_ + a;
+        *triangles_++ = corner_ + b;
+        *triangles_++ = corner_ + c;
+    }
+
+    void fan(int count)
+    {
+        for (int k = 1; k + 1 < count; ++k) {
+            emit(0, k, k + 1);
+        }
+    }
+
+    // Projects the face to the coordinate plane closest to its plane, turning it counterclockwise.
+    // False if the face has no area or points out of range.
+    bool project(int count)
+    {
+        pxr::GfVec3d normal(0);
+        for (int k = 0; k < count; ++k) {
+            const int a = indices_[corner_ + k], b = indices_[corner_ + (k + 1) % count];
+            const int point_count = static_cast<int>(points_.size());
+            if (a < 0 || b < 0 || a >= point_count || b >= point_count) {
+                return false;
+            }
+            normal += pxr::GfCross(pxr::GfVec3d(points_[a]), pxr::GfVec3d(points_[b]));
+        }
+
+        int axis = 0;
+        for (int d = 1; d < 3; ++d) {
+            if (std::abs(normal[d]) > std::abs(normal[axis])) {
+                axis = d;
+            }
+        }
+        if (normal[axis] == 0) {
+            return false;
+        }
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        if (normal[axis] < 0) {
+            std::swap(u, v);
+        }
+
+        planar_.resize(count);
+        for (int k = 0; k < count; ++k) {
+            const auto& p = points_[indices_[corner_ + k]];
+            planar_[k] = pxr::GfVec2d(p[u], p[v]);
+        }
+        return true;
+    }
+
+    void clip_ears(int count)
+    {
+        next_.resize(count);
+        prev_.resize(count);
+        for (int k = 0; k < count; ++k) {
+            next_[k] = (k + 1) % count;
+            prev_[k] = (k + count - 1) % count;
+        }
+
+        int remaining = count;
+        int k = 0;
+        for (int misses = 0; remaining > 3;) {
+            // After a whole loop without an ear, the face is not simple: clip anyway.
+            if (is_ear(k) || misses > remaining) {
+                emit(prev_[k], k, next_[k]);
+                next_[prev_[k]] = next_[k];
+                prev_[next_[k]] = prev_[k];
+                k = next_[k];
+                --remaining;
+                misses = 0;
+            }
+            else {
+                k = next_[k];
+                ++misses;
+            }
+        }
+        emit(prev_[k], k, next_[k]);
+    }
+
+    bool is_ear(int k) const
+    {
+        const int a = prev_[k], c = next_[k];
+        const auto &pa = planar_[a], &pb = planar_[k], &pc = planar_[c];
+        if (cross(pb - pa, pc - pb) <= 0) {
+            return false;
+        }
+        for (int j = next_[c]; j != a; j = next_[j]) {
+            const auto& p = planar_[j];
+            // Corners repeated at the ear's corners, as where a face touches itself, do not block.
+            if (p != pa && p != pb && p != pc && in_triangle(p, pa, pb, pc)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const int* indices_;
+    const pxr::VtArray<pxr::GfVec3f>& points_;
+    int corner_ = 0;
+    int* triangles_ = nullptr;
+
+    std::vector<pxr::GfVec2d> planar_;
+    std::vector<int> next_;
+    std::vector<int> prev_;
+};
+
+}  // namespace
+
+Triangulation::Triangulation(
+    const pxr::VtArray<int>& faceVertexCounts,
+    const pxr::VtArray<int>& faceVertexIndices,
+    const pxr::VtArray<pxr::GfVec3f>& points)
+    : face_vertex_counts_(faceVertexCounts),
+      face_vertex_indices_(faceVertexIndices),
+      points_(points)
+{
+    const size_t face_count = faceVertexCounts.size();
+    const int* counts = faceVertexCounts.cdata();
+    const int* indices = faceVertexIndices.cdata();
+
+    std::vector<int> face_corners(face_count + 1, 0);
+    face_triangles.assign(face_count + 1, 0);
+    for (size_t f = 0; f < face_count; ++f) {
+        face_corners[f + 1] = face_corners[f] + std::max(counts[f], 0);
+        face_triangles[f + 1] = face_triangles[f] + std::max(counts[f] - 2, 0);
+        uses_points_ = uses_points_ || counts[f] > 3;
+    }
+    if (static_cast<size_t>(face_corners.back()) != faceVertexIndices.size()) {
+        throw std::runtime_error("Face vertex counts do not add up to the face vertex indices.");
+    }
+
+    const size_t triangle_count = face_triangles.back();
+    triangle_corners.resize(3 * triangle_count);
+    triangle_vertices.resize(3 * triangle_count);
+    triangle_faces.resize(triangle_count);
+    int* corners = triangle_corners.data();
+    int* vertices = triangle_vertices.data();
+    int* faces = triangle_faces.data();
+
+    pxr::WorkParallelForN(face_count, [&](size_t begin, size_t end) {
+        FaceTriangulator triangulator(indices, points);
+        for (size_t f = begin; f < end; ++f) {
+            const int first = face_triangles[f], last = face_triangles[f + 1];
+            if (first == last) {
+                continue;
+            }
+            triangulator.triangulate(face_corners[f], counts[f], corners + 3 * first);
+            for (int t = first; t < last; ++t) {
+                faces[t] = static_cast<int>(f);
+                for (int k = 3 * t; k < 3 * t + 3; ++k) {
+                    vertices[k] = indices[corners[k]];
+                }
+            }
+        }
+    });
+
+    if (!uses_points_) {
+        points_ = {};
+    }
+}
+
+bool Triangulation::is_for(
+    const pxr::VtArray<int>& faceVertexCounts,
+    const pxr::VtArray<int>& faceVertexIndices,
+    const pxr::VtArray<pxr::GfVec3f>& points) const
+{
+    return face_vertex_counts_.IsIdentical(faceVertexCounts) &&
+           face_vertex_indices_.IsIdentical(faceVertexIndices) &&
+           (!uses_points_ || points_.IsIdentical(points));
+}
+
+// The triangulations of the meshes in use, a few of them.
+struct TriangulationCache {
+    static constexpr size_t capacity = 8;
+
+    std::mutex mutex;
+    std::vector<std::pair<std::shared_ptr<const Triangulation>, size_t>> entries;
+    size_t use_counter = 0;
+
+    static TriangulationCache& instance()
+    {
+        static TriangulationCache cache;
+        return cache;
+    }
+};
+
+std::shared_ptr<const Triangulation> Triangulation::get(
+    const pxr::VtArray<int>& faceVertexCounts,
+    const pxr::VtArray<int>& faceVertexIndices,
+    const pxr::VtArray<pxr::GfVec3f>& points)
+{
+    auto& cache = TriangulationCache::instance();
+    {
+        std::lock_guard lock(cache.mutex);
+        for (auto& [triangulation, last_used] : cache.entries) {
+            if (triangulation->is_for(faceVertexCounts, faceVertexIndices, points)) {
+                last_used = ++cache.use_counter;
+                return triangulation;
+            }
+        }
+    }
+
+    auto triangulation =
+        std::make_shared<const Triangulation>(faceVertexCounts, faceVertexIndices, points);
+
+    std::lock_guard lock(cache.mutex);
+    cache.entries.emplace_back(triangulation, ++cache.use_counter);
+    if (cache.entries.size() > TriangulationCache::capacity) {
+        auto oldest = std::min_element(
+            cache.entries.begin(), cache.entries.end(), [](const auto& a, const auto& b) {
+                return a.second < b.second;
+            });
+        cache.entries.erase(oldest);
+    }
+    return triangulation;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,13 +1,51 @@
 #include "GCore/Components/VolumeComponent.h"
 
+#include <sstream>
+
 USTC_CG_NAMESPACE_OPEN_SCOPE
-GOperandComponentHandle VolumeComponet::copy(GOperandBase* operand) const
+VolumeComponent::VolumeComponent(GOperandBase* attached_operand)
+    : GOperandComponent(attached_operand)
+{
+    // Registers the grid types, it does nothing after the first call.
+    openvdb::initialize();
+}
+
+GOperandComponentHandle VolumeComponent::copy(GOperandBase* operand) const
+{
+    auto ret = std::make_shared<VolumeComponent>(operand);
+
+    // The grids are shared, writable_grid copies them on write
+    ret->grids_ = this->grids_;
+    return ret;
+}
+
+std::string VolumeComponent::to_string() const
+{
+    std::ostringstream out;
+    out << "Volume component.";
+    for (auto& [name, grid] : grids_) {
+        out << " Grid " << name << " (" << grid->valueType() << "), active voxels "
+            << grid->activeVoxelCount() << ", voxel size " << grid->voxelSize()[0] << ".";
+    }
+    return out.str();
+}
+
+void VolumeComponent::set_grid(const std::string& name, openvdb::GridBase::Ptr grid)
+{
+    grids_[name] = std::move(grid);
+}
+
+void VolumeComponent::remove_grid(const std::string& name)
 {
-    return {};
+    grids_.erase(name);
 }
 
-std::string VolumeComponet::to_string() const
+std::vector<std::string> VolumeComponent::grid_names() const
 {
-    return std::string(typeid(decltype(*this)).name());
+    std::vector<std::string> names;
+    for (auto& [name, grid] : grids_) {
+        names.push_back(name);
+    }
+    return names;
 }
 USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -2,11 +2,17 @@
 
 #include <imgui_internal.h>
 
+#include <chrono>
+
 #include "Nodes/GlobalUsdStage.h"
 #include "Nodes/node_exec_eager.hpp"
 #include "Nodes/node_register.h"
 #include "Nodes/node_tree.hpp"
 #include "imgui/imgui-node-editor/imgui_node_editor.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/sdf/schema.h"
 #include "pxr/usd/usdGeom/metrics.h"
 #include "pxr/usd/usdGeom/tokens.h"
 USTC_CG_NAMESPACE_OPEN_SCOPE
@@ -90,6 +96,18 @@ void NodeSystemExecution::show_debug_info()
     {
         ImGui::Text("This graph doesn't have a cycle");
     }
+
+    auto eager_executor = dynamic_cast<EagerNodeTreeExecutor*>(executor.get());
+    if (eager_executor && eager_executor->output_cache()) {
+        auto& statistics = eager_executor->output_cache()->statistics();
+        ImGui::Text("Output cache hits: %zu", statistics.hits);
+        ImGui::Text("Output cache recomputes: %zu", statistics.recomputes);
+        ImGui::Text("Output cache evictions: %zu", statistics.evictions);
+        ImGui::Text("Output cache size: %.1f MB", statistics.bytes / (1024.0 * 1024.0));
+    }
+#ifndef NDEBUG
+    ImGui::Text("Geometry component clones: %zu", GOperandBase::component_clone_count());
+#endif
 }
 
 unsigned NodeSystemExecution::GetNextId()
@@ -151,10 +169,49 @@ Node* NodeSystemExecution::default_node_menu(const std::map<std::string, NodeTyp
     return node;
 }
 
+// Override with USTC_CG_NODE_CACHE_BUDGET_MB.
+static size_t node_cache_budget()
+{
+    size_t megabytes = 1024;
+    if (auto budget = std::getenv("USTC_CG_NODE_CACHE_BUDGET_MB")) {
+        megabytes = std::strtoull(budget, nullptr, 10);
+    }
+    return megabytes << 20;
+}
+
+// Override with USTC_CG_FRAME_CACHE_BUDGET_MB. Frames beyond it go to USTC_CG_FRAME_CACHE_DIR, or
+// to the temporary directory.
+static size_t frame_cache_budget()
+{
+    size_t megabytes = 2048;
+    if (auto budget = std::getenv("USTC_CG_FRAME_CACHE_BUDGET_MB")) {
+        megabytes = std::strtoull(budget, nullptr, 10);
+    }
+    return megabytes << 20;
+}
+
+static std::filesystem::path frame_cache_directory()
+{
+    std::filesystem::path directory;
+    if (auto path = std::getenv("USTC_CG_FRAME_CACHE_DIR")) {
+        directory = path;
+    }
+    else {
+        std::error_code error;
+        directory = std::filesystem::temp_directory_path(error) / "USTC_CG";
+    }
+    auto session = std::chrono::system_clock::now().time_since_epoch().count();
+    return directory / ("frames_" + std::to_string(session));
+}
+
 GeoNodeSystemExecution::GeoNodeSystemExecution()
 {
     NodeSystemExecution();
-    executor = CreateEagerNodeTreeExecutorSimulation();
+    auto eager_executor = CreateEagerNodeTreeExecutorSimulation();
+    eager_executor->enable_output_cache(node_cache_budget());
+    executor = std::move(eager_executor);
+    frame_cache_ = std::make_unique<SimulationFrameCache>(
+        pxr::SdfPath("/geom"), frame_cache_budget(), frame_cache_directory());
 }
 
 float GeoNodeSystemExecution::cached_last_frame() const
@@ -169,6 +226,8 @@ void GeoNodeSystemExecution::MarkDirty()
     cached_last_frame_ = 0;
     time_code_to_render_ = 0;
     just_renewed = true;
+    frame_cache_->clear();
+    GlobalUsdStage::simulation_stopped();
 }
 
 void GeoNodeSystemExecution::set_required_time_code(float time_code_to_render)
@@ -180,68 +239,163 @@ void GeoNodeSystemExecution::set_required_time_code(float time_code_to_render)
     just_renewed = false;
 }
 
-// This is NOT best practice.
-void GeoNodeSystemExecution::try_execution()
+void GeoNodeSystemExecution::bake(float end_time_code)
 {
-    if (required_execution) {
-        auto& stage = GlobalUsdStage::global_usd_stage;
-        stage->RemovePrim(pxr::SdfPath("/geom"));
-        stage->RemovePrim(pxr::SdfPath("/TexModel"));
+    while (cached_last_frame_ < end_time_code || required_execution) {
+        float last_frame = cached_last_frame_;
+        simulate_frame();
+        if (cached_last_frame_ <= last_frame) {
+            break;  // The tree does not advance in time.
+        }
     }
+    GlobalUsdStage::simulation_stopped();
+}
 
+void GeoNodeSystemExecution::try_execution()
+{
     if (cached_last_frame_ < time_code_to_render_ || required_execution) {
-        executor->prepare_tree(node_tree.get());
-
-        for (auto&& node : node_tree->nodes) {
-            auto try_fill_info = [&node, this](const char* id_name, void* data) {
-                if (std::string(node->typeinfo->id_name) == id_name) {
-                    assert(node->outputs.size() == 1);
-                    auto output_socket = node->outputs[0];
-                    executor->sync_node_from_external_storage(output_socket, data);
-                }
-            };
-            try_fill_info("geom_time_code", &cached_last_frame_);
+        simulate_frame();
+    }
+    else {
+        // Back on the timeline, the simulation state stays at the last frame.
+        frame_cache_->restore(time_code_to_render_, GlobalUsdStage::global_usd_stage);
+    }
+}
+
+void GeoNodeSystemExecution::show_debug_info()
+{
+    NodeSystemExecution::show_debug_info();
+
+    auto& statistics = frame_cache_->statistics();
+    ImGui::Text("Cached frames: %zu (%zu on disk)", statistics.frames, statistics.frames_on_disk);
+    ImGui::Text("Frame cache size: %.1f MB", statistics.bytes / (1024.0 * 1024.0));
+}
+
+static const pxr::SdfPath geometry_roots[] = { pxr::SdfPath("/geom"), pxr::SdfPath("/TexModel") };
+
+// Collects the prims under spec that are neither written, below a written prim, nor above one.
+static void collect_unwritten_prims(
+    const pxr::SdfPrimSpecHandle& spec,
+    std::vector<pxr::SdfPrimSpecHandle>& unwritten)
+{
+    bool above_written = false;
+    for (auto& written : GlobalUsdStage::written_prims) {
+        if (spec->GetPath().HasPrefix(written)) {
+            return;
         }
+        above_written |= written.HasPrefix(spec->GetPath());
+    }
+    if (!above_written) {
+        unwritten.push_back(spec);
+        return;
+    }
+    for (auto& child : spec->GetNameChildren()) {
+        collect_unwritten_prims(child, unwritten);
+    }
+}
 
-        executor->execute_tree(node_tree.get());
+static void remove_unwritten_prims(const pxr::SdfLayerHandle& layer)
+{
+    std::vector<pxr::SdfPrimSpecHandle> unwritten;
+    for (auto& root : geometry_roots) {
+        if (auto spec = layer->GetPrimAtPath(root)) {
+            collect_unwritten_prims(spec, unwritten);
+        }
+    }
 
-        float time_advected = 0;
+    pxr::SdfChangeBlock change_block;
+    for (auto& spec : unwritten) {
+        spec->GetRealNameParent()->RemoveNameChild(spec);
+    }
+}
 
-        bool has_time_advection = false;
+// The samples of an earlier run would show between the frames of the new one.
+static void erase_time_samples(const pxr::SdfLayerHandle& layer)
+{
+    std::vector<pxr::SdfPath> sampled;
+    for (auto& root : geometry_roots) {
+        if (!layer->GetPrimAtPath(root)) {
+            continue;
+        }
+        layer->Traverse(root, [&](const pxr::SdfPath& path) {
+            if (path.IsPropertyPath() && layer->GetNumTimeSamplesForPath(path) > 0) {
+                sampled.push_back(path);
+            }
+        });
+    }
 
-        for (auto&& node : node_tree->nodes) {
-            auto try_fetch_info = [&node, this](const char* id_name, void* data) {
-                if (std::string(node->typeinfo->id_name) == id_name) {
-                    assert(node->inputs.size() == 1);
-                    auto output_socket = node->inputs[0];
-                    executor->sync_node_to_external_storage(output_socket, data);
-                    return true;
-                }
-                return false;
-            };
+    pxr::SdfChangeBlock change_block;
+    for (auto& path : sampled) {
+        layer->EraseField(path, pxr::SdfFieldKeys->TimeSamples);
+    }
+}
 
-            if (try_fetch_info("geom_time_gain", &time_advected)) {
-                has_time_advection = true;
-                break;
+// This is NOT best practice.
+void GeoNodeSystemExecution::simulate_frame()
+{
+    // The prims are kept and written over, so the viewport only updates what changed.
+    auto layer = GlobalUsdStage::global_usd_stage->GetRootLayer();
+    if (required_execution) {
+        erase_time_samples(layer);
+    }
+    GlobalUsdStage::written_prims.clear();
+
+    float frame_time_code = cached_last_frame_;
+
+    executor->prepare_tree(node_tree.get());
+
+    for (auto&& node : node_tree->nodes) {
+        auto try_fill_info = [&node, this](const char* id_name, void* data) {
+            if (std::string(node->typeinfo->id_name) == id_name) {
+                assert(node->outputs.size() == 1);
+                auto output_socket = node->outputs[0];
+                executor->sync_node_from_external_storage(output_socket, data);
             }
-        }
+        };
+        try_fill_info("geom_time_code", &cached_last_frame_);
+    }
+
+    executor->execute_tree(node_tree.get());
+    remove_unwritten_prims(layer);
+
+    float time_advected = 0;
+
+    bool has_time_advection = false;
 
-        if (has_time_advection) {
-            if (cached_last_frame_ == 0) {  // Means this is the first frame.
-                cached_last_frame_ = std::numeric_limits<float>::epsilon();
-                time_code_to_render_ = cached_last_frame_;  // Avoid repeated running
+    for (auto&& node : node_tree->nodes) {
+        auto try_fetch_info = [&node, this](const char* id_name, void* data) {
+            if (std::string(node->typeinfo->id_name) == id_name) {
+                assert(node->inputs.size() == 1);
+                auto output_socket = node->inputs[0];
+                executor->sync_node_to_external_storage(output_socket, data);
+                return true;
             }
-            else
-                cached_last_frame_ += time_advected * GlobalUsdStage::timeCodesPerSecond;
-        }
-        else {
-            cached_last_frame_ = std::numeric_limits<float>::max();
+            return false;
+        };
+
+        if (try_fetch_info("geom_time_gain", &time_advected)) {
+            has_time_advection = true;
+            break;
         }
+    }
 
-        executor->finalize(node_tree.get());
+    if (has_time_advection) {
+        frame_cache_->store(frame_time_code, GlobalUsdStage::global_usd_stage);
 
-        required_execution = false;
+        if (cached_last_frame_ == 0) {  // Means this is the first frame.
+            cached_last_frame_ = std::numeric_limits<float>::epsilon();
+            time_code_to_render_ = cached_last_frame_;  // Avoid repeated running
+        }
+        else
+            cached_last_frame_ += time_advected * GlobalUsdStage::timeCodesPerSecond;
+    }
+    else {
+        cached_last_frame_ = std::numeric_limits<float>::max();
     }
+
+    executor->finalize(node_tree.get());
+
+    required_execution = false;
 }
 
 Node* GeoNodeSystemExecution::create_node_menu()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Nodes/frame_cache.hpp"
 #include "Nodes/node.hpp"
 #include "Nodes/node_tree.hpp"
 #include "USTC_CG.h"
@@ -12,6 +13,10 @@ class NodeSystemExecution {
     virtual void set_required_time_code(float time_code_to_render)
     {
     }
+    // Runs the tree until end_time_code has been simulated.
+    virtual void bake(float end_time_code)
+    {
+    }
     NodeSystemExecution();
 
     virtual Node* create_node_menu();
@@ -49,7 +54,7 @@ class NodeSystemExecution {
 
     void trigger_refresh_topology();
 
-    void show_debug_info();
+    virtual void show_debug_info();
 
     unsigned GetNextId();
 
@@ -80,11 +85,17 @@ struct GeoNodeSystemExecution : public NodeSystemExecution {
     void MarkDirty() override;
 
     void set_required_time_code(float time_code_to_render) override;
+    void bake(float end_time_code) override;
 
     void try_execution() override;
+    void show_debug_info() override;
     Node* create_node_menu() override;
 
    private:
+    void simulate_frame();
+
+    // Frames of the simulation, for going back on the timeline.
+    std::unique_ptr<SimulationFrameCache> frame_cache_;
     float cached_last_frame_ = 0;
     float time_code_to_render_ = 0;
     bool just_renewed = true;
@@ -128,6 +128,7 @@ struct NodeSystemImpl {
     std::string filename;
 
     bool link_changed = true;
+    float bake_end_time_code = 240;
 
    private:
     ed::EditorContext* m_Editor = nullptr;
@@ -311,6 +312,14 @@ void NodeSystemImpl::OnFrame(float deltaTime)
 
     if (ImGui::Button("Zoom to Content"))
         ed::NavigateToContent();
+    if (node_system_type == NodeSystemType::Geometry) {
+        ImGui::SameLine();
+        if (ImGui::Button("Bake to"))
+            node_system_execution_->bake(bake_end_time_code);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80);
+        ImGui::DragFloat("##Bake end", &bake_end_time_code, 1.0f, 0.0f, 10000.0f, "%.0f");
+    }
     ed::Begin(("Node editor" + filename).c_str());
     {
         auto cursorTopLeft = ImGui::GetCursorScreenPos();
@@ -836,6 +845,11 @@ void NodeSystem::set_required_time_code(float time_code_to_render)
     impl_->node_system_execution_->set_required_time_code(time_code_to_render);
 }
 
+void NodeSystem::bake(float end_time_code)
+{
+    impl_->node_system_execution_->bake(end_time_code);
+}
+
 void NodeSystemImpl::ShowLeftPane(float paneWidth)
 {
     auto& io = ImGui::GetIO();
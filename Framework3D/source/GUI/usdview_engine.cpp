@@ -224,6 +224,9 @@ void UsdviewEngineImpl::time_controller(float delta_time)
 {
     if (is_active_ && ImGui::IsKeyPressed(ImGuiKey_Space)) {
         playing = !playing;
+        if (!playing) {
+            GlobalUsdStage::simulation_stopped();
+        }
     }
     if (playing) {
         timecode += delta_time * GlobalUsdStage::timeCodesPerSecond;
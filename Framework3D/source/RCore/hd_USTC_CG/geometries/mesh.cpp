@@ -127,8 +127,7 @@ void Hd_USTC_CG_Mesh::_CreatePrimvarSampler(
                     " on refined meshes.");
             }
             else {
-                HdMeshUtil meshUtil(&_topology, GetId());
-                sampler = new Hd_USTC_CG_TriangleFaceVaryingSampler(name, data, meshUtil);
+                sampler = new Hd_USTC_CG_TriangleFaceVaryingSampler(name, data, *_triangles);
             }
             break;
         default: TF_CODING_ERROR("Unrecognized interpolation mode"); break;
@@ -388,9 +387,10 @@ RTCGeometry Hd_USTC_CG_Mesh::_CreateEmbreeSubdivMesh(RTCScene scene, RTCDevice d
 
 RTCGeometry Hd_USTC_CG_Mesh::_CreateEmbreeTriangleMesh(RTCScene scene, RTCDevice device)
 {
-    // Triangulate the input faces.
-    HdMeshUtil meshUtil(&_topology, GetId());
-    meshUtil.ComputeTriangleIndices(&_triangulatedIndices, &_trianglePrimitiveParams);
+    // Triangulate the input faces, reusing the triangulation of the nodes for the same arrays.
+    _triangles = std::make_shared<HdTriangles>(_topology, _points, GetId());
+    _triangulatedIndices = _triangles->indices;
+    _trianglePrimitiveParams = _triangles->primitive_params;
 
     // Create the new mesh.
     // geometry will be committed in the calling function
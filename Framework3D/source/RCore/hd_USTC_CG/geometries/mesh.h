@@ -161,6 +161,8 @@ class Hd_USTC_CG_Mesh final : public HdMesh {
     //   adjacent face normals.
     VtVec3iArray _triangulatedIndices;
     VtIntArray _trianglePrimitiveParams;
+    // The face corners of the triangles too, for face-varying primvars.
+    std::shared_ptr<const HdTriangles> _triangles;
 
     // Embree recommends after creating one should hold onto the geometry
     //
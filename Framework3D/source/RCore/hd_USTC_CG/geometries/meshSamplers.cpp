@@ -168,15 +168,10 @@ VtValue
 Hd_USTC_CG_TriangleFaceVaryingSampler::_Triangulate(
     const TfToken& name,
     const VtValue& value,
-    HdMeshUtil& meshUtil)
+    const HdTriangles& triangles)
 {
-    HdVtBufferSource buffer(name, value);
     VtValue triangulated;
-    if (!meshUtil.ComputeTriangulatedFaceVaryingPrimvar(
-        buffer.GetData(),
-        buffer.GetNumElements(),
-        buffer.GetTupleType().type,
-        &triangulated))
+    if (!triangles.triangulate_face_varying(value, &triangulated))
     {
         TF_CODING_ERROR(
             "[%s] Could not triangulate face-varying data.",
@@ -29,6 +29,7 @@
 #include "sampler.h"
 #include "pxr/imaging/hd/meshUtil.h"
 #include "pxr/base/vt/types.h"
+#include "RCore/hd_triangles.hpp"
 
 #include <embree4/rtcore.h>
 
@@ -252,13 +253,13 @@ public:
     /// Constructor. Triangulates the provided buffer data.
     /// \param name The name of the primvar.
     /// \param value The buffer data for the primvar.
-    /// \param meshUtil An HdMeshUtil instance that knows how to triangulate
-    ///                 the input buffer data.
+    /// \param triangles The triangles of the mesh, with the face corner of
+    ///                  each triangle corner.
     Hd_USTC_CG_TriangleFaceVaryingSampler(
         const TfToken& name,
         const VtValue& value,
-        HdMeshUtil& meshUtil)
-        : _buffer(name, _Triangulate(name, value, meshUtil))
+        const HdTriangles& triangles)
+        : _buffer(name, _Triangulate(name, value, triangles))
           , _sampler(_buffer)
     {
     }
@@ -287,15 +288,12 @@ private:
     const HdVtBufferSource _buffer;
     const Hd_USTC_CG_BufferSampler _sampler;
 
-    // Pass the "value" parameter through HdMeshUtils'
-    // ComputeTriangulatedFaceVaryingPrimvar(), which adjusts the primvar
-    // buffer data for the triangulated topology. HdMeshUtil is provided
-    // the source topology at construction time, so this class doesn't need
-    // to provide it.
+    // Gathers the "value" parameter to the triangle corners, in the
+    // triangulation the mesh was built with.
     static VtValue _Triangulate(
         const TfToken& name,
         const VtValue& value,
-        HdMeshUtil& meshUtil);
+        const HdTriangles& triangles);
 };
 
 /// \class Hd_USTC_CG_SubdivVertexSampler
@@ -68,6 +68,16 @@ TF_DEFINE_ENV_SETTING(
     300,
     "Intensity of the camera light, specified as a percentage of <1,1,1>.");
 
+TF_DEFINE_ENV_SETTING(
+    HDEMBREE_TEXTURE_UPLOAD_BUDGET_MB,
+    16,
+    "Megabytes of texture data uploaded per frame (must be >= 1)");
+
+TF_DEFINE_ENV_SETTING(
+    HDEMBREE_FRAME_DUMP_PATH,
+    "",
+    "Files to dump presented frames to, '#' being the frame number (empty disables the dump)");
+
 TF_DEFINE_ENV_SETTING(
     HDEMBREE_PRINT_CONFIGURATION,
     0,
@@ -91,6 +101,10 @@ HdEmbreeConfig::HdEmbreeConfig()
                                 100,
                                 TfGetEnvSetting(
                                     HDEMBREE_CAMERA_LIGHT_INTENSITY)) / 100.0f);
+    textureUploadBudgetMB = std::max(
+        1,
+        TfGetEnvSetting(HDEMBREE_TEXTURE_UPLOAD_BUDGET_MB));
+    frameDumpPath = TfGetEnvSetting(HDEMBREE_FRAME_DUMP_PATH);
 
     if (TfGetEnvSetting(HDEMBREE_PRINT_CONFIGURATION) > 0)
     {
@@ -107,7 +121,11 @@ HdEmbreeConfig::HdEmbreeConfig()
             << "  useFaceColors              = "
             << useFaceColors << "\n"
             << "  cameraLightIntensity      = "
-            << cameraLightIntensity << "\n";
+            << cameraLightIntensity << "\n"
+            << "  textureUploadBudgetMB      = "
+            << textureUploadBudgetMB << "\n"
+            << "  frameDumpPath              = "
+            << frameDumpPath << "\n";
     }
 }
 
@@ -28,6 +28,8 @@
 #include "pxr/pxr.h"
 #include "pxr/base/tf/singleton.h"
 
+#include <string>
+
 USTC_CG_NAMESPACE_OPEN_SCOPE
 using namespace pxr;
 /// \class HdEmbreeConfig
@@ -86,6 +88,19 @@ public:
     /// Override with *HDEMBREE_CAMERA_LIGHT_INTENSITY*.
     float cameraLightIntensity;
 
+    /// How many megabytes of texture data may be uploaded to GL per
+    /// frame? Decoded textures beyond that wait for the next frames.
+    ///
+    /// Override with *HDEMBREE_TEXTURE_UPLOAD_BUDGET_MB*.
+    unsigned int textureUploadBudgetMB;
+
+    /// Where should presented frames be dumped? A run of '#' stands for
+    /// the frame number, e.g. "frames/frame_####.png". Frames are read
+    /// back asynchronously; empty disables the dump.
+    ///
+    /// Override with *HDEMBREE_FRAME_DUMP_PATH*.
+    std::string frameDumpPath;
+
 private:
     // The constructor initializes the config variables with their
     // default or environment-provided override, and optionally prints
@@ -24,8 +24,10 @@
 
 #include "mesh.h"
 
+#include <atomic>
 #include <iostream>
 
+#include "RCore/hd_triangles.hpp"
 #include "USTC_CG.h"
 #include "Utils/Logging/Logging.h"
 #include "context.h"
@@ -36,6 +38,7 @@
 #include "pxr/imaging/hd/smoothNormals.h"
 USTC_CG_NAMESPACE_OPEN_SCOPE
 using namespace pxr;
+
 Hd_USTC_CG_Mesh::Hd_USTC_CG_Mesh(const SdfPath& id)
     : HdMesh(id),
       _cullStyle(HdCullStyleDontCare),
@@ -162,19 +165,36 @@ void Hd_USTC_CG_Mesh::Sync(
         _SetMaterialId(sceneDelegate, this);
     }
 
+    std::pair<size_t, size_t> changed_points;
+    std::pair<size_t, size_t> changed_normals;
+    bool vertices_changed = false;
+
     if (HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->points)) {
         VtValue value = sceneDelegate->Get(id, HdTokens->points);
-        points = value.Get<VtVec3fArray>();
+        auto new_points = value.Get<VtVec3fArray>();
+
+        changed_points = _ChangedRange(points, new_points);
+        points = new_points;
+        vertices_changed = true;
+
+        localBounds = GfRange3f();
+        for (const auto& point : points) {
+            localBounds.UnionWith(point);
+        }
 
         _normalsValid = false;
     }
 
     if (HdChangeTracker::IsTopologyDirty(*dirtyBits, id)) {
         topology = GetMeshTopology(sceneDelegate);
-        HdMeshUtil meshUtil(&topology, GetId());
-        meshUtil.ComputeTriangleIndices(&triangulatedIndices, &trianglePrimitiveParams);
+        HdTriangles triangles(topology, points, GetId());
+        triangulatedIndices = triangles.indices;
+        trianglePrimitiveParams = triangles.primitive_params;
+        triangleCorners = triangles.corners;
         _normalsValid = false;
         _adjacencyValid = false;
+        topologyVersion = _NextVersion();
+        primvarVersion = _NextVersion();
     }
     if (HdChangeTracker::IsInstancerDirty(*dirtyBits, id) ||
         HdChangeTracker::IsTransformDirty(*dirtyBits, id)) {
@@ -185,7 +205,7 @@ void Hd_USTC_CG_Mesh::Sync(
         HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->widths) ||
         HdChangeTracker::IsPrimvarDirty(*dirtyBits, id, HdTokens->primvar)) {
         _UpdatePrimvarSources(sceneDelegate, *dirtyBits);
-        _texcoordsClean = false;
+        primvarVersion = _NextVersion();
     }
 
     if (!_adjacencyValid) {
@@ -196,147 +216,86 @@ void Hd_USTC_CG_Mesh::Sync(
     }
 
     if (!_normalsValid) {
-        computedNormals =
+        auto new_normals =
             Hd_SmoothNormals::ComputeSmoothNormals(&_adjacency, points.size(), points.cdata());
+        changed_normals = _ChangedRange(computedNormals, new_normals);
+        computedNormals = new_normals;
+        _normalsValid = true;
+        vertices_changed = true;
+    }
+    if (vertices_changed) {
+        changedPoints = changed_points;
+        changedNormals = changed_normals;
+        previousVertexVersion = vertexVersion;
+        vertexVersion = _NextVersion();
     }
     _UpdateComputedPrimvarSources(sceneDelegate, *dirtyBits);
     logging("Syncing mesh " + GetId().GetString(), Info);
     *dirtyBits &= ~HdChangeTracker::AllSceneDirtyBits;
 }
 
-void Hd_USTC_CG_Mesh::RefreshGLBuffer()
+unsigned Hd_USTC_CG_Mesh::_NextVersion()
 {
-    const SdfPath& id = GetId();
-
-    if (HdChangeTracker::IsPrimvarDirty(_dirtyBits, id, HdTokens->points)) {
-        // Generate and bind the VAO
-        glDeleteVertexArrays(1, &VAO);
-        glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
-
-        // Generate and bind the VBO
-        glDeleteBuffers(1, &VBO);
-        glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-        // Upload the points data to the VBO
-        glBufferData(
-            GL_ARRAY_BUFFER, points.size() * sizeof(pxr::GfVec3f), points.cdata(), GL_STATIC_DRAW);
-
-        // Specify the layout of the points in the VBO
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+    // Meshes are synced in parallel.
+    static std::atomic<unsigned> counter = 0;
+    return ++counter;
+}
 
-        // Unbind the VAO and VBO
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+std::pair<size_t, size_t> Hd_USTC_CG_Mesh::_ChangedRange(
+    const VtVec3fArray& old_values,
+    const VtVec3fArray& new_values)
+{
+    if (old_values.IsIdentical(new_values)) {
+        return {};
     }
-
-    if (HdChangeTracker::IsTopologyDirty(_dirtyBits, id)) {
-        glBindVertexArray(VAO);
-
-        glDeleteBuffers(1, &EBO);
-        glGenBuffers(1, &EBO);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-        glBufferData(
-            GL_ELEMENT_ARRAY_BUFFER,
-            triangulatedIndices.size() * sizeof(GfVec3i),
-            triangulatedIndices.cdata(),
-            GL_STATIC_DRAW);
+    if (old_values.size() != new_values.size()) {
+        return { 0, new_values.size() };
     }
-    if (!_normalsValid) {
-        glBindVertexArray(VAO);
-
-        glDeleteBuffers(1, &normalBuffer);
-        glGenBuffers(1, &normalBuffer);
-        glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
-        glBufferData(
-            GL_ARRAY_BUFFER,
-            computedNormals.size() * sizeof(GfVec3f),
-            computedNormals.cdata(),
-            GL_STATIC_DRAW);
-
-        // Enable and specify the layout of the normal buffer
-        glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
-        glEnableVertexAttribArray(normalLocation);
-
-        _normalsValid = true;
+    size_t begin = 0;
+    size_t end = new_values.size();
+    while (begin < end && old_values[begin] == new_values[begin]) {
+        ++begin;
     }
-    _dirtyBits = 0;
+    while (end > begin && old_values[end - 1] == new_values[end - 1]) {
+        --end;
+    }
+    return { begin, end };
 }
 
-void Hd_USTC_CG_Mesh::RefreshTexcoordGLBuffer(TfToken texcoord_name)
+VtVec2fArray Hd_USTC_CG_Mesh::ComputeVertexTexcoords(TfToken texcoord_name)
 {
     if (texcoord_name.IsEmpty()) {
-        texcoord_name = texcoord_name = TfToken("UVMap");
+        texcoord_name = TfToken("UVMap");
+    }
+
+    VtArray<GfVec2f> texcoord;
+    if (this->_primvarSourceMap[texcoord_name].data.IsEmpty()) {
+        return texcoord;
     }
-    if (!texcoord_name.IsEmpty()) {
-        if (!_texcoordsClean) {
-            if (!this->_primvarSourceMap[texcoord_name].data.IsEmpty()) {
-                glDeleteBuffers(1, &texcoords);
-                glGenBuffers(1, &texcoords);
-
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, texcoords);
-
-                logging(
-                    GetId().GetString() +
-                        " Attempts to attach texcoord: " + texcoord_name.GetString(),
-                    Info);
-                assert(this->_primvarSourceMap[texcoord_name].data.CanCast<VtVec2fArray>());
-
-                VtArray<GfVec2f> raw_texcoord =
-                    this->_primvarSourceMap[texcoord_name].data.Get<VtVec2fArray>();
-
-                VtArray<GfVec2f> texcoord;
-
-                if (this->_primvarSourceMap[texcoord_name].interpolation ==
-                    HdInterpolationFaceVarying) {
-                    HdMeshUtil mesh_util(&topology, GetId());
-
-                    VtValue vt_triangulated;
-                    mesh_util.ComputeTriangulatedFaceVaryingPrimvar(
-                        raw_texcoord.cdata(),
-                        raw_texcoord.size(),
-                        HdTypeFloatVec2,
-                        &vt_triangulated);
-                    auto triangulated = vt_triangulated.Get<VtVec2fArray>();
-                    texcoord.resize(points.size());
-                    for (int i = 0; i < triangulatedIndices.size(); ++i) {
-                        for (int j = 0; j < 3; ++j) {
-                            texcoord[triangulatedIndices[i][j]] = triangulated[i * 3 + j];
-                        }
-                    }
-                }
-                else {
-                    texcoord = raw_texcoord;
-                }
 
-                glBufferData(
-                    GL_SHADER_STORAGE_BUFFER,
-                    texcoord.size() * sizeof(GfVec2f),
-                    texcoord.cdata(),
-                    GL_STATIC_DRAW);
+    logging(
+        GetId().GetString() + " Attempts to attach texcoord: " + texcoord_name.GetString(), Info);
+    assert(this->_primvarSourceMap[texcoord_name].data.CanCast<VtVec2fArray>());
+
+    VtArray<GfVec2f> raw_texcoord = this->_primvarSourceMap[texcoord_name].data.Get<VtVec2fArray>();
+
+    if (this->_primvarSourceMap[texcoord_name].interpolation == HdInterpolationFaceVarying) {
+        texcoord.resize(points.size());
+        for (int i = 0; i < triangulatedIndices.size(); ++i) {
+            for (int j = 0; j < 3; ++j) {
+                const int vertex = triangulatedIndices[i][j];
+                const int corner = triangleCorners[i * 3 + j];
+                // Out of range for texcoords authored for another topology.
+                if (vertex >= 0 && vertex < texcoord.size() && corner < raw_texcoord.size()) {
+                    texcoord[vertex] = raw_texcoord[corner];
+                }
             }
-            _texcoordsClean = true;
         }
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, texcoords);
     }
-}
-
-void Hd_USTC_CG_Mesh::Finalize(HdRenderParam* renderParam)
-{
-    glDeleteVertexArrays(1, &VAO);
-    VAO = 0;
-    glDeleteBuffers(1, &VBO);
-    VBO = 0;
-    glDeleteBuffers(1, &EBO);
-    EBO = 0;
-    glDeleteBuffers(1, &normalBuffer);
-    normalBuffer = 0;
-    glDeleteBuffers(1, &texcoords);
-    texcoords = 0;
+    else {
+        texcoord = raw_texcoord;
+    }
+    return texcoord;
 }
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
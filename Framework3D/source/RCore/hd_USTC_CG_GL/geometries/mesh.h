@@ -24,8 +24,11 @@
 #ifndef EXTRAS_IMAGING_EXAMPLES_HD_TINY_MESH_H
 #define EXTRAS_IMAGING_EXAMPLES_HD_TINY_MESH_H
 
+#include <utility>
+
 #include "USTC_CG.h"
 #include "pxr/base/gf/matrix4f.h"
+#include "pxr/base/gf/range3f.h"
 #include "pxr/imaging/garch/glApi.h"
 #include "pxr/imaging/hd/mesh.h"
 #include "pxr/imaging/hd/vertexAdjacency.h"
@@ -49,26 +52,35 @@ class Hd_USTC_CG_Mesh final : public HdMesh {
         HdDirtyBits* dirtyBits,
         const TfToken& reprToken) override;
 
-    void RefreshGLBuffer();
-    void RefreshTexcoordGLBuffer(TfToken texcoord_name);
+    // Per-vertex texcoords for the given primvar, with face-varying values scattered to vertices.
+    VtVec2fArray ComputeVertexTexcoords(TfToken texcoord_name);
 
-    void Finalize(HdRenderParam* renderParam) override;
-    GLuint VAO = 0;
-    GLuint VBO = 0;
-    GLuint EBO = 0;
-    GLuint normalBuffer = 0;
-    GLuint texcoords = 0;
     GfMatrix4f transform;
     VtVec3iArray triangulatedIndices;
     VtIntArray trianglePrimitiveParams;
+    // The face corner of each triangle corner, for face-varying primvars.
+    VtIntArray triangleCorners;
     VtArray<GfVec3f> points;
     VtVec3fArray computedNormals;
+    // Object-space bounds of points, refreshed whenever points change.
+    GfRange3f localBounds;
+    // The versions below are drawn from one counter shared by all meshes, so a mesh synced anew
+    // at the path of a removed one never matches a copy of the old one.
+    // Renewed whenever points or normals change. The [begin, end) vertex ranges are those that
+    // changed since previousVertexVersion, so a copy at that version only needs those.
+    unsigned vertexVersion = 0;
+    unsigned previousVertexVersion = 0;
+    std::pair<size_t, size_t> changedPoints;
+    std::pair<size_t, size_t> changedNormals;
+    // Renewed whenever the triangulation changes.
+    unsigned topologyVersion = 0;
+    // Renewed whenever texcoords may change, i.e. on primvar or triangulation changes.
+    unsigned primvarVersion = 0;
     static constexpr GLuint normalLocation = 1;
     static constexpr GLuint texcoordLocation = 2;
 
    protected:
     uint32_t _dirtyBits;
-    bool _texcoordsClean;
 
     void _InitRepr(const TfToken& reprToken, HdDirtyBits* dirtyBits) override;
     void _SetMaterialId(HdSceneDelegate* scene_delegate, Hd_USTC_CG_Mesh* hd_ustc_cg_mesh);
@@ -84,6 +96,13 @@ class Hd_USTC_CG_Mesh final : public HdMesh {
     Hd_USTC_CG_Mesh& operator=(const Hd_USTC_CG_Mesh&) = delete;
 
    private:
+    static unsigned _NextVersion();
+    // Smallest [begin, end) vertex range outside of which the two arrays agree. All of them if
+    // the sizes differ.
+    static std::pair<size_t, size_t> _ChangedRange(
+        const VtVec3fArray& old_values,
+        const VtVec3fArray& new_values);
+
     HdCullStyle _cullStyle;
     bool _doubleSided;
 
@@ -1,5 +1,7 @@
 #include "light.h"
 
+#include <atomic>
+
 #include "RCore/internal/gl/GLResources.hpp"
 #include "Utils/Logging/Logging.h"
 #include "pxr/imaging/glf/simpleLight.h"
@@ -255,8 +257,10 @@ GLuint Hd_USTC_CG_Dome_Light::createTextureFromHioImage(const InputDescriptor& e
 
 void Hd_USTC_CG_Dome_Light::RefreshGLBuffer()
 {
+    static std::atomic<size_t> textureVersionCounter = 0;
     if (env_texture.glTexture == 0) {
         env_texture.glTexture = createTextureFromHioImage(env_texture);
+        textureVersion = ++textureVersionCounter;
     }
 }
 
@@ -273,7 +277,20 @@ void Hd_USTC_CG_Dome_Light::BindTextures(Shader& shader, unsigned& id)
 void Hd_USTC_CG_Dome_Light::_PrepareDomeLight(SdfPath const& id, HdSceneDelegate* sceneDelegate)
 {
     const VtValue v = sceneDelegate->GetLightParamValue(id, HdLightTokens->textureFile);
-    textureFileName = v.Get<pxr::SdfAssetPath>();
+    auto newTextureFileName = v.Get<pxr::SdfAssetPath>();
+
+    auto diffuse = sceneDelegate->GetLightParamValue(id, HdLightTokens->diffuse).Get<float>();
+    auto newRadiance =
+        sceneDelegate->GetLightParamValue(id, HdLightTokens->color).Get<GfVec3f>() * diffuse;
+
+    // Transform edits also sync the light. Keep the texture, and everything derived from it,
+    // unless the environment itself changed.
+    if (env_texture.glTexture && newTextureFileName == textureFileName &&
+        newRadiance == radiance) {
+        return;
+    }
+    textureFileName = newTextureFileName;
+    radiance = newRadiance;
 
     env_texture.image = HioImage::OpenForReading(textureFileName.GetAssetPath(), 0, 0);
 
@@ -281,9 +298,6 @@ void Hd_USTC_CG_Dome_Light::_PrepareDomeLight(SdfPath const& id, HdSceneDelegate
         glDeleteTextures(1, &env_texture.glTexture);
         env_texture.glTexture = 0;
     }
-
-    auto diffuse = sceneDelegate->GetLightParamValue(id, HdLightTokens->diffuse).Get<float>();
-    radiance = sceneDelegate->GetLightParamValue(id, HdLightTokens->color).Get<GfVec3f>() * diffuse;
 }
 
 void Hd_USTC_CG_Dome_Light::Sync(
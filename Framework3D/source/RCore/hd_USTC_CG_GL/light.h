@@ -65,6 +65,19 @@ class USTC_CG_API Hd_USTC_CG_Dome_Light : public Hd_USTC_CG_Light {
     void RefreshGLBuffer();
     void BindTextures(Shader& shader, unsigned& id);
 
+    // The environment texture, 0 before RefreshGLBuffer().
+    GLuint GetTexture() const
+    {
+        return env_texture.glTexture;
+    }
+
+    // Changes whenever the environment texture is recreated. Unique across dome lights, so it
+    // identifies the texture in caches of derived data.
+    size_t GetTextureVersion() const
+    {
+        return textureVersion;
+    }
+
     void _PrepareDomeLight(SdfPath const& id, HdSceneDelegate* scene_delegate);
     void Sync(HdSceneDelegate* sceneDelegate, HdRenderParam* renderParam, HdDirtyBits* dirtyBits)
         override;
@@ -76,6 +89,7 @@ class USTC_CG_API Hd_USTC_CG_Dome_Light : public Hd_USTC_CG_Light {
     GfVec3f radiance;
 
     InputDescriptor env_texture;
+    size_t textureVersion = 0;
 };
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
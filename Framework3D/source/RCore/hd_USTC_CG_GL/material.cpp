@@ -33,6 +33,7 @@ void Hd_USTC_CG_Material::DestroyTexture(InputDescriptor& input_descriptor)
         glDeleteTextures(1, &input_descriptor.glTexture);
         input_descriptor.glTexture = 0;
     }
+    input_descriptor.streamed = nullptr;
 }
 
 void Hd_USTC_CG_Material::TryLoadTexture(
@@ -60,6 +61,7 @@ void Hd_USTC_CG_Material::TryLoadTexture(
             }
 
             descriptor.image = HioImage::OpenForReading(file_name, 0, 0, colorSpace);
+            descriptor.streamed = nullptr;
             descriptor.wrapS = texture_node.parameters[TfToken("wrapS")].Get<TfToken>();
             descriptor.wrapT = texture_node.parameters[TfToken("wrapT")].Get<TfToken>();
 
@@ -87,95 +89,41 @@ void Hd_USTC_CG_Material::TryLoadParameter(
     }
 }
 
-GLuint Hd_USTC_CG_Material::createTextureFromHioImage(const InputDescriptor& descriptor)
+GLuint Hd_USTC_CG_Material::createPlaceholderTexture(const InputDescriptor& descriptor)
 {
-    // Step 4: Create an OpenGL texture object
     GLuint texture;
     glGenTextures(1, &texture);
-
-    // Step 5: Bind the texture object and specify its parameters
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    auto image = descriptor.image;
-    if (image) {
-        // Step 1: Get image information
-        int width = image->GetWidth();
-        int height = image->GetHeight();
-        HioFormat format = image->GetFormat();
-
-        HioImage::StorageSpec storageSpec;
-        storageSpec.width = width;
-        storageSpec.height = height;
-        storageSpec.format = format;
-        storageSpec.data = malloc(width * height * image->GetBytesPerPixel());
-        if (!storageSpec.data) {
-            return 0;
-        }
-
-        // Step 3: Read the image data
-        if (!image->Read(storageSpec)) {
-            free(storageSpec.data);
-            return 0;
-        }
+    float color[4] = { 0.5f, 0.5f, 0.5f, 1.0f };
+    if (descriptor.input_name == TfToken("roughness") ||
+        descriptor.input_name == TfToken("metallic")) {
+        logging("Creating metallic or roughness for " + GetId().GetString());
 
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GetGLInternalFormat(format),
-            width,
-            height,
-            0,
-            GetGLFormat(format),
-            GetGLType(format),
-            storageSpec.data);
-        free(storageSpec.data);
+        assert(metallic.value.CanCast<float>());
+        assert(roughness.value.CanCast<float>());
+        color[0] = 0;
+        color[1] = metallic.value.Get<float>();
+        color[2] = roughness.value.Get<float>();
     }
-    else {
-        if (descriptor.input_name == TfToken("roughness") ||
-            descriptor.input_name == TfToken("metallic")) {
-            logging("Creating metallic or roughness for " + GetId().GetString());
-
-            float metallic_value = metallic.value.Get<float>();
-            float roughness_value = roughness.value.Get<float>();
-            assert(metallic.value.CanCast<float>());
-            assert(roughness.value.CanCast<float>());
-            float color[4] = { 0, metallic_value, roughness_value, 1.0f };
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GetGLInternalFormat(HioFormatFloat32Vec4),
-                1,
-                1,
-                0,
-                GetGLFormat(HioFormatFloat32Vec4),
-                GetGLType(HioFormatFloat32Vec4),
-                color);
-        }
-        else if (!descriptor.value.IsEmpty()) {
-            if (descriptor.value.CanCast<GfVec3f>()) {
-                auto val = descriptor.value.Get<GfVec3f>();
-                float color[4] = { val[0], val[1], val[2], 1.0f };
-
-                glTexImage2D(
-                    GL_TEXTURE_2D,
-                    0,
-                    GetGLInternalFormat(HioFormatFloat32Vec4),
-                    1,
-                    1,
-                    0,
-                    GetGLFormat(HioFormatFloat32Vec4),
-                    GetGLType(HioFormatFloat32Vec4),
-                    color);
-            }
-        }
+    else if (descriptor.value.CanCast<GfVec3f>()) {
+        auto val = descriptor.value.Get<GfVec3f>();
+        color[0] = val[0];
+        color[1] = val[1];
+        color[2] = val[2];
     }
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    float aniso = 0.0f;
-    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &aniso);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, aniso);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GetGLInternalFormat(HioFormatFloat32Vec4),
+        1,
+        1,
+        0,
+        GetGLFormat(HioFormatFloat32Vec4),
+        GetGLType(HioFormatFloat32Vec4),
+        color);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -188,7 +136,10 @@ GLuint Hd_USTC_CG_Material::createTextureFromHioImage(const InputDescriptor& des
 void Hd_USTC_CG_Material::TryCreateGLTexture(InputDescriptor& descriptor)
 {
     if (descriptor.glTexture == 0) {
-        descriptor.glTexture = createTextureFromHioImage(descriptor);
+        descriptor.glTexture = createPlaceholderTexture(descriptor);
+    }
+    if (descriptor.image && !descriptor.streamed) {
+        descriptor.streamed = texture_streamer.Request(descriptor.image);
     }
 }
 
@@ -267,15 +218,15 @@ void Hd_USTC_CG_Material::BindTextures(Shader& shader)
     assert(diffuseColor.glTexture);
     shader.setInt("diffuseColorSampler", 0);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuseColor.glTexture);
+    glBindTexture(GL_TEXTURE_2D, diffuseColor.BoundTexture());
 
     shader.setInt("normalMapSampler", 1);
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, normal.glTexture);
+    glBindTexture(GL_TEXTURE_2D, normal.BoundTexture());
 
     shader.setInt("metallicRoughnessSampler", 2);
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, metallic.glTexture);
+    glBindTexture(GL_TEXTURE_2D, metallic.BoundTexture());
 }
 
 HdDirtyBits Hd_USTC_CG_Material::GetInitialDirtyBitsMask() const
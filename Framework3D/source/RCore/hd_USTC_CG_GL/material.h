@@ -5,6 +5,7 @@
 #include "pxr/imaging/garch/glApi.h"
 #include "pxr/imaging/hd/material.h"
 #include "pxr/imaging/hio/image.h"
+#include "textureStreamer.h"
 
 namespace pxr {
 class Hio_OpenEXRImage;
@@ -28,8 +29,15 @@ class Hd_USTC_CG_Material : public HdMaterial {
 
         VtValue value;
 
+        // Constant-value texture, also the placeholder while the image streams in.
         GLuint glTexture = 0;
+        Hd_USTC_CG_StreamedTextureHandle streamed;
         TfToken input_name;
+
+        GLuint BoundTexture() const
+        {
+            return streamed && streamed->glTexture ? streamed->glTexture : glTexture;
+        }
     };
 
     explicit Hd_USTC_CG_Material(SdfPath const& id);
@@ -62,8 +70,9 @@ class Hd_USTC_CG_Material : public HdMaterial {
    private:
     HdMaterialNetwork2 surfaceNetwork;
 
-    // Function to create an OpenGL texture from a HioImage object
-    GLuint createTextureFromHioImage(const InputDescriptor& descriptor);
+    // 1x1 texture holding the constant value of the input. Images are streamed separately by
+    // texture_streamer.
+    GLuint createPlaceholderTexture(const InputDescriptor& descriptor);
 
     void TryLoadTexture(
         const char* str,
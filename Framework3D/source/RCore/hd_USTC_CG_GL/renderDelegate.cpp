@@ -29,6 +29,8 @@
 #include "Nodes/node_exec.hpp"
 #include "Nodes/node_exec_eager.hpp"
 #include "Nodes/node_tree.hpp"
+#include "RCore/internal/gl/gl_release.hpp"
+#include "RCore/internal/gl/texture_readback.hpp"
 #include "Utils/Logging/Logging.h"
 #include "config.h"
 #include "geometries/mesh.h"
@@ -38,6 +40,7 @@
 #include "pxr/imaging/hd/camera.h"
 #include "pxr/imaging/hd/extComputation.h"
 #include "renderBuffer.h"
+#include "textureStreamer.h"
 #include "renderPass.h"
 #include "renderer.h"
 
@@ -151,6 +154,9 @@ HdAovDescriptor Hd_USTC_CG_RenderDelegate::GetDefaultAovDescriptor(const TfToken
 Hd_USTC_CG_RenderDelegate::~Hd_USTC_CG_RenderDelegate()
 {
     _resourceRegistry.reset();
+    texture_streamer.Release();
+    texture_readback.release();
+    release_gl_objects();
     std::cout << "Destroying Tiny RenderDelegate" << std::endl;
 }
 
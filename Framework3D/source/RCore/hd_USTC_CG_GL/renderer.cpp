@@ -2,10 +2,14 @@
 
 #include "Nodes/node_tree.hpp"
 #include "RCore/Backend.hpp"
+#include "RCore/internal/gl/texture_readback.hpp"
+#include "config.h"
+#include "pxr/base/tf/stringUtils.h"
 #include "pxr/imaging/hd/renderBuffer.h"
 #include "pxr/imaging/hd/tokens.h"
 #include "renderBuffer.h"
 #include "renderParam.h"
+#include "textureStreamer.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
 using namespace pxr;
@@ -40,6 +44,9 @@ void Hd_USTC_CG_Renderer::Render(HdRenderThread* renderThread)
     
 
     executor->prepare_tree(node_tree);
+
+    // Textures finished decoding since the last frame go to GL, within the upload budget.
+    texture_streamer.Update();
     
 
     for (auto&& node : node_tree->nodes) {
@@ -82,7 +89,21 @@ void Hd_USTC_CG_Renderer::Render(HdRenderThread* renderThread)
 
             rb->SetConverged(true);
         }
+
+        const auto& frameDumpPath = HdEmbreeConfig::GetInstance().frameDumpPath;
+        if (!frameDumpPath.empty()) {
+            static int frame = 0;
+            auto size = texture->desc.size;
+            texture_readback.request_to_file(
+                texture->texture_id,
+                size[0],
+                size[1],
+                frame_file_path(frameDumpPath, frame++));
+        }
     }
+
+    // Readbacks requested by the nodes or the frame dump of earlier frames.
+    texture_readback.update();
     
 
     executor->finalize(node_tree);
@@ -0,0 +1,280 @@
+#include "textureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "RCore/internal/gl/GLResources.hpp"
+#include "Utils/Logging/Logging.h"
+#include "config.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+Hd_USTC_CG_TextureStreamer texture_streamer;
+
+static constexpr GLbitfield persistentMapFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// glTextureStorage2D only takes sized formats. 0 for formats we do not stream.
+static GLenum GetGLSizedInternalFormat(HioFormat format)
+{
+    switch (format) {
+        case HioFormatUNorm8:
+        case HioFormatUNorm8srgb: return GL_R8;
+        case HioFormatUNorm8Vec2:
+        case HioFormatUNorm8Vec2srgb: return GL_RG8;
+        case HioFormatUNorm8Vec3: return GL_RGB8;
+        case HioFormatUNorm8Vec4: return GL_RGBA8;
+        case HioFormatUNorm8Vec3srgb: return GL_SRGB8;
+        case HioFormatUNorm8Vec4srgb: return GL_SRGB8_ALPHA8;
+        case HioFormatSNorm8: return GL_R8_SNORM;
+        case HioFormatSNorm8Vec2: return GL_RG8_SNORM;
+        case HioFormatSNorm8Vec3: return GL_RGB8_SNORM;
+        case HioFormatSNorm8Vec4: return GL_RGBA8_SNORM;
+        case HioFormatFloat16: return GL_R16F;
+        case HioFormatFloat16Vec2: return GL_RG16F;
+        case HioFormatFloat16Vec3: return GL_RGB16F;
+        case HioFormatFloat16Vec4: return GL_RGBA16F;
+        case HioFormatFloat32: return GL_R32F;
+        case HioFormatFloat32Vec2: return GL_RG32F;
+        case HioFormatFloat32Vec3: return GL_RGB32F;
+        case HioFormatFloat32Vec4: return GL_RGBA32F;
+        case HioFormatUInt16: return GL_R16;
+        case HioFormatUInt16Vec2: return GL_RG16;
+        case HioFormatUInt16Vec3: return GL_RGB16;
+        case HioFormatUInt16Vec4: return GL_RGBA16;
+        default: return 0;
+    }
+}
+
+static GLenum GetGLUploadType(HioFormat format)
+{
+    switch (format) {
+        case HioFormatUInt16:
+        case HioFormatUInt16Vec2:
+        case HioFormatUInt16Vec3:
+        case HioFormatUInt16Vec4: return GL_UNSIGNED_SHORT;
+        default: return GetGLType(format);
+    }
+}
+
+Hd_USTC_CG_StreamedTexture::~Hd_USTC_CG_StreamedTexture()
+{
+    if (glTexture) {
+        glDeleteTextures(1, &glTexture);
+        texture_streamer._residentBytes -= bytes;
+    }
+}
+
+Hd_USTC_CG_StreamedTextureHandle Hd_USTC_CG_TextureStreamer::Request(
+    const HioImageSharedPtr& image)
+{
+    auto texture = std::make_shared<Hd_USTC_CG_StreamedTexture>();
+    if (!image || !GetGLSizedInternalFormat(image->GetFormat())) {
+        logging("Texture format not supported for streaming.", Warning);
+        return texture;
+    }
+
+    texture->bytes = size_t(image->GetWidth()) * image->GetHeight() * image->GetBytesPerPixel();
+    _queuedBytes += texture->bytes;
+
+    // The worker only holds a weak reference: the texture owns GL objects and must die on the
+    // GL thread.
+    std::weak_ptr<Hd_USTC_CG_StreamedTexture> weak = texture;
+    size_t bytes = texture->bytes;
+    _dispatcher.Run([this, weak, image, bytes]() {
+        if (weak.expired()) {
+            _queuedBytes -= bytes;
+            return;
+        }
+
+        Upload upload;
+        upload.texture = weak;
+        upload.width = image->GetWidth();
+        upload.height = image->GetHeight();
+        upload.format = image->GetFormat();
+        upload.rowBytes = size_t(upload.width) * image->GetBytesPerPixel();
+        upload.pixels.resize(bytes);
+
+        HioImage::StorageSpec storageSpec;
+        storageSpec.width = upload.width;
+        storageSpec.height = upload.height;
+        storageSpec.format = upload.format;
+        storageSpec.data = upload.pixels.data();
+        if (!image->Read(storageSpec)) {
+            logging("Failed to read texture " + image->GetFilename(), Warning);
+            _queuedBytes -= bytes;
+            return;
+        }
+
+        std::lock_guard lock(_decodedMutex);
+        _decoded.push_back(std::move(upload));
+    });
+    return texture;
+}
+
+void Hd_USTC_CG_TextureStreamer::_AllocateRing(size_t segmentSize)
+{
+    _ReleaseRing();
+    _segmentSize = segmentSize;
+    const GLsizeiptr size = _segmentSize * ringSegmentCount;
+    glCreateBuffers(1, &_ring);
+    glNamedBufferStorage(_ring, size, nullptr, persistentMapFlags);
+    _ringMapped =
+        static_cast<unsigned char*>(glMapNamedBufferRange(_ring, 0, size, persistentMapFlags));
+    _currentSegment = 0;
+}
+
+void Hd_USTC_CG_TextureStreamer::_ReleaseRing()
+{
+    for (auto& fence : _fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (_ringMapped) {
+        glUnmapNamedBuffer(_ring);
+        _ringMapped = nullptr;
+    }
+    glDeleteBuffers(1, &_ring);
+    _ring = 0;
+    _segmentSize = 0;
+}
+
+void Hd_USTC_CG_TextureStreamer::Update()
+{
+    {
+        std::lock_guard lock(_decodedMutex);
+        for (auto& upload : _decoded) {
+            _uploads.push_back(std::move(upload));
+        }
+        _decoded.clear();
+    }
+    if (_uploads.empty()) {
+        return;
+    }
+
+    const size_t budget = size_t(HdEmbreeConfig::GetInstance().textureUploadBudgetMB) << 20;
+    if (budget != _segmentSize) {
+        _AllocateRing(budget);
+    }
+
+    // The segment written three frames ago is usually consumed by now.
+    if (_fences[_currentSegment]) {
+        while (glClientWaitSync(_fences[_currentSegment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) ==
+               GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(_fences[_currentSegment]);
+        _fences[_currentSegment] = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _ring);
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    size_t offset = 0;
+    while (!_uploads.empty()) {
+        auto& upload = _uploads.front();
+        if (upload.texture.expired() || upload.rowBytes > _segmentSize) {
+            if (!upload.texture.expired()) {
+                logging("Texture rows exceed the upload budget, skipped.", Warning);
+            }
+            glDeleteTextures(1, &upload.stagingTexture);
+            _queuedBytes -= upload.pixels.size();
+            _uploads.pop_front();
+            continue;
+        }
+        if (!_UploadRows(upload, offset)) {
+            break;
+        }
+        _Finish(upload);
+        _uploads.pop_front();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (offset) {
+        _fences[_currentSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _currentSegment = (_currentSegment + 1) % ringSegmentCount;
+    }
+}
+
+bool Hd_USTC_CG_TextureStreamer::_UploadRows(Upload& upload, size_t& offset)
+{
+    if (!upload.stagingTexture) {
+        int levels = 1 + int(std::floor(std::log2(std::max(upload.width, upload.height))));
+        glCreateTextures(GL_TEXTURE_2D, 1, &upload.stagingTexture);
+        glTextureStorage2D(
+            upload.stagingTexture,
+            levels,
+            GetGLSizedInternalFormat(upload.format),
+            upload.width,
+            upload.height);
+    }
+
+    int rows = int(std::min<size_t>(
+        upload.height - upload.rowsUploaded, (_segmentSize - offset) / upload.rowBytes));
+    if (rows > 0) {
+        size_t base = _currentSegment * _segmentSize + offset;
+        size_t size = rows * upload.rowBytes;
+        auto src = upload.pixels.data() + upload.rowsUploaded * upload.rowBytes;
+        memcpy(_ringMapped + base, src, size);
+        glTextureSubImage2D(
+            upload.stagingTexture,
+            0,
+            0,
+            upload.rowsUploaded,
+            upload.width,
+            rows,
+            GetGLFormat(upload.format),
+            GetGLUploadType(upload.format),
+            reinterpret_cast<const void*>(base));
+        upload.rowsUploaded += rows;
+        offset += size;
+    }
+    return upload.rowsUploaded == upload.height;
+}
+
+void Hd_USTC_CG_TextureStreamer::_Finish(Upload& upload)
+{
+    GLuint texture = upload.stagingTexture;
+    glGenerateTextureMipmap(texture);
+
+    float aniso = 0.0f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &aniso);
+    glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY_EXT, aniso);
+
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Checked by the caller, and only the GL thread releases textures.
+    auto streamed = upload.texture.lock();
+    streamed->glTexture = texture;
+    upload.stagingTexture = 0;
+
+    _queuedBytes -= upload.pixels.size();
+    _residentBytes += upload.pixels.size();
+}
+
+void Hd_USTC_CG_TextureStreamer::Release()
+{
+    _dispatcher.Wait();
+    for (auto& upload : _decoded) {
+        _queuedBytes -= upload.pixels.size();
+    }
+    _decoded.clear();
+    for (auto& upload : _uploads) {
+        glDeleteTextures(1, &upload.stagingTexture);
+        _queuedBytes -= upload.pixels.size();
+    }
+    _uploads.clear();
+    _ReleaseRing();
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/work/dispatcher.h"
+#include "pxr/imaging/garch/glApi.h"
+#include "pxr/imaging/hio/image.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+// A texture whose image is decoded on a worker thread and uploaded over the following frames.
+// glTexture stays 0 until the whole image and its mip chain are resident, so users keep binding
+// a placeholder until then.
+struct Hd_USTC_CG_StreamedTexture {
+    ~Hd_USTC_CG_StreamedTexture();
+
+    GLuint glTexture = 0;
+    size_t bytes = 0;
+};
+
+using Hd_USTC_CG_StreamedTextureHandle = std::shared_ptr<Hd_USTC_CG_StreamedTexture>;
+
+// Decodes images with HioImage::Read off the render thread, and uploads the decoded rows through
+// a ring of persistent-mapped pixel buffers. At most textureUploadBudgetMB (see config.h) are
+// copied per frame, large images are spread over several frames.
+class Hd_USTC_CG_TextureStreamer {
+   public:
+    Hd_USTC_CG_StreamedTextureHandle Request(const HioImageSharedPtr& image);
+
+    // Moves decoded images into GL, within the per-frame budget. Called once per frame with the
+    // GL context current.
+    void Update();
+
+    // Bytes requested but not resident yet, and bytes of the resident textures (base level).
+    size_t QueuedBytes() const
+    {
+        return _queuedBytes;
+    }
+
+    size_t ResidentBytes() const
+    {
+        return _residentBytes;
+    }
+
+    // Waits for the workers and frees the staging ring. Call before the GL context goes away.
+    void Release();
+
+   private:
+    friend struct Hd_USTC_CG_StreamedTexture;
+
+    struct Upload {
+        std::weak_ptr<Hd_USTC_CG_StreamedTexture> texture;
+        int width;
+        int height;
+        HioFormat format;
+        size_t rowBytes;
+        std::vector<unsigned char> pixels;
+
+        GLuint stagingTexture = 0;
+        int rowsUploaded = 0;
+    };
+
+    static constexpr int ringSegmentCount = 3;
+
+    void _AllocateRing(size_t segmentSize);
+    void _ReleaseRing();
+    // Returns false when the segment is full.
+    bool _UploadRows(Upload& upload, size_t& offset);
+    void _Finish(Upload& upload);
+
+    WorkDispatcher _dispatcher;
+
+    std::mutex _decodedMutex;
+    std::vector<Upload> _decoded;
+
+    // Only touched on the GL thread.
+    std::deque<Upload> _uploads;
+    GLuint _ring = 0;
+    unsigned char* _ringMapped = nullptr;
+    size_t _segmentSize = 0;
+    int _currentSegment = 0;
+    GLsync _fences[ringSegmentCount] = {};
+
+    std::atomic<size_t> _queuedBytes = 0;
+    std::atomic<size_t> _residentBytes = 0;
+};
+
+extern Hd_USTC_CG_TextureStreamer texture_streamer;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,7 +1,11 @@
 #include "RCore/internal/gl/GLResources.hpp"
 
+#include <cassert>
 #include <filesystem>
+#include <map>
+#include <tuple>
 
+#include "RCore/internal/gl/file_watcher.hpp"
 #include "pxr/imaging/hd/types.h"
 #include "pxr/imaging/hio/types.h"
 USTC_CG_NAMESPACE_OPEN_SCOPE
@@ -268,33 +272,49 @@ namespace fs = std::filesystem;
 void ShaderDesc::set_vertex_path(const std::filesystem::path& vertex_path)
 {
     vertexPath = vertex_path;
-    update_last_write_time(vertexPath);
+    vertexVersion = shader_file_watcher.version(vertexPath);
 }
 
 void ShaderDesc::set_fragment_path(const std::filesystem::path& fragment_path)
 {
     fragmentPath = fragment_path;
-    update_last_write_time(fragmentPath);
+    fragmentVersion = shader_file_watcher.version(fragmentPath);
 }
 
-void ShaderDesc::update_last_write_time(const std::filesystem::path& path)
+void ShaderDesc::set_compute_path(const std::filesystem::path& compute_path)
 {
-    try {
-        auto possibly_newer_lastWriteTime = fs::last_write_time(path);
-        if (possibly_newer_lastWriteTime > lastWriteTime) {
-            lastWriteTime = possibly_newer_lastWriteTime;
-        }
-    }
-    catch (const fs::filesystem_error& e) {
-        lastWriteTime = {};
-    }
+    computePath = compute_path;
+    computeVersion = shader_file_watcher.version(computePath);
 }
 
 ShaderHandle createShader(const ShaderDesc& desc)
 {
-    ShaderHandle ret = std::make_shared<ShaderResource>(
-        desc.vertexPath.string().c_str(), desc.fragmentPath.string().c_str());
+    // The latest program built from the same files. While a new version links in the background,
+    // the old one keeps drawing.
+    static std::map<std::tuple<fs::path, fs::path, fs::path>, std::weak_ptr<ShaderResource>>
+        latest;
+    auto& previous_slot = latest[{ desc.vertexPath, desc.fragmentPath, desc.computePath }];
+    ShaderHandle previous = previous_slot.lock();
+    if (previous && !previous->shader.ready()) {
+        previous = previous->fallback;
+    }
+
+    const Shader* fallback = previous ? &previous->shader : nullptr;
+    ShaderHandle ret;
+    if (!desc.computePath.empty()) {
+        ret = std::make_shared<ShaderResource>(desc.computePath.string().c_str(), fallback);
+    }
+    else {
+        ret = std::make_shared<ShaderResource>(
+            desc.vertexPath.string().c_str(), desc.fragmentPath.string().c_str(), fallback);
+    }
     ret->desc = desc;
+    if (!ret->shader.ready() && previous) {
+        // Only one level of fallback is kept alive.
+        previous->fallback = nullptr;
+        ret->fallback = previous;
+    }
+    previous_slot = ret;
     return ret;
 }
 
@@ -303,18 +323,28 @@ TextureHandle createTexture(const TextureDesc& desc)
     TextureHandle ret = std::make_shared<TextureResource>();
     ret->desc = desc;
     auto _format = desc.format;
-    if (desc.array_size == 1) {
+
+    GLenum internal_format = GetGLInternalFormat(_format);
+    GLenum format = GetGLFormat(_format);
+    GLenum type = GetGLType(_format);
+    if (desc.depth_only) {
+        assert(_format == HdFormatFloat32);
+        internal_format = GL_DEPTH_COMPONENT32F;
+        format = GL_DEPTH_COMPONENT;
+    }
+
+    if (desc.array_size == 1 && !desc.layered) {
         glCreateTextures(GL_TEXTURE_2D, 1, &ret->texture_id);
         glBindTexture(GL_TEXTURE_2D, ret->texture_id);
         glTexImage2D(
             GL_TEXTURE_2D,
             0,
-            GetGLInternalFormat(_format),
+            internal_format,
             desc.size[0],
             desc.size[1],
             0,
-            GetGLFormat(_format),
-            GetGLType(_format),
+            format,
+            type,
             NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -328,17 +358,24 @@ TextureHandle createTexture(const TextureDesc& desc)
         glTexImage3D(
             GL_TEXTURE_2D_ARRAY,
             0,
-            GetGLInternalFormat(_format),
+            internal_format,
             desc.size[0],
             desc.size[1],
             desc.array_size,
             0,
-            GetGLFormat(_format),
-            GetGLType(_format),
+            format,
+            type,
             NULL);
         
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (desc.depth_only) {
+            // Lookups outside a shadow map read the far plane.
+            const float border[] = { 1.f, 1.f, 1.f, 1.f };
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+        }
     }
 
     return ret;
@@ -0,0 +1,127 @@
+#include "RCore/internal/gl/file_watcher.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+namespace fs = std::filesystem;
+
+FileWatcher shader_file_watcher;
+
+static std::string watch_key(const fs::path& path)
+{
+    return fs::absolute(path).lexically_normal().string();
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+{
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0) {
+        thread_ = std::thread([this] { run(); });
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void FileWatcher::watch_directory(const fs::path& directory)
+{
+    for (auto& watched : directories_) {
+        if (watched.second == directory) {
+            return;
+        }
+    }
+    int wd = inotify_add_watch(
+        fd_,
+        directory.c_str(),
+        IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB);
+    if (wd >= 0) {
+        directories_[wd] = directory;
+    }
+}
+
+void FileWatcher::run()
+{
+    alignas(inotify_event) char buffer[4096];
+    while (!stop_) {
+        pollfd descriptor = { fd_, POLLIN, 0 };
+        if (poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t length;
+        while ((length = read(fd_, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard lock(mutex_);
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                auto event = reinterpret_cast<const inotify_event*>(ptr);
+                auto directory = directories_.find(event->wd);
+                if (event->len && directory != directories_.end()) {
+                    auto file = files_.find((directory->second / event->name).string());
+                    if (file != files_.end()) {
+                        ++file->second.version;
+                    }
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+std::uint64_t FileWatcher::version(const fs::path& path)
+{
+    auto key = watch_key(path);
+    std::lock_guard lock(mutex_);
+    auto file = files_.find(key);
+    if (file != files_.end()) {
+        return file->second.version;
+    }
+    files_[key] = {};
+    if (fd_ >= 0) {
+        watch_directory(fs::path(key).parent_path());
+    }
+    return 0;
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+std::uint64_t FileWatcher::version(const fs::path& path)
+{
+    auto key = watch_key(path);
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard lock(mutex_);
+    auto [file, inserted] = files_.try_emplace(key);
+    auto& entry = file->second;
+    if (inserted || now - entry.checked >= pollInterval) {
+        entry.checked = now;
+        std::error_code error;
+        auto write_time = fs::last_write_time(key, error);
+        if (error) {
+            write_time = {};
+        }
+        if (!inserted && write_time != entry.write_time) {
+            ++entry.version;
+        }
+        entry.write_time = write_time;
+    }
+    return entry.version;
+}
+
+#endif
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,36 @@
+#include "RCore/internal/gl/gl_release.hpp"
+
+#include <mutex>
+#include <vector>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Constructed on first use, so that registering from other static initializers is safe.
+static std::vector<std::function<void()>>& release_functions()
+{
+    static std::vector<std::function<void()>> functions;
+    return functions;
+}
+
+static std::mutex& release_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+bool register_gl_release(std::function<void()> release)
+{
+    std::lock_guard lock(release_mutex());
+    release_functions().push_back(std::move(release));
+    return true;
+}
+
+void release_gl_objects()
+{
+    std::lock_guard lock(release_mutex());
+    for (auto& release : release_functions()) {
+        release();
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -1,9 +1,14 @@
 #include "RCore/internal/gl/shader.hpp"
 
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "USTC_CG.h"
 #include "pxr/base/gf/matrix2f.h"
@@ -14,7 +19,109 @@
 #include "pxr/base/gf/vec4f.h"
 #include "pxr/imaging/garch/glApi.h"
 USTC_CG_NAMESPACE_OPEN_SCOPE
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+namespace fs = std::filesystem;
+
+static GLuint link_program(const std::vector<std::pair<GLenum, const char*>>& sources)
+{
+    GLuint program = glCreateProgram();
+    for (auto& [type, code] : sources) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+// Used as the fallback of the first version of a program: every vertex lands outside the clip
+// volume, and the compute variant does nothing, until the real program is linked.
+static GLuint null_program(bool compute)
+{
+    if (compute) {
+        static GLuint program = link_program(
+            { { GL_COMPUTE_SHADER,
+                "#version 430 core\nlayout(local_size_x = 1) in;\nvoid main() { }\n" } });
+        return program;
+    }
+    static GLuint program = link_program(
+        { { GL_VERTEX_SHADER,
+            "#version 330 core\nvoid main() { gl_Position = vec4(2.0, 2.0, 2.0, 1.0); }\n" },
+          { GL_FRAGMENT_SHADER, "#version 330 core\nvoid main() { }\n" } });
+    return program;
+}
+
+static const char* stage_name(GLenum type)
+{
+    switch (type) {
+        case GL_VERTEX_SHADER: return "VERTEX";
+        case GL_FRAGMENT_SHADER: return "FRAGMENT";
+        default: return "COMPUTE";
+    }
+}
+
+static bool has_parallel_compile()
+{
+    static const bool supported = [] {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && strcmp(name, "GL_KHR_parallel_shader_compile") == 0) {
+                // Let the driver pick the number of compiler threads.
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+}
+
+// Program binaries are only valid for the driver that produced them.
+static std::uint64_t driver_hash()
+{
+    static const std::uint64_t hash = [] {
+        std::string id;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            auto str = reinterpret_cast<const char*>(glGetString(name));
+            id += str ? str : "";
+            id += '\n';
+        }
+        return std::uint64_t(std::hash<std::string>{}(id));
+    }();
+    return hash;
+}
+
+// Override with USTC_CG_SHADER_CACHE.
+static fs::path cache_directory()
+{
+    if (auto directory = std::getenv("USTC_CG_SHADER_CACHE")) {
+        return directory;
+    }
+    std::error_code error;
+    return fs::temp_directory_path(error) / "USTC_CG_shader_cache";
+}
+
+static fs::path cache_file(std::uint64_t key)
+{
+    std::ostringstream name;
+    name << std::hex << key << ".bin";
+    return cache_directory() / name.str();
+}
+
+struct ProgramBinaryHeader {
+    std::uint32_t magic;
+    GLenum format;
+    std::uint64_t key;
+    std::uint64_t driver;
+    std::uint64_t length;
+};
+
+static constexpr std::uint32_t programBinaryMagic = 0x47534355;  // "UCSG"
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const Shader* fallback)
 {
     error_stream.clear();
     // 1. retrieve the vertex/fragment source code from filePath
@@ -43,100 +150,244 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     catch (std::ifstream::failure& e) {
         error_stream << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    build({ { GL_VERTEX_SHADER, vertexCode }, { GL_FRAGMENT_SHADER, fragmentCode } }, fallback);
+}
+
+Shader::Shader(const char* computePath, const Shader* fallback)
+{
+    error_stream.clear();
+    std::string computeCode;
+    std::ifstream cShaderFile;
+    cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+        cShaderFile.open(computePath);
+        std::stringstream cShaderStream;
+        cShaderStream << cShaderFile.rdbuf();
+        cShaderFile.close();
+        computeCode = cShaderStream.str();
+    }
+    catch (std::ifstream::failure& e) {
+        error_stream << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+    }
+    build({ { GL_COMPUTE_SHADER, computeCode } }, fallback);
+}
+
+void Shader::build(
+    const std::vector<std::pair<GLenum, std::string>>& sources,
+    const Shader* fallback)
+{
+    std::string key_source;
+    for (auto& [type, code] : sources) {
+        key_source += std::to_string(type) + '\0' + code + '\0';
+    }
+    std::uint64_t source_hash = std::hash<std::string>{}(key_source);
+    cache_key = source_hash ^ (driver_hash() + 0x9e3779b97f4a7c15ull + (source_hash << 6) +
+                               (source_hash >> 2));
+
+    ID = glCreateProgram();
+    if (loadBinary()) {
+        is_ready = true;
+        is_linked = true;
+        return;
+    }
+
+    const bool parallel = has_parallel_compile();
     // 2. compile shaders
-    unsigned int vertex, fragment;
-    // vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    // fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
+    for (auto& [type, code] : sources) {
+        const char* shaderCode = code.c_str();
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &shaderCode, NULL);
+        glCompileShader(shader);
+        glAttachShader(ID, shader);
+        stages.emplace_back(type, shader);
+    }
     // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
+
+    if (fallback && fallback->ready() && fallback->is_linked) {
+        fallback_program = fallback->ID;
+    }
+    else {
+        fallback_program = null_program(sources.front().first == GL_COMPUTE_SHADER);
+    }
+
+    // Without the extension, the status queries in finishLink() simply wait for the link.
+    if (!parallel) {
+        finishLink();
+    }
+}
+
+Shader::~Shader()
+{
+    for (auto& stage : stages) {
+        glDeleteShader(stage.second);
+    }
+    glDeleteProgram(ID);
+}
+
+bool Shader::ready() const
+{
+    if (!is_ready) {
+        GLint completed = GL_TRUE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+        if (completed) {
+            finishLink();
+        }
+    }
+    return is_ready;
+}
+
+void Shader::finishLink() const
+{
+    for (auto& stage : stages) {
+        checkCompileErrors(stage.second, stage_name(stage.first));
+    }
     checkCompileErrors(ID, "PROGRAM");
     // delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (auto& stage : stages) {
+        glDeleteShader(stage.second);
+    }
+    stages.clear();
+
+    GLint success;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    is_linked = success;
+    if (is_linked) {
+        saveBinary();
+    }
 
     error_string = error_stream.str();
     error_stream.clear();
+    is_ready = true;
+}
+
+bool Shader::loadBinary()
+{
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (!format_count) {
+        return false;
+    }
+
+    std::ifstream file(cache_file(cache_key), std::ios::binary);
+    ProgramBinaryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != programBinaryMagic || header.key != cache_key ||
+        header.driver != driver_hash()) {
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        return false;
+    }
+
+    // A driver update may still reject the binary, then the program is compiled from source.
+    glProgramBinary(ID, header.format, binary.data(), GLsizei(binary.size()));
+    GLint success;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    return success;
+}
+
+void Shader::saveBinary() const
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!length) {
+        return;
+    }
+    std::vector<char> binary(length);
+    ProgramBinaryHeader header = { programBinaryMagic, 0, cache_key, driver_hash(), 0 };
+    glGetProgramBinary(ID, length, &length, &header.format, binary.data());
+    header.length = length;
+
+    std::error_code error;
+    fs::create_directories(cache_directory(), error);
+    // Written aside and renamed, so that another process never reads a partial file.
+    auto path = cache_file(cache_key);
+    auto temporary = fs::path(path).concat(".tmp");
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            return;
+        }
+    }
+    fs::rename(temporary, path, error);
+}
+
+GLuint Shader::program() const
+{
+    return ready() ? ID : fallback_program;
 }
 
 void Shader::use() const
 {
-    glUseProgram(ID);
+    glUseProgram(program());
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(glGetUniformLocation(program(), name.c_str()), (int)value);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(glGetUniformLocation(program(), name.c_str()), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(glGetUniformLocation(program(), name.c_str()), value);
 }
 
 void Shader::setVec2(const std::string& name, const pxr::GfVec2f& value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform2fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]);
 }
 
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(glGetUniformLocation(program(), name.c_str()), x, y);
 }
 
 void Shader::setVec3(const std::string& name, const pxr::GfVec3f& value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(glGetUniformLocation(program(), name.c_str()), x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const pxr::GfVec4f& value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform4fv(glGetUniformLocation(program(), name.c_str()), 1, &value[0]);
 }
 
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(glGetUniformLocation(program(), name.c_str()), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const pxr::GfMatrix2f& mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string& name, const pxr::GfMatrix3f& mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string& name, const pxr::GfMatrix4f& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(program(), name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
-void Shader::checkCompileErrors(GLuint shader, std::string type)
+void Shader::checkCompileErrors(GLuint shader, std::string type) const
 {
     GLint success;
     GLchar infoLog[1024];
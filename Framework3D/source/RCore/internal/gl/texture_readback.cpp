@@ -0,0 +1,222 @@
+#include "RCore/internal/gl/texture_readback.hpp"
+
+#include <cstring>
+#include <memory>
+
+#include "Utils/Logging/Logging.h"
+#include "pxr/base/tf/stringUtils.h"
+#include "pxr/imaging/hio/image.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+TextureReadback texture_readback;
+
+static size_t channel_count(GLenum format)
+{
+    switch (format) {
+        case GL_RED:
+        case GL_RED_INTEGER:
+        case GL_DEPTH_COMPONENT: return 1;
+        case GL_RG:
+        case GL_RG_INTEGER: return 2;
+        case GL_RGB:
+        case GL_RGB_INTEGER: return 3;
+        default: return 4;
+    }
+}
+
+static size_t type_size(GLenum type)
+{
+    switch (type) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
+    }
+}
+
+TextureReadback::PackBuffer TextureReadback::acquire_buffer(size_t size)
+{
+    for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+        if (it->size == size) {
+            PackBuffer pack = *it;
+            free_buffers_.erase(it);
+            return pack;
+        }
+    }
+    PackBuffer pack = { 0, size };
+    glCreateBuffers(1, &pack.buffer);
+    glNamedBufferStorage(pack.buffer, size, nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+    return pack;
+}
+
+void TextureReadback::request(
+    GLuint texture,
+    int width,
+    int height,
+    GLenum format,
+    GLenum type,
+    ReadbackCallback callback)
+{
+    if (!framebuffer_) {
+        glCreateFramebuffers(1, &framebuffer_);
+    }
+    const GLenum attachment =
+        format == GL_DEPTH_COMPONENT ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0;
+    glNamedFramebufferTexture(framebuffer_, attachment, texture, 0);
+    glNamedFramebufferReadBuffer(
+        framebuffer_, attachment == GL_COLOR_ATTACHMENT0 ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+
+    Pending pending;
+    pending.pack = acquire_buffer(size_t(width) * height * channel_count(format) * type_size(type));
+    pending.frame = frame_;
+    pending.image.width = width;
+    pending.image.height = height;
+    pending.image.format = format;
+    pending.image.type = type;
+    pending.callback = std::move(callback);
+
+    GLint read_framebuffer, alignment;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pending.pack.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // With a pack buffer bound this only queues the copy.
+    glReadPixels(0, 0, width, height, format, type, nullptr);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+    glNamedFramebufferTexture(framebuffer_, attachment, 0, 0);
+
+    pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending_.push_back(std::move(pending));
+}
+
+std::future<ReadbackImage>
+TextureReadback::request(GLuint texture, int width, int height, GLenum format, GLenum type)
+{
+    auto promise = std::make_shared<std::promise<ReadbackImage>>();
+    auto future = promise->get_future();
+    request(texture, width, height, format, type, [promise](ReadbackImage& image) {
+        promise->set_value(std::move(image));
+    });
+    return future;
+}
+
+void TextureReadback::request_to_file(
+    GLuint texture,
+    int width,
+    int height,
+    const std::string& path)
+{
+    auto extension = TfStringToLower(TfGetExtension(path));
+    const bool hdr = extension == "exr" || extension == "hdr";
+
+    request(
+        texture,
+        width,
+        height,
+        GL_RGBA,
+        hdr ? GL_FLOAT : GL_UNSIGNED_BYTE,
+        [this, path, hdr](ReadbackImage& image) {
+            // Encoding takes longer than a frame, keep it off the GL thread.
+            writers_.Run([path, hdr, image = std::move(image)]() {
+                auto output = HioImage::OpenForWriting(path);
+                HioImage::StorageSpec storageSpec;
+                storageSpec.width = image.width;
+                storageSpec.height = image.height;
+                storageSpec.format = hdr ? HioFormatFloat32Vec4 : HioFormatUNorm8Vec4;
+                storageSpec.flipped = true;
+                storageSpec.data = const_cast<unsigned char*>(image.pixels.data());
+                if (!output || !output->Write(storageSpec)) {
+                    logging("Failed to write " + path, Warning);
+                }
+            });
+        });
+}
+
+void TextureReadback::complete(Pending& pending)
+{
+    while (glClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) ==
+           GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(pending.fence);
+
+    auto& image = pending.image;
+    image.pixels.resize(pending.pack.size);
+    auto mapped = glMapNamedBufferRange(pending.pack.buffer, 0, pending.pack.size, GL_MAP_READ_BIT);
+    if (mapped) {
+        memcpy(image.pixels.data(), mapped, pending.pack.size);
+        glUnmapNamedBuffer(pending.pack.buffer);
+    }
+
+    if (free_buffers_.size() == maxFreeBuffers) {
+        glDeleteBuffers(1, &free_buffers_.front().buffer);
+        free_buffers_.erase(free_buffers_.begin());
+    }
+    free_buffers_.push_back(pending.pack);
+
+    pending.callback(image);
+}
+
+void TextureReadback::update()
+{
+    ++frame_;
+    // Fences signal in submission order, so the first copy still in flight ends the scan.
+    while (!pending_.empty()) {
+        auto& front = pending_.front();
+        GLenum status = glClientWaitSync(front.fence, 0, 0);
+        bool landed = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+        if (!landed && frame_ - front.frame < frameLatency) {
+            break;
+        }
+        // Callbacks may issue new requests.
+        Pending pending = std::move(front);
+        pending_.pop_front();
+        complete(pending);
+    }
+}
+
+void TextureReadback::flush()
+{
+    while (!pending_.empty()) {
+        Pending pending = std::move(pending_.front());
+        pending_.pop_front();
+        complete(pending);
+    }
+}
+
+void TextureReadback::release()
+{
+    flush();
+    writers_.Wait();
+    for (auto& pack : free_buffers_) {
+        glDeleteBuffers(1, &pack.buffer);
+    }
+    free_buffers_.clear();
+    glDeleteFramebuffers(1, &framebuffer_);
+    framebuffer_ = 0;
+}
+
+std::string frame_file_path(const std::string& pattern, int frame)
+{
+    const size_t first = pattern.find('#');
+    if (first == std::string::npos) {
+        return pattern;
+    }
+    size_t last = pattern.find_first_not_of('#', first);
+    if (last == std::string::npos) {
+        last = pattern.size();
+    }
+    return pattern.substr(0, first) +
+           pxr::TfStringPrintf("%0*d", static_cast<int>(last - first), frame) +
+           pattern.substr(last);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
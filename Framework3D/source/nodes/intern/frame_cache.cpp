@@ -0,0 +1,216 @@
+#include "Nodes/frame_cache.hpp"
+
+#include "USTC_CG.h"
+#include "Utils/Logging/Logging.h"
+#include "pxr/base/gf/vec2f.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/copyUtils.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/sdf/schema.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static size_t value_bytes(const pxr::VtValue& value)
+{
+    if (!value.IsArrayValued()) {
+        return sizeof(pxr::VtValue);
+    }
+    size_t element_bytes = 16;
+    if (value.IsHolding<pxr::VtArray<pxr::GfVec3f>>()) {
+        element_bytes = sizeof(pxr::GfVec3f);
+    }
+    else if (value.IsHolding<pxr::VtArray<pxr::GfVec2f>>()) {
+        element_bytes = sizeof(pxr::GfVec2f);
+    }
+    else if (value.IsHolding<pxr::VtArray<int>>() || value.IsHolding<pxr::VtArray<float>>()) {
+        element_bytes = 4;
+    }
+    return value.GetArraySize() * element_bytes;
+}
+
+static size_t layer_bytes(const pxr::SdfLayerRefPtr& layer, const pxr::SdfPath& root)
+{
+    size_t bytes = 0;
+    layer->Traverse(root, [&](const pxr::SdfPath& path) {
+        if (!path.IsPropertyPath()) {
+            return;
+        }
+        pxr::VtValue value;
+        if (layer->HasField(path, pxr::SdfFieldKeys->Default, &value)) {
+            bytes += value_bytes(value);
+        }
+        for (double time : layer->ListTimeSamplesForPath(path)) {
+            if (layer->QueryTimeSample(path, time, &value)) {
+                bytes += value_bytes(value);
+            }
+        }
+    });
+    return bytes;
+}
+
+// Replaces the specs at root in destination with the ones in source.
+static void replace_specs(
+    const pxr::SdfLayerHandle& source,
+    const pxr::SdfLayerHandle& destination,
+    const pxr::SdfPath& root)
+{
+    pxr::SdfChangeBlock change_block;
+    if (auto existing = destination->GetPrimAtPath(root)) {
+        auto parent = destination->GetPrimAtPath(root.GetParentPath());
+        parent->RemoveNameChild(existing);
+    }
+    pxr::SdfCopySpec(source, root, destination, root);
+}
+
+SimulationFrameCache::SimulationFrameCache(
+    const pxr::SdfPath& root,
+    size_t budget_bytes,
+    std::filesystem::path directory)
+    : root_(root),
+      budget_bytes_(budget_bytes),
+      directory_(std::move(directory))
+{
+}
+
+SimulationFrameCache::~SimulationFrameCache()
+{
+    clear();
+}
+
+void SimulationFrameCache::store(float time_code, const pxr::UsdStageRefPtr& stage)
+{
+    auto source = stage->GetRootLayer();
+    if (!source->GetPrimAtPath(root_)) {
+        return;
+    }
+
+    auto found = frames_.find(time_code);
+    if (found != frames_.end()) {
+        erase(found);
+    }
+
+    auto layer = pxr::SdfLayer::CreateAnonymous();
+    if (!pxr::SdfCopySpec(source, root_, layer, root_)) {
+        logging("Failed to snapshot the frame at time code " + std::to_string(time_code), Warning);
+        return;
+    }
+
+    auto& frame = frames_[time_code];
+    frame.layer = layer;
+    frame.bytes = layer_bytes(layer, root_);
+    frame.last_used = ++use_counter_;
+    statistics_.bytes += frame.bytes;
+    statistics_.frames = frames_.size();
+    shown_ = &frame;
+
+    evict_to_budget(&frame);
+}
+
+bool SimulationFrameCache::restore(float time_code, const pxr::UsdStageRefPtr& stage)
+{
+    auto found = frames_.upper_bound(time_code);
+    if (found == frames_.begin()) {
+        return false;
+    }
+    auto& frame = std::prev(found)->second;
+    if (&frame == shown_) {
+        return true;
+    }
+
+    auto layer = load(frame);
+    if (!layer) {
+        erase(std::prev(found));
+        return false;
+    }
+    frame.last_used = ++use_counter_;
+    replace_specs(layer, stage->GetRootLayer(), root_);
+    shown_ = &frame;
+
+    evict_to_budget(&frame);
+    return true;
+}
+
+void SimulationFrameCache::clear()
+{
+    // Release the layers before deleting their files, which may still be mapped.
+    frames_.clear();
+    shown_ = nullptr;
+    statistics_ = {};
+
+    std::error_code error;
+    std::filesystem::remove_all(directory_, error);
+}
+
+void SimulationFrameCache::set_budget(size_t budget_bytes)
+{
+    budget_bytes_ = budget_bytes;
+    evict_to_budget(shown_);
+}
+
+pxr::SdfLayerRefPtr SimulationFrameCache::load(Frame& frame)
+{
+    if (!frame.layer) {
+        frame.layer = pxr::SdfLayer::FindOrOpen(frame.file.string());
+        if (!frame.layer) {
+            logging("Failed to open cached frame " + frame.file.string(), Error);
+            return nullptr;
+        }
+        frame.bytes = layer_bytes(frame.layer, root_);
+        statistics_.bytes += frame.bytes;
+    }
+    return frame.layer;
+}
+
+void SimulationFrameCache::evict_to_budget(const Frame* keep)
+{
+    while (statistics_.bytes > budget_bytes_) {
+        auto oldest = frames_.end();
+        for (auto it = frames_.begin(); it != frames_.end(); ++it) {
+            if (it->second.layer && &it->second != keep &&
+                (oldest == frames_.end() || it->second.last_used < oldest->second.last_used)) {
+                oldest = it;
+            }
+        }
+        if (oldest == frames_.end()) {
+            return;
+        }
+
+        auto& frame = oldest->second;
+        if (frame.file.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(directory_, error);
+            auto file = directory_ / ("frame_" + std::to_string(file_counter_++) + ".usdc");
+            if (!frame.layer->Export(file.string())) {
+                logging("Failed to write cached frame " + file.string(), Warning);
+                erase(oldest);
+                continue;
+            }
+            frame.file = file;
+            ++statistics_.frames_on_disk;
+        }
+        statistics_.bytes -= frame.bytes;
+        frame.bytes = 0;
+        frame.layer = nullptr;
+    }
+}
+
+void SimulationFrameCache::erase(std::map<float, Frame>::iterator frame)
+{
+    if (&frame->second == shown_) {
+        shown_ = nullptr;
+    }
+    statistics_.bytes -= frame->second.bytes;
+    auto file = std::move(frame->second.file);
+    frames_.erase(frame);
+    statistics_.frames = frames_.size();
+
+    if (!file.empty()) {
+        std::error_code error;
+        std::filesystem::remove(file, error);
+        --statistics_.frames_on_disk;
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
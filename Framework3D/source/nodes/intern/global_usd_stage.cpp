@@ -1,7 +1,28 @@
 #include "Nodes/GlobalUsdStage.h"
 
+#include <vector>
+
 USTC_CG_NAMESPACE_OPEN_SCOPE
 pxr::UsdStageRefPtr GlobalUsdStage::global_usd_stage =
     pxr::UsdStage::CreateInMemory();
+std::set<pxr::SdfPath> GlobalUsdStage::written_prims;
+
+static std::vector<std::function<void()>>& simulation_stopped_callbacks()
+{
+    static std::vector<std::function<void()>> callbacks;
+    return callbacks;
+}
+
+void GlobalUsdStage::on_simulation_stopped(std::function<void()> callback)
+{
+    simulation_stopped_callbacks().push_back(std::move(callback));
+}
+
+void GlobalUsdStage::simulation_stopped()
+{
+    for (auto& callback : simulation_stopped_callbacks()) {
+        callback();
+    }
+}
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
\ No newline at end of file
@@ -1,35 +1,52 @@
 #include "Nodes/node_exec.hpp"
 
+#include <cstring>
+
 #include "Nodes/node.hpp"
 #include "Nodes/pin.hpp"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
-int ExeParams::get_input_index(const char* identifier) const
+// Nodes pass string literals, so after the first lookup the address of the identifier finds its
+// socket. The text is still compared, another string may come at the same address.
+static int find_socket_index(
+    const std::vector<NodeSocket*>& sockets,
+    std::vector<std::pair<const char*, int>>& cache,
+    const char* identifier)
 {
-    int counter = 0;
-    for (NodeSocket* socket : node_.inputs) {
-        if (std::string(socket->identifier) == identifier) {
-            return counter;
+    for (auto&& [cached_identifier, index] : cache) {
+        if (cached_identifier == identifier && index < sockets.size() &&
+            strcmp(sockets[index]->identifier, identifier) == 0) {
+            return index;
+        }
+    }
+
+    for (int i = 0; i < sockets.size(); ++i) {
+        if (strcmp(sockets[i]->identifier, identifier) == 0) {
+            // Identifiers built at run time would make it grow without bound.
+            if (cache.size() > 2 * sockets.size()) {
+                cache.clear();
+            }
+            cache.emplace_back(identifier, i);
+            return i;
         }
-        counter++;
     }
-    assert(false);
     return -1;
 }
 
+int ExeParams::get_input_index(const char* identifier) const
+{
+    int index = find_socket_index(node_.inputs, node_.input_index_cache, identifier);
+    assert(index >= 0);
+    return index;
+}
+
 int ExeParams::get_output_index(const char* identifier)
 {
-    int counter = 0;
-    for (NodeSocket* socket : node_.outputs) {
-        if (std::string(socket->identifier) == identifier) {
-            return counter;
-        }
-        counter++;
-    }
+    int index = find_socket_index(node_.outputs, node_.output_index_cache, identifier);
     // If code runs here, please check whether your get_input/set_output
     // identifier match with your declaration
-    assert(false);
-    return -1;
+    assert(index >= 0);
+    return index;
 }
 
 USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,233 @@
+#include "Nodes/node_exec_cache.hpp"
+
+#include <algorithm>
+#include <set>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/PointsComponent.h"
+#include "Nodes/node_tree.hpp"
+#include "USTC_CG.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static void hash_combine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+static size_t default_value_hash(NodeSocket* socket)
+{
+    void* value = default_value_storage(socket);
+    switch (socket->type_info->type) {
+        case SocketType::Int: return std::hash<int>()(*static_cast<int*>(value));
+        case SocketType::Float: return std::hash<float>()(*static_cast<float*>(value));
+        case SocketType::String:
+            // The text field edits the buffer in place, the string ends at the first null.
+            return std::hash<std::string>()(static_cast<std::string*>(value)->c_str());
+        default: return 0;
+    }
+}
+
+template<typename T>
+static size_t array_bytes(const pxr::VtArray<T>& array)
+{
+    return array.size() * sizeof(T);
+}
+
+template<typename... T>
+static size_t vt_array_bytes(const GMutablePointer& value)
+{
+    size_t bytes = 0;
+    ((value.is_type<pxr::VtArray<T>>() ? bytes = array_bytes(*value.get<pxr::VtArray<T>>()) : 0),
+     ...);
+    return bytes;
+}
+
+// Shallow size plus the arrays of the known payloads. VtArray shares its storage between copies,
+// so this is an upper bound of what the cache keeps alive.
+static size_t estimate_bytes(const GMutablePointer& value)
+{
+    size_t bytes = value.type()->size();
+    if (value.is_type<GOperandBase>()) {
+        for (auto&& component : value.get<GOperandBase>()->get_components()) {
+            if (auto mesh = std::dynamic_pointer_cast<MeshComponent>(component)) {
+                bytes += array_bytes(mesh->vertices) + array_bytes(mesh->faceVertexCounts) +
+                         array_bytes(mesh->faceVertexIndices) + array_bytes(mesh->normals) +
+                         array_bytes(mesh->texcoordsArray) + array_bytes(mesh->displayColor);
+            }
+            else if (auto points = std::dynamic_pointer_cast<PointsComponent>(component)) {
+                bytes += array_bytes(points->vertices) + array_bytes(points->width) +
+                         array_bytes(points->displayColor);
+            }
+        }
+    }
+    else {
+        bytes += vt_array_bytes<
+            float,
+            int,
+            pxr::GfVec2f,
+            pxr::GfVec3f,
+            pxr::GfVec4f,
+            pxr::GfVec2i,
+            pxr::GfVec3i,
+            pxr::GfVec4i>(value);
+    }
+    return bytes;
+}
+
+NodeOutputCache::~NodeOutputCache()
+{
+    clear();
+}
+
+bool NodeOutputCache::is_cacheable(const Node* node) const
+{
+    if (node->typeinfo->ALWAYS_REQUIRED || !node->typeinfo->CACHE_OUTPUTS ||
+        node->outputs.empty()) {
+        return false;
+    }
+    return std::all_of(node->outputs.begin(), node->outputs.end(), [](NodeSocket* output) {
+        auto type = output->type_info->cpp_type;
+        return !type->is<GMutablePointer>() && type->is_copy_constructible() &&
+               type->is_copy_assignable();
+    });
+}
+
+size_t NodeOutputCache::compute_key(const Node* node) const
+{
+    size_t key = std::hash<const void*>()(node->typeinfo);
+    for (auto input : node->inputs) {
+        if (!input->directly_linked_sockets.empty()) {
+            auto output = input->directly_linked_sockets[0];
+            auto& outputs = output->Node->outputs;
+            auto upstream = entries_.find(output->Node);
+            hash_combine(key, upstream != entries_.end() ? upstream->second.version : 0);
+            hash_combine(key, std::find(outputs.begin(), outputs.end(), output) - outputs.begin());
+        }
+        else if (input->default_value) {
+            hash_combine(key, default_value_hash(input));
+        }
+        else {
+            hash_combine(key, 0);
+        }
+    }
+    return key;
+}
+
+bool NodeOutputCache::lookup(
+    const Node* node,
+    size_t key,
+    const std::vector<GMutablePointer>& outputs)
+{
+    auto found = entries_.find(node);
+    if (found == entries_.end() || found->second.key != key || found->second.outputs.empty()) {
+        return false;
+    }
+    auto& entry = found->second;
+    assert(entry.outputs.size() == outputs.size());
+    for (int i = 0; i < outputs.size(); ++i) {
+        outputs[i].type()->copy_assign(entry.outputs[i].get(), outputs[i].get());
+    }
+    entry.last_used = ++use_counter_;
+    statistics_.hits++;
+    return true;
+}
+
+void NodeOutputCache::store(
+    const Node* node,
+    size_t key,
+    const std::vector<GMutablePointer>& outputs)
+{
+    auto& entry = entries_[node];
+    release_outputs(entry);
+    // Evicted outputs recomputed from the same key are the same, the nodes downstream stay valid.
+    if (entry.version == 0 || entry.key != key) {
+        entry.key = key;
+        entry.version = ++version_counter_;
+    }
+    statistics_.recomputes++;
+
+    for (auto&& output : outputs) {
+        auto type = output.type();
+        GMutablePointer copy{ type, malloc(type->size()) };
+        type->copy_construct(output.get(), copy.get());
+        entry.outputs.push_back(copy);
+        entry.bytes += estimate_bytes(copy);
+    }
+    entry.last_used = ++use_counter_;
+    statistics_.bytes += entry.bytes;
+
+    evict_to_budget();
+}
+
+void NodeOutputCache::invalidate(const Node* node)
+{
+    auto& entry = entries_[node];
+    release_outputs(entry);
+    entry.key = 0;
+    entry.version = ++version_counter_;
+    statistics_.recomputes++;
+}
+
+void NodeOutputCache::prune(const NodeTree* tree)
+{
+    std::set<const Node*> alive;
+    for (auto&& node : tree->nodes) {
+        alive.insert(node.get());
+    }
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+        if (!alive.contains(iter->first)) {
+            release_outputs(iter->second);
+            iter = entries_.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+}
+
+void NodeOutputCache::clear()
+{
+    for (auto&& entry : entries_) {
+        release_outputs(entry.second);
+    }
+    entries_.clear();
+}
+
+void NodeOutputCache::set_budget(size_t budget_bytes)
+{
+    budget_bytes_ = budget_bytes;
+    evict_to_budget();
+}
+
+void NodeOutputCache::release_outputs(Entry& entry)
+{
+    for (auto&& output : entry.outputs) {
+        output.destruct();
+        free(output.get());
+    }
+    entry.outputs.clear();
+    statistics_.bytes -= entry.bytes;
+    entry.bytes = 0;
+}
+
+// The most recently stored outputs go last, so outputs larger than the whole budget are not kept.
+void NodeOutputCache::evict_to_budget()
+{
+    while (statistics_.bytes > budget_bytes_) {
+        Entry* oldest = nullptr;
+        for (auto&& entry : entries_) {
+            if (!entry.second.outputs.empty() &&
+                (!oldest || entry.second.last_used < oldest->last_used)) {
+                oldest = &entry.second;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        release_outputs(*oldest);
+        statistics_.evictions++;
+    }
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
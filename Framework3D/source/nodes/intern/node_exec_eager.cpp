@@ -1,5 +1,7 @@
 #include "Nodes/node_exec_eager.hpp"
 
+#include <algorithm>
+
 #include "Nodes/node_tree.hpp"
 #include "USTC_CG.h"
 // #include "Utils/Functions/GenericPointer_.hpp"
@@ -12,22 +14,28 @@ ExeParams EagerNodeTreeExecutor::prepare_params(NodeTree* tree, Node* node)
     node->MISSING_INPUT = false;
 
     ExeParams params{ *node };
+    params.inputs_movable_ = take_inputs_by_move;
     for (auto&& input : node->inputs) {
         GMutablePointer input_ptr;
 
-        if (input_states[index_cache[input]].is_forwarded) {
+        if (input_states[index_cache.at(input)].is_forwarded) {
             // Is set by previous node
-            input_ptr = input_states[index_cache[input]].value;
+            input_ptr = input_states[index_cache.at(input)].value;
         }
         else if (input->directly_linked_sockets.empty() && input->default_value) {
             // Has default value
-            input_states[index_cache[input]].value.type()->copy_construct(
-                default_value_storage(input), input_states[index_cache[input]].value.get());
-            input_ptr = input_states[index_cache[input]].value;
+            input_states[index_cache.at(input)].value.type()->copy_construct(
+                default_value_storage(input), input_states[index_cache.at(input)].value.get());
+            input_ptr = input_states[index_cache.at(input)].value;
+        }
+        else if (input->directly_linked_sockets.empty() && input->optional) {
+            // Left empty on purpose
+            input_ptr = input_states[index_cache.at(input)].value;
+            input_ptr.type()->default_construct(input_ptr.get());
         }
         else {
             // Node not filled. Cannot run this node.
-            input_ptr = input_states[index_cache[input]].value;
+            input_ptr = input_states[index_cache.at(input)].value;
             input_ptr.type()->default_construct(input_ptr.get());
 
             node->MISSING_INPUT = true;
@@ -36,7 +44,7 @@ ExeParams EagerNodeTreeExecutor::prepare_params(NodeTree* tree, Node* node)
     }
 
     for (auto&& output : node->outputs) {
-        auto output_ptr = output_states[index_cache[output]].value;
+        auto output_ptr = output_states[index_cache.at(output)].value;
         params.outputs_.push_back(output_ptr);
     }
 
@@ -61,11 +69,58 @@ bool EagerNodeTreeExecutor::execute_node(NodeTree* tree, Node* node)
     return true;
 }
 
+// Same conditions as prepare_params: a cached node must not run where its execution would not.
+bool EagerNodeTreeExecutor::inputs_available(Node* node)
+{
+    return std::all_of(node->inputs.begin(), node->inputs.end(), [this](NodeSocket* input) {
+        return input_states[index_cache.at(input)].is_forwarded ||
+               (input->directly_linked_sockets.empty() &&
+                (input->default_value || input->optional));
+    });
+}
+
+bool EagerNodeTreeExecutor::execute_node_cached(NodeTree* tree, Node* node)
+{
+    // Nodes may execute concurrently, the calls to the cache are serialized but not the nodes.
+    std::unique_lock lock(output_cache_mutex_);
+    if (!output_cache_->is_cacheable(node) || !inputs_available(node)) {
+        lock.unlock();
+        auto result = execute_node(tree, node);
+        lock.lock();
+        output_cache_->invalidate(node);
+        return result;
+    }
+
+    std::vector<GMutablePointer> outputs;
+    for (auto&& output : node->outputs) {
+        outputs.push_back(output_states[index_cache.at(output)].value);
+    }
+
+    auto key = output_cache_->compute_key(node);
+    if (output_cache_->lookup(node, key, outputs)) {
+        node->MISSING_INPUT = false;
+        node->execution_failed = {};
+        return true;
+    }
+
+    lock.unlock();
+    auto result = execute_node(tree, node);
+    lock.lock();
+    // Stored before forwarding, which moves the outputs into the last inputs.
+    if (result) {
+        output_cache_->store(node, key, outputs);
+    }
+    else {
+        output_cache_->invalidate(node);
+    }
+    return result;
+}
+
 void EagerNodeTreeExecutor::forward_output_to_input(Node* node)
 {
     for (auto&& output : node->outputs) {
         if (output->directly_linked_sockets.empty()) {
-            auto& output_state = output_states[index_cache[output]];
+            auto& output_state = output_states[index_cache.at(output)];
             assert(output_state.is_last_used == false);
             output_state.is_last_used = true;
         }
@@ -77,13 +132,13 @@ void EagerNodeTreeExecutor::forward_output_to_input(Node* node)
 
                 if (index_cache.find(directly_linked_input_socket) != index_cache.end()) {
                     if (directly_linked_input_socket->Node->REQUIRED) {
-                        last_used_id =
-                            std::max(last_used_id, int(index_cache[directly_linked_input_socket]));
+                        last_used_id = std::max(
+                            last_used_id, int(index_cache.at(directly_linked_input_socket)));
                     }
 
-                    auto& input_state = input_states[index_cache[directly_linked_input_socket]];
+                    auto& input_state = input_states[index_cache.at(directly_linked_input_socket)];
 
-                    auto& output_state = output_states[index_cache[output]];
+                    auto& output_state = output_states[index_cache.at(output)];
 
                     auto cpp_type = output->type_info->cpp_type;
                     auto is_last_target = i == output->directly_linked_sockets.size() - 1;
@@ -110,7 +165,7 @@ void EagerNodeTreeExecutor::forward_output_to_input(Node* node)
                 }
             }
             if (last_used_id == -1) {
-                output_states[index_cache[output]].is_last_used = true;
+                output_states[index_cache.at(output)].is_last_used = true;
             }
             else {
                 assert(input_states[last_used_id].is_last_used == false);
@@ -238,6 +293,9 @@ void EagerNodeTreeExecutor::prepare_tree(NodeTree* tree)
     clear();
 
     compile(tree);
+    if (output_cache_) {
+        output_cache_->prune(tree);
+    }
 
     input_states.resize(input_of_nodes_to_execute.size(), { nullptr, false });
     output_states.resize(output_of_nodes_to_execute.size(), { nullptr });
@@ -249,13 +307,23 @@ void EagerNodeTreeExecutor::execute_tree(NodeTree* tree)
 {
     for (int i = 0; i < nodes_to_execute_count; ++i) {
         auto node = nodes_to_execute[i];
-        auto result = execute_node(tree, node);
+        auto result = output_cache_ ? execute_node_cached(tree, node) : execute_node(tree, node);
         if (result) {
             forward_output_to_input(node);
         }
     }
 }
 
+void EagerNodeTreeExecutor::enable_output_cache(size_t budget_bytes)
+{
+    if (output_cache_) {
+        output_cache_->set_budget(budget_bytes);
+    }
+    else {
+        output_cache_ = std::make_unique<NodeOutputCache>(budget_bytes);
+    }
+}
+
 GMutablePointer EagerNodeTreeExecutor::FindPtr(NodeSocket* socket)
 {
     GMutablePointer ptr;
@@ -0,0 +1,120 @@
+#include "Nodes/node_exec_parallel.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+
+#include "Nodes/node_tree.hpp"
+#include "USTC_CG.h"
+#include "pxr/base/work/dispatcher.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+void ParallelNodeTreeExecutor::execute_tree(NodeTree* tree)
+{
+    const int count = nodes_to_execute_count;
+
+    // A node waits for one completion per link into it. Upstream nodes are always required, and
+    // come first in the topological order.
+    std::map<Node*, int> position;
+    for (int i = 0; i < count; ++i) {
+        position[nodes_to_execute[i]] = i;
+    }
+    std::vector<std::vector<int>> successors(count);
+    std::vector<std::atomic<int>> pending(count);
+    for (int i = 0; i < count; ++i) {
+        for (auto input : nodes_to_execute[i]->inputs) {
+            for (auto linked_socket : input->directly_linked_sockets) {
+                auto upstream = position.find(linked_socket->Node);
+                if (upstream != position.end()) {
+                    successors[upstream->second].push_back(i);
+                    ++pending[i];
+                }
+            }
+        }
+    }
+
+    // The work dispatcher steals work between the worker threads. Nodes that are not thread safe
+    // are queued for this thread instead.
+    pxr::WorkDispatcher dispatcher;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<int> pinned;
+    int remaining = count;
+    // The first exception other than the runtime errors execute_node reports on the node, thrown
+    // again on this thread once every node has run.
+    std::exception_ptr exception;
+
+    std::function<void(int)> run;
+    auto schedule = [&](int i) {
+        if (nodes_to_execute[i]->typeinfo->THREAD_SAFE) {
+            dispatcher.Run([&run, i] { run(i); });
+        }
+        else {
+            std::lock_guard lock(mutex);
+            pinned.push_back(i);
+            condition.notify_one();
+        }
+    };
+
+    // A failed node still releases its successors, which then fail on their missing inputs just
+    // like in the sequential order.
+    run = [&](int i) {
+        auto node = nodes_to_execute[i];
+        try {
+            auto result =
+                output_cache_ ? execute_node_cached(tree, node) : execute_node(tree, node);
+            if (result) {
+                forward_output_to_input(node);
+            }
+        }
+        catch (...) {
+            std::lock_guard lock(mutex);
+            if (!exception) {
+                exception = std::current_exception();
+            }
+        }
+        for (int successor : successors[i]) {
+            if (--pending[successor] == 0) {
+                schedule(successor);
+            }
+        }
+        std::lock_guard lock(mutex);
+        if (--remaining == 0) {
+            condition.notify_one();
+        }
+    };
+
+    for (int i = 0; i < count; ++i) {
+        if (pending[i] == 0) {
+            schedule(i);
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    while (remaining > 0) {
+        condition.wait(lock, [&] { return !pinned.empty() || remaining == 0; });
+        while (!pinned.empty()) {
+            int i = pinned.front();
+            pinned.pop_front();
+            lock.unlock();
+            run(i);
+            lock.lock();
+        }
+    }
+    lock.unlock();
+    dispatcher.Wait();
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+std::unique_ptr<EagerNodeTreeExecutor> CreateParallelNodeTreeExecutor()
+{
+    return std::make_unique<ParallelNodeTreeExecutor>();
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
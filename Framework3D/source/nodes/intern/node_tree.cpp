@@ -420,6 +420,7 @@ void NodeTree::refresh_node_socket(
         new_socket = socket_declaration.build(this, node);
         sockets.emplace_back(new_socket);
     }
+    new_socket->optional = socket_declaration.optional;
     new_sockets.push_back(new_socket);
 }
 
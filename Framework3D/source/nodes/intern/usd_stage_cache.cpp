@@ -0,0 +1,154 @@
+#include "Nodes/usd_stage_cache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/usd/stageCache.h"
+#include "pxr/usd/usd/stagePopulationMask.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Stages are kept for the few most recently read files. Each holds its layers, so the budget is in
+// files rather than bytes.
+static constexpr size_t max_cached_stages = 8;
+
+struct CachedStage {
+    std::string file_name;
+    pxr::SdfPath prim_path;
+    std::filesystem::file_time_type modified;
+    pxr::UsdStageCache::Id id;
+    size_t last_used = 0;
+};
+
+struct CachedValue {
+    // The stage may be gone and its address reused.
+    pxr::UsdStagePtr stage;
+    pxr::UsdTimeCode sample;
+    pxr::VtValue value;
+};
+
+static std::mutex cache_mutex;
+static pxr::UsdStageCache stage_cache;
+static std::vector<CachedStage> cached_stages;
+static std::map<std::pair<const pxr::UsdStage*, pxr::SdfPath>, CachedValue> cached_values;
+static size_t use_counter = 0;
+
+static void drop_stage(std::vector<CachedStage>::iterator cached)
+{
+    if (auto stage = stage_cache.Find(cached->id)) {
+        std::erase_if(cached_values, [&](const auto& entry) {
+            return entry.first.first == stage.operator->();
+        });
+        stage_cache.Erase(cached->id);
+    }
+    cached_stages.erase(cached);
+}
+
+pxr::UsdStageRefPtr open_cached_stage(const std::string& file_name, const pxr::SdfPath& prim_path)
+{
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(file_name, error);
+    if (error) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(cache_mutex);
+
+    auto cached = std::find_if(cached_stages.begin(), cached_stages.end(), [&](const auto& c) {
+        return c.file_name == file_name && c.prim_path == prim_path;
+    });
+    if (cached != cached_stages.end()) {
+        if (cached->modified == modified) {
+            if (auto stage = stage_cache.Find(cached->id)) {
+                cached->last_used = ++use_counter;
+                return stage;
+            }
+        }
+        drop_stage(cached);
+    }
+
+    // The layer stays open while anything holds it. Reloading only reads it again if the file
+    // changed since it was read.
+    if (auto layer = pxr::SdfLayer::Find(file_name)) {
+        layer->Reload();
+    }
+
+    auto mask = prim_path.IsAbsoluteRootOrPrimPath() ? pxr::UsdStagePopulationMask().Add(prim_path)
+                                                     : pxr::UsdStagePopulationMask::All();
+    auto stage = pxr::UsdStage::OpenMasked(file_name, mask);
+    if (!stage) {
+        return nullptr;
+    }
+
+    if (cached_stages.size() >= max_cached_stages) {
+        drop_stage(std::min_element(
+            cached_stages.begin(), cached_stages.end(), [](const auto& a, const auto& b) {
+                return a.last_used < b.last_used;
+            }));
+    }
+    cached_stages.push_back(
+        { file_name, prim_path, modified, stage_cache.Insert(stage), ++use_counter });
+    return stage;
+}
+
+// The time the value of the attribute at time is read from: Default for the default value, the
+// earliest time for a value that does not vary, the sample it is held at, or time itself when it
+// is interpolated between two samples.
+static pxr::UsdTimeCode resolved_sample(const pxr::UsdAttribute& attribute, pxr::UsdTimeCode time)
+{
+    if (time.IsDefault()) {
+        return time;
+    }
+    if (!attribute.ValueMightBeTimeVarying()) {
+        return pxr::UsdTimeCode::EarliestTime();
+    }
+
+    double lower, upper;
+    bool has_samples = false;
+    if (!attribute.GetBracketingTimeSamples(time.GetValue(), &lower, &upper, &has_samples) ||
+        !has_samples) {
+        return pxr::UsdTimeCode::EarliestTime();
+    }
+    if (lower == upper ||
+        attribute.GetStage()->GetInterpolationType() == pxr::UsdInterpolationTypeHeld) {
+        return pxr::UsdTimeCode(lower);
+    }
+    return time;
+}
+
+bool read_cached_attribute(
+    const pxr::UsdAttribute& attribute,
+    pxr::UsdTimeCode time,
+    pxr::VtValue* value)
+{
+    if (!attribute) {
+        return false;
+    }
+
+    auto stage = attribute.GetStage();
+    auto sample = resolved_sample(attribute, time);
+    std::pair key(stage.operator->(), attribute.GetPath());
+    {
+        std::lock_guard lock(cache_mutex);
+        auto cached = cached_values.find(key);
+        if (cached != cached_values.end() && cached->second.stage == stage &&
+            cached->second.sample == sample) {
+            *value = cached->second.value;
+            return true;
+        }
+    }
+
+    if (!attribute.Get(value, time)) {
+        return false;
+    }
+
+    std::lock_guard lock(cache_mutex);
+    cached_values[key] = { stage, sample, *value };
+    return true;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
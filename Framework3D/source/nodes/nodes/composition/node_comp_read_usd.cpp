@@ -30,6 +30,8 @@ static void node_register()
     comp_node_type_base(&ntype);
     ntype.node_execute = node_exec;
     ntype.declare = node_declare;
+    // The file may change on disk, which the inputs do not show.
+    ntype.CACHE_OUTPUTS = false;
     nodeRegisterType(&ntype);
 }
 
@@ -9,6 +9,7 @@ inline void func_node_type_base(NodeTypeInfo* ntype)
     ntype->color[1] = 94 / 255.f;
     ntype->color[2] = 29 / 255.f;
     ntype->color[3] = 1.0f;
+    ntype->THREAD_SAFE = true;
 
     ntype->node_type_of_grpah = NodeTypeOfGrpah::Function;
 }
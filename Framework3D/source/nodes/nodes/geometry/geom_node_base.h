@@ -8,6 +8,7 @@ inline void geo_node_type_base(NodeTypeInfo* ntype)
     ntype->color[1] = 114 / 255.f;
     ntype->color[2] = 94 / 255.f;
     ntype->color[3] = 1.0f;
+    ntype->THREAD_SAFE = true;
 
     ntype->node_type_of_grpah = NodeTypeOfGrpah::Geometry;
 }
@@ -1,5 +1,6 @@
 #include "MassSpring.h"
 #include <iostream>
+#include <limits>
 
 namespace USTC_CG::node_mass_spring {
 MassSpring::MassSpring(const Eigen::MatrixXd& X, const EdgeSet& E)
@@ -43,6 +44,9 @@ void MassSpring::step()
         getSphereCollisionForce(sphere_center.cast<double>(), sphere_radius);
     //----------------------------------------------------
 
+    // Zero without a collider
+    Eigen::MatrixXd acceleration_mesh_collision = getMeshCollisionForce();
+
     if (time_integrator == IMPLICIT_EULER) {
         // Implicit Euler
         TIC(step)
@@ -53,6 +57,8 @@ void MassSpring::step()
         // compute Y 
 
         // Solve Newton's search direction with linear solver 
+        // (acceleration_mesh_collision is not applied here, add it to the external forces in Y
+        // once this integrator is implemented)
         
         // update X and vel 
 
@@ -69,6 +75,7 @@ void MassSpring::step()
         if (enable_sphere_collision) {
             acceleration += acceleration_collision;
         }
+        acceleration += acceleration_mesh_collision;
         // -----------------------------------------------
 
         // (HW TODO): Implement semi-implicit Euler time integration
@@ -166,6 +173,36 @@ Eigen::MatrixXd MassSpring::getSphereCollisionForce(Eigen::Vector3d center, doub
 }
 // ----------------------------------------------------------------------------------
 
+Eigen::MatrixXd MassSpring::getMeshCollisionForce()
+{
+    Eigen::MatrixXd force = Eigen::MatrixXd::Zero(X.rows(), X.cols());
+    if (!collider) {
+        return force;
+    }
+
+    pxr::VtArray<pxr::GfVec3f> points(X.rows());
+    for (int i = 0; i < X.rows(); i++) {
+        points[i] = pxr::GfVec3f(X(i, 0), X(i, 1), X(i, 2));
+    }
+    auto closest = collider->closest_points(points, std::numeric_limits<float>::infinity());
+
+    for (int i = 0; i < X.rows(); i++) {
+        if (closest[i].face < 0) {
+            continue;
+        }
+        // Signed distance along the normal of the closest face, negative behind it
+        const auto& p = closest[i].position;
+        const auto& n = closest[i].normal;
+        Eigen::Vector3d normal(n[0], n[1], n[2]);
+        Eigen::Vector3d offset = X.row(i).transpose() - Eigen::Vector3d(p[0], p[1], p[2]);
+        double distance = offset.dot(normal);
+        if (distance < collider_margin) {
+            force.row(i) = collision_penalty_k * (collider_margin - distance) * normal.transpose();
+        }
+    }
+    return force;
+}
+
 
 }  // namespace USTC_CG::node_mass_spring
 
@@ -3,6 +3,7 @@
 #include <Eigen/Sparse>
 #include <set>
 #include "utils.h"
+#include "../utils/util_spatial_query.h"
 #include <chrono>
 
 #define TIC(name) auto start_##name = std::chrono::high_resolution_clock::now(); 
@@ -53,6 +54,8 @@ class MassSpring {
 
     // Detect collision and compute the penalty-based collision force with given sphere
     Eigen::MatrixXd getSphereCollisionForce(Eigen::Vector3d center, double radius);
+    // Detect collision and compute the penalty-based collision force with the collider mesh
+    Eigen::MatrixXd getMeshCollisionForce();
 
     // Simulation parameters
     double stiffness = 1000.0;
@@ -69,6 +72,11 @@ class MassSpring {
     Eigen::Vector3f sphere_center = Eigen::Vector3f(0, -0.5, 0.2);
     double sphere_radius = 0.4;
 
+    // Collider mesh, set before every step so that it can move. Vertices closer to it than the
+    // margin, or behind it, are pushed out with collision_penalty_k.
+    std::shared_ptr<const MeshSpatialQuery> collider;
+    double collider_margin = 0.01;
+
     // Useful switches
     bool enable_sphere_collision = false;
     bool enable_time_profiling = false;
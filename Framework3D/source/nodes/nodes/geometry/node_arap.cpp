@@ -1,104 +1,200 @@
+#include <map>
+#include <mutex>
+
 #include "GCore/Components/MeshOperand.h"
 #include "Nodes/node.hpp"
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
 #include "geom_node_base.h"
-#include "utils/util_openmesh_bind.h"
+#include "utils/util_arap.h"
 
 /*
 ** @brief HW5_ARAP_Parameterization
 **
-** This file presents the basic framework of a "node", which processes inputs
-** received from the left and outputs specific variables for downstream nodes to
-** use.
-**
-** - In the first function, node_declare, you can set up the node's input and
-** output variables.
-**
-** - The second function, node_exec is the execution part of the node, where we
-** need to implement the node's functionality.
+** This file contains two nodes built on the as-rigid-as-possible energy:
+** - ARAP Parameterization computes UV coordinates for a triangle mesh with a
+** boundary, keeping each triangle as close to an isometry as possible.
+** - ARAP Deformation moves handle vertices to target positions, keeping the
+** neighborhood of each vertex as close to a rigid motion as possible.
 **
-** - The third function generates the node's registration information, which
-** eventually allows placing this node in the GUI interface.
-**
-** Your task is to fill in the required logic at the specified locations
-** within this template, especially in node_exec.
+** Both alternate a parallel local step, fitting rotations, with a global step
+** solving a Laplacian system whose factorization is cached for the mesh, so
+** an iteration costs one back-substitution. Each node starts from its own
+** previous result when it runs again on the same mesh, so editing a parameter
+** or dragging a handle converges in a few iterations.
 */
 
 namespace USTC_CG::node_arap {
+
+// The last result of each node, kept with the topology it was computed on.
+class WarmStarts {
+   public:
+    bool find(
+        const Node* node,
+        const std::shared_ptr<const HalfEdgeTopology>& topology,
+        Eigen::MatrixXd& value)
+    {
+        std::lock_guard lock(mutex_);
+        auto found = results_.find(node);
+        if (found == results_.end() || found->second.first.lock() != topology) {
+            return false;
+        }
+        value = found->second.second;
+        return true;
+    }
+
+    void store(
+        const Node* node,
+        const std::shared_ptr<const HalfEdgeTopology>& topology,
+        const Eigen::MatrixXd& value)
+    {
+        std::lock_guard lock(mutex_);
+        std::erase_if(results_, [](const auto& result) { return result.second.first.expired(); });
+        results_[node] = { topology, value };
+    }
+
+   private:
+    std::mutex mutex_;
+    std::map<const Node*, std::pair<std::weak_ptr<const HalfEdgeTopology>, Eigen::MatrixXd>>
+        results_;
+};
+
+static WarmStarts parameterization_warm_starts;
+static WarmStarts deformation_warm_starts;
+
+static pxr::VtArray<float> iteration_times(const ArapReport& report)
+{
+    return pxr::VtArray<float>(
+        report.iteration_milliseconds.begin(), report.iteration_milliseconds.end());
+}
+
 static void node_arap_declare(NodeDeclarationBuilder& b)
 {
     // Input-1: Original 3D mesh with boundary
-    // Maybe you need to add another input for initialization?
     b.add_input<decl::Geometry>("Input");
+    // Input-2: UV coordinates to start from, such as a Tutte parameterization. When it does not
+    // have one per vertex, the node starts from its previous result, or from a Tutte embedding.
+    b.add_input<decl::Float2Buffer>("Initial UV").optional();
 
-    /*
-    ** NOTE: You can add more inputs or outputs if necessary. For example, in
-    ** some cases, additional information (e.g. other mesh geometry, other 
-    ** parameters) is required to perform the computation.
-    **
-    ** Be sure that the input/outputs do not share the same name. You can add
-    ** one geometry as
-    **
-    **                b.add_input<decl::Geometry>("Input");
-    **
-    ** Or maybe you need a value buffer like:
-    **
-    **                b.add_input<decl::Float1Buffer>("Weights");
-    */
+    b.add_input<decl::Int>("Max Iterations").default_val(50).min(1).max(1000);
+    // Stop once an iteration lowers the energy by less than this fraction.
+    b.add_input<decl::Float>("Tolerance").default_val(0.0001f).min(0).max(0.01f);
 
     // Output-1: The UV coordinate of the mesh, provided by ARAP algorithm
     b.add_output<decl::Float2Buffer>("OutputUV");
+    // Output-2: The time each iteration took, in milliseconds
+    b.add_output<decl::Float1Buffer>("Iteration Times");
 }
 
 static void node_arap_exec(ExeParams params)
 {
     // Get the input from params
-    auto input = params.get_input<GOperandBase>("Input");
+    auto& input = params.get_input_ref<GOperandBase>("Input");
 
     // Avoid processing the node when there is no input
-    if (!input.get_component<MeshComponent>()) {
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
         throw std::runtime_error("Need Geometry Input.");
     }
-    throw std::runtime_error("Not implemented");
-
-    /* ----------------------------- Preprocess -------------------------------
-    ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-    ** half-edge data structure is a widely used data structure in geometric
-    ** processing, offering convenient operations for traversing and modifying
-    ** mesh elements.
-    */
-    auto halfedge_mesh = operand_to_openmesh(&input);
-
-   /* ------------- [HW5_TODO] ARAP Parameterization Implementation -----------
-   ** Implement ARAP mesh parameterization to minimize local distortion.
-   **
-   ** Steps:
-   ** 1. Initial Setup: Use a HW4 parameterization result as initial setup.
-   **
-   ** 2. Local Phase: For each triangle, compute local orthogonal approximation
-   **    (Lt) by computing SVD of Jacobian(Jt) with fixed u.
-   **
-   ** 3. Global Phase: With Lt fixed, update parameter coordinates(u) by solving
-   **    a pre-factored global sparse linear system.
-   **
-   ** 4. Iteration: Repeat Steps 2 and 3 to refine parameterization.
-   **
-   ** Note:
-   **  - Fixed points' selection is crucial for ARAP and ASAP.
-   **  - Encapsulate algorithms into classes for modularity.
-   */
-
-    // The result UV coordinates 
-    pxr::VtArray<pxr::GfVec2f> uv_result;
+
+    auto halfedge_mesh = mesh->half_edge_mesh();
+    ArapParameterization arap(halfedge_mesh);
+
+    const auto& initial_uv = params.get_input_ref<pxr::VtArray<pxr::GfVec2f>>("Initial UV");
+    Eigen::MatrixXd uv;
+    if (initial_uv.size() == halfedge_mesh->n_vertices()) {
+        uv.resize(initial_uv.size(), 2);
+        for (int v = 0; v < initial_uv.size(); ++v) {
+            uv.row(v) << initial_uv[v][0], initial_uv[v][1];
+        }
+    }
+    else if (!parameterization_warm_starts.find(&params.node_, halfedge_mesh.topology, uv)) {
+        uv = arap.initial_uv();
+    }
+
+    auto report = arap.solve(
+        uv, params.get_input<int>("Max Iterations"), params.get_input<float>("Tolerance"));
+    parameterization_warm_starts.store(&params.node_, halfedge_mesh.topology, uv);
+
+    // The result UV coordinates
+    pxr::VtArray<pxr::GfVec2f> uv_result(uv.rows());
+    for (int v = 0; v < uv.rows(); ++v) {
+        uv_result[v] = pxr::GfVec2f(uv(v, 0), uv(v, 1));
+    }
 
     // Set the output of the node
-    params.set_output("OutputUV", uv_result);
+    params.set_output("OutputUV", std::move(uv_result));
+    params.set_output("Iteration Times", iteration_times(report));
+}
+
+static void node_arap_deformation_declare(NodeDeclarationBuilder& b)
+{
+    // Input-1: Mesh in its rest pose
+    b.add_input<decl::Geometry>("Input");
+    // Input-2: Vertices to move, and where to
+    b.add_input<decl::Int1Buffer>("Handle Indices");
+    b.add_input<decl::Float3Buffer>("Handle Positions");
+
+    b.add_input<decl::Int>("Max Iterations").default_val(20).min(1).max(1000);
+    b.add_input<decl::Float>("Tolerance").default_val(0.0001f).min(0).max(0.01f);
+
+    // Output-1: Deformed mesh
+    b.add_output<decl::Geometry>("Output");
+    // Output-2: The time each iteration took, in milliseconds
+    b.add_output<decl::Float1Buffer>("Iteration Times");
+}
+
+static void node_arap_deformation_exec(ExeParams params)
+{
+    auto& input = params.get_input_ref<GOperandBase>("Input");
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("ARAP Deformation: Need Geometry Input.");
+    }
+
+    const auto& handles = params.get_input_ref<pxr::VtArray<int>>("Handle Indices");
+    const auto& targets = params.get_input_ref<pxr::VtArray<pxr::GfVec3f>>("Handle Positions");
+    if (handles.empty()) {
+        throw std::runtime_error("ARAP Deformation: Need handles.");
+    }
+    if (handles.size() != targets.size()) {
+        throw std::runtime_error("ARAP Deformation: Each handle needs a position.");
+    }
+
+    auto halfedge_mesh = mesh->half_edge_mesh();
+    ArapDeformation arap(halfedge_mesh, std::vector<int>(handles.begin(), handles.end()));
+
+    Eigen::MatrixXd positions;
+    if (!deformation_warm_starts.find(&params.node_, halfedge_mesh.topology, positions)) {
+        positions.resize(halfedge_mesh->n_vertices(), 3);
+        for (int v = 0; v < positions.rows(); ++v) {
+            const auto& position = halfedge_mesh.positions[v];
+            positions.row(v) << position[0], position[1], position[2];
+        }
+    }
+    for (int i = 0; i < handles.size(); ++i) {
+        positions.row(handles[i]) << targets[i][0], targets[i][1], targets[i][2];
+    }
+
+    auto report = arap.solve(
+        positions, params.get_input<int>("Max Iterations"), params.get_input<float>("Tolerance"));
+    deformation_warm_starts.store(&params.node_, halfedge_mesh.topology, positions);
+
+    auto& vertices = halfedge_mesh.positions;
+    for (int v = 0; v < vertices.size(); ++v) {
+        vertices[v] = pxr::GfVec3f(positions(v, 0), positions(v, 1), positions(v, 2));
+    }
+
+    GOperandBase output = input;
+    output.get_component<MeshComponent>()->vertices = vertices;
+
+    params.set_output("Output", std::move(output));
+    params.set_output("Iteration Times", iteration_times(report));
 }
 
 static void node_register()
 {
-    static NodeTypeInfo ntype;
+    static NodeTypeInfo ntype, ntype_deformation;
 
     strcpy(ntype.ui_name, "ARAP Parameterization");
     strcpy_s(ntype.id_name, "geom_arap");
@@ -106,7 +202,18 @@ static void node_register()
     geo_node_type_base(&ntype);
     ntype.node_execute = node_arap_exec;
     ntype.declare = node_arap_declare;
+    // Solves start from the result of the last execution, which the inputs do not show.
+    ntype.CACHE_OUTPUTS = false;
     nodeRegisterType(&ntype);
+
+    strcpy(ntype_deformation.ui_name, "ARAP Deformation");
+    strcpy_s(ntype_deformation.id_name, "geom_arap_deformation");
+
+    geo_node_type_base(&ntype_deformation);
+    ntype_deformation.node_execute = node_arap_deformation_exec;
+    ntype_deformation.declare = node_arap_deformation_declare;
+    ntype_deformation.CACHE_OUTPUTS = false;
+    nodeRegisterType(&ntype_deformation);
 }
 
 NOD_REGISTER_NODE(node_register)
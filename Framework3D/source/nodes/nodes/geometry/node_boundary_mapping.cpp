@@ -3,7 +3,6 @@
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
 #include "geom_node_base.h"
-#include "utils/util_openmesh_bind.h"
 
 /*
 ** @brief HW4_TutteParameterization
@@ -12,8 +11,8 @@
 ** convex closed curve (circle of square), setting the stage for subsequent Laplacian equation
 ** solution and mesh parameterization tasks.
 **
-** Key to this node's implementation is the adept manipulation of half-edge data structures
-** to identify and modify the boundary of the mesh.
+** Key to this node's implementation is the adept use of half-edge data structures to identify
+** the boundary of the mesh.
 **
 ** Task Overview:
 ** - The two execution functions (node_map_boundary_to_square_exec,
@@ -42,7 +41,7 @@ static void node_map_boundary_to_circle_declare(NodeDeclarationBuilder& b)
 static void node_map_boundary_to_circle_exec(ExeParams params)
 {
     // Get the input from params
-    auto input = params.get_input<GOperandBase>("Input");
+    auto& input = params.get_input_ref<GOperandBase>("Input");
 
     // (TO BE UPDATED) Avoid processing the node when there is no input
     if (!input.get_component<MeshComponent>()) {
@@ -51,12 +50,13 @@ static void node_map_boundary_to_circle_exec(ExeParams params)
     throw std::runtime_error("Not implemented");
 
     /* ----------------------------- Preprocess -------------------------------
-    ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-    ** half-edge data structure is a widely used data structure in geometric
-    ** processing, offering convenient operations for traversing and modifying
-    ** mesh elements.
+    ** Get the halfedge structure of the input mesh. The half-edge data
+    ** structure is a widely used data structure in geometric processing,
+    ** offering convenient operations for traversing mesh elements. It is built
+    ** once and cached on the mesh, and its positions are shared with the mesh
+    ** until they are written to.
     */
-    auto halfedge_mesh = operand_to_openmesh(&input);
+    auto halfedge_mesh = input.get_component<MeshComponent>()->half_edge_mesh();
 
     /* ----------- [HW4_TODO] TASK 2.1: Boundary Mapping (to circle) ------------
     ** In this task, you are required to map the boundary of the mesh to a circle
@@ -82,14 +82,10 @@ static void node_map_boundary_to_circle_exec(ExeParams params)
     */
 
     /* ----------------------------- Postprocess ------------------------------
-    ** Convert the result mesh from the halfedge structure back to GOperandBase format as the node's
-    ** output.
+    ** Write the new positions to a copy of the input as the node's output.
     */
-    auto operand_base = openmesh_to_operand(halfedge_mesh.get());
-
-    auto& output = input;
-    output.get_component<MeshComponent>()->vertices =
-        operand_base->get_component<MeshComponent>()->vertices;
+    GOperandBase output = input;
+    output.get_component<MeshComponent>()->vertices = halfedge_mesh.positions;
 
     // Set the output of the nodes
     params.set_output("Output", std::move(output));
@@ -112,7 +108,7 @@ static void node_map_boundary_to_square_declare(NodeDeclarationBuilder& b)
 static void node_map_boundary_to_square_exec(ExeParams params)
 {
     // Get the input from params
-    auto input = params.get_input<GOperandBase>("Input");
+    auto& input = params.get_input_ref<GOperandBase>("Input");
 
     // (TO BE UPDATED) Avoid processing the node when there is no input
     if (!input.get_component<MeshComponent>()) {
@@ -121,9 +117,9 @@ static void node_map_boundary_to_square_exec(ExeParams params)
     throw std::runtime_error("Not implemented");
 
     /* ----------------------------- Preprocess -------------------------------
-    ** Create a halfedge structure (using OpenMesh) for the input mesh.
+    ** Get the halfedge structure of the input mesh.
     */
-    auto halfedge_mesh = operand_to_openmesh(&input);
+    auto halfedge_mesh = input.get_component<MeshComponent>()->half_edge_mesh();
 
     /* ----------- [HW4_TODO] TASK 2.2: Boundary Mapping (to square) ------------
     ** In this task, you are required to map the boundary of the mesh to a circle
@@ -140,13 +136,13 @@ static void node_map_boundary_to_square_exec(ExeParams params)
     */
 
     /* ----------------------------- Postprocess ------------------------------
-    ** Convert the result mesh from the halfedge structure back to GOperandBase format as the node's
-    ** output.
+    ** Write the new positions to a copy of the input as the node's output.
     */
-    auto operand_base = openmesh_to_operand(halfedge_mesh.get());
+    GOperandBase output = input;
+    output.get_component<MeshComponent>()->vertices = halfedge_mesh.positions;
 
     // Set the output of the nodes
-    params.set_output("Output", std::move(*operand_base));
+    params.set_output("Output", std::move(output));
 }
 
 static void node_register()
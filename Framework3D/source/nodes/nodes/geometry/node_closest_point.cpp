@@ -0,0 +1,66 @@
+#include "GCore/Components/MeshOperand.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_spatial_query.h"
+
+namespace USTC_CG::node_closest_point {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Mesh");
+    b.add_input<decl::Float3Buffer>("Points");
+    b.add_input<decl::Float>("Max Distance").min(0).max(1000).default_val(100);
+
+    // For a point with no face within the distance: the point itself, a zero normal, an infinite
+    // distance and face -1.
+    b.add_output<decl::Float3Buffer>("Positions");
+    b.add_output<decl::Float3Buffer>("Normals");
+    b.add_output<decl::Float1Buffer>("Distances");
+    b.add_output<decl::Int1Buffer>("Faces");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& geometry = params.get_input_ref<GOperandBase>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("Closest Point: Need Geometry Input.");
+    }
+
+    const auto& points = params.get_input_ref<pxr::VtArray<pxr::GfVec3f>>("Points");
+
+    auto query = MeshSpatialQuery::get(mesh->half_edge_mesh());
+    auto closest = query->closest_points(points, params.get_input<float>("Max Distance"));
+
+    pxr::VtArray<pxr::GfVec3f> positions(closest.size()), normals(closest.size());
+    pxr::VtArray<float> distances(closest.size());
+    pxr::VtArray<int> faces(closest.size());
+    for (size_t i = 0; i < closest.size(); ++i) {
+        positions[i] = closest[i].face < 0 ? points[i] : closest[i].position;
+        normals[i] = closest[i].normal;
+        distances[i] = closest[i].distance;
+        faces[i] = closest[i].face;
+    }
+
+    params.set_output("Positions", std::move(positions));
+    params.set_output("Normals", std::move(normals));
+    params.set_output("Distances", std::move(distances));
+    params.set_output("Faces", std::move(faces));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Closest Point");
+    strcpy_s(ntype.id_name, "geom_closest_point");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_closest_point
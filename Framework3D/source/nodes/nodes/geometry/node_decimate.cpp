@@ -0,0 +1,85 @@
+#include "GCore/Components/MeshOperand.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_decimate.h"
+
+namespace USTC_CG::node_decimate {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Input");
+    b.add_input<decl::Int>("Target Triangles").default_val(1000).min(0).max(1000000);
+    // 0 does not bound the error, the target alone decides.
+    b.add_input<decl::Float>("Max Error").default_val(0.0f).min(0).max(1);
+    // The chain starts from the input, each level with Level Ratio times the triangles of the
+    // previous one.
+    b.add_input<decl::Int>("LOD Levels").default_val(4).min(1).max(16);
+    b.add_input<decl::Float>("Level Ratio").default_val(0.5f).min(0.05f).max(0.95f);
+
+    b.add_output<decl::Geometry>("Output");
+    // A mesh component per level, finest first, with the error of each level to the input.
+    b.add_output<decl::Geometry>("LOD");
+    b.add_output<decl::Float1Buffer>("LOD Errors");
+}
+
+static void node_exec(ExeParams params)
+{
+    const auto& input = params.get_input_ref<GOperandBase>("Input");
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("Decimate: Need Geometry Input.");
+    }
+
+    GOperandBase output = input;
+    decimate_mesh(
+        *mesh,
+        std::max(params.get_input<int>("Target Triangles"), 0),
+        params.get_input<float>("Max Error"),
+        *output.get_component<MeshComponent>());
+
+    // Each level is decimated from the previous one, so the errors add up.
+    GOperandBase lod;
+    lod.attach_component(mesh->copy(&lod));
+    pxr::VtArray<float> errors = { 0 };
+
+    const int levels = std::clamp(params.get_input<int>("LOD Levels"), 1, 16);
+    const float ratio = std::clamp(params.get_input<float>("Level Ratio"), 0.05f, 0.95f);
+    auto previous = mesh;
+    size_t triangles = 0;
+    for (int count : mesh->faceVertexCounts) {
+        triangles += std::max(count - 2, 0);
+    }
+    for (int level = 1; level < levels; ++level) {
+        auto level_mesh = std::make_shared<MeshComponent>(&lod);
+        auto report =
+            decimate_mesh(*previous, static_cast<size_t>(triangles * ratio), 0, *level_mesh);
+        if (report.triangle_count == triangles) {
+            break;
+        }
+        lod.attach_component(level_mesh);
+        errors.push_back(errors.back() + report.error);
+        previous = level_mesh;
+        triangles = report.triangle_count;
+    }
+
+    params.set_output("Output", std::move(output));
+    params.set_output("LOD", std::move(lod));
+    params.set_output("LOD Errors", std::move(errors));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Decimate");
+    strcpy_s(ntype.id_name, "geom_decimate");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_decimate
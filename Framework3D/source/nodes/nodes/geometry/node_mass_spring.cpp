@@ -94,6 +94,11 @@ static void node_mass_spring_declare(NodeDeclarationBuilder& b)
     b.add_input<decl::Float3>("sphere center");
     // -----------------------------------------------------------------------------------------------------------
 
+    // Optional collider mesh, which may move from frame to frame. Only the semi-implicit
+    // integrator applies its force.
+    b.add_input<decl::Geometry>("Collider").optional();
+    b.add_input<decl::Float>("collider margin").default_val(0.01).min(0.0).max(0.5);
+
     // Useful switches (0 or 1). You can add more if you like.
     b.add_input<decl::Int>("time integrator type").default_val(0).min(0).max(1); // 0 for implicit Euler, 1 for semi-implicit Euler
     b.add_input<decl::Int>("enable time profiling").default_val(0).min(0).max(1);
@@ -119,7 +124,7 @@ static void node_mass_spring_exec(ExeParams params)
 
     auto mass_spring = params.get_input<std::shared_ptr<MassSpring>>("Mass Spring");
 
-    auto geometry = params.get_input<GOperandBase>("Mesh");
+    auto geometry = params.take_input<GOperandBase>("Mesh");
     auto mesh = geometry.get_component<MeshComponent>();
     if (mesh->faceVertexCounts.size() == 0)
     {
@@ -174,13 +179,27 @@ static void node_mass_spring_exec(ExeParams params)
     }
     else  // otherwise, step forward the simulation
     {
+        // The spatial query is cached, a moving collider only refits it
+        const auto& collider = params.get_input_ref<GOperandBase>("Collider");
+        if (collider.get_components().empty()) {
+            mass_spring->collider = nullptr;
+        }
+        else {
+            auto collider_mesh = collider.get_component<MeshComponent>();
+            if (!collider_mesh) {
+                throw std::runtime_error("Mass Spring: Collider has no mesh.");
+            }
+            mass_spring->collider = MeshSpatialQuery::get(collider_mesh->half_edge_mesh());
+        }
+        mass_spring->collider_margin = params.get_input<float>("collider margin");
+
         mass_spring->step(); 
     }
 
     mesh->vertices = eigen_to_usd_vertices(mass_spring->getX());
 
     params.set_output("Mass Spring Class", mass_spring);
-    params.set_output("Output Mesh", geometry);
+    params.set_output("Output Mesh", std::move(geometry));
 }
 
 static void node_register()
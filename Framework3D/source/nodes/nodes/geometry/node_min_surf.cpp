@@ -3,7 +3,7 @@
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
 #include "geom_node_base.h"
-#include "utils/util_openmesh_bind.h"
+#include "utils/util_laplacian.h"
 
 /*
 ** @brief HW4_TutteParameterization
@@ -42,6 +42,9 @@ static void node_min_surf_declare(NodeDeclarationBuilder& b)
     **                b.add_input<decl::Float1Buffer>("Weights");
     */
 
+    // Input-2: Cotangent weights instead of uniform ones, for triangle meshes
+    b.add_input<decl::Int>("Cotangent Weights").default_val(0).min(0).max(1);
+
     // Output-1: Minimal surface with fixed boundary
     b.add_output<decl::Geometry>("Output");
 }
@@ -49,69 +52,68 @@ static void node_min_surf_declare(NodeDeclarationBuilder& b)
 static void node_min_surf_exec(ExeParams params)
 {
     // Get the input from params
-    auto input = params.get_input<GOperandBase>("Input");
+    auto& input = params.get_input_ref<GOperandBase>("Input");
 
-    // (TO BE UPDATED) Avoid processing the node when there is no input
-    if (!input.get_component<MeshComponent>()) {
+    // Avoid processing the node when there is no input
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
         throw std::runtime_error("Minimal Surface: Need Geometry Input.");
     }
-    throw std::runtime_error("Not implemented");
+    auto weights = params.get_input<int>("Cotangent Weights") ? LaplacianWeights::Cotangent
+                                                               : LaplacianWeights::Uniform;
 
     /* ----------------------------- Preprocess -------------------------------
-    ** Create a halfedge structure (using OpenMesh) for the input mesh. The
-    ** half-edge data structure is a widely used data structure in geometric
-    ** processing, offering convenient operations for traversing and modifying
-    ** mesh elements.
+    ** Get the halfedge structure of the input mesh. It is built once and
+    ** cached on the mesh, and its positions are shared with the mesh until
+    ** they are written to.
     */
-    auto halfedge_mesh = operand_to_openmesh(&input);
+    auto halfedge_mesh = mesh->half_edge_mesh();
 
-    /* ---------------- [HW4_TODO] TASK 1: Minimal Surface --------------------
-    ** In this task, you are required to generate a 'minimal surface' mesh with
-    ** the boundary of the input mesh as its boundary.
-    **
-    ** Specifically, the positions of the boundary vertices of the input mesh
-    ** should be fixed. By solving a global Laplace equation on the mesh,
-    ** recalculate the coordinates of the vertices inside the mesh to achieve
-    ** the minimal surface configuration.
+    /* ---------------------------- Minimal Surface ---------------------------
+    ** The boundary vertices keep their positions, and the interior ones solve
+    ** the Laplace equation L X = 0 with them as Dirichlet conditions, for x, y
+    ** and z at once.
     **
-    ** (Recall the Poisson equation with Dirichlet Boundary Condition in HW3)
+    ** The factorization of L restricted to the interior is cached for the
+    ** topology, the boundary and the weights, so running the node again with
+    ** the boundary moved, as after a boundary mapping, only substitutes.
     */
+    std::vector<int> boundary;
+    for (int v = 0; v < halfedge_mesh->n_vertices(); ++v) {
+        if (halfedge_mesh->is_boundary_vertex(v)) {
+            boundary.push_back(v);
+        }
+    }
+    if (boundary.empty()) {
+        throw std::runtime_error("Minimal Surface: The mesh has no boundary.");
+    }
 
-    /*
-    ** Algorithm Pseudocode for Minimal Surface Calculation
-    ** ------------------------------------------------------------------------
-    ** 1. Initialize mesh with input boundary conditions.
-    **    - For each boundary vertex, fix its position.
-    **    - For internal vertices, initialize with initial guess if necessary.
-    **
-    ** 2. Construct Laplacian matrix for the mesh.
-    **    - Compute weights for each edge based on the chosen weighting scheme
-    **      (e.g., uniform weights for simplicity).
-    **    - Assemble the global Laplacian matrix.
-    **
-    ** 3. Solve the Laplace equation for interior vertices.
-    **    - Apply Dirichlet boundary conditions for boundary vertices.
-    **    - Solve the linear system (Laplacian * X = 0) to find new positions
-    **      for internal vertices.
-    **
-    ** 4. Update mesh geometry with new vertex positions.
-    **    - Ensure the mesh respects the minimal surface configuration.
-    **
-    ** Note: This pseudocode outlines the general steps for calculating a
-    ** minimal surface mesh given fixed boundary conditions using the Laplace
-    ** equation. The specific implementation details may vary based on the mesh
-    ** representation and numerical methods used.
-    **
-    */
+    Eigen::MatrixXd boundary_positions(boundary.size(), 3);
+    for (int i = 0; i < boundary.size(); ++i) {
+        const auto& position = halfedge_mesh.positions[boundary[i]];
+        boundary_positions.row(i) << position[0], position[1], position[2];
+    }
+
+    auto solver = LaplacianSolver::get(halfedge_mesh, weights, boundary);
+    if (!solver->succeeded()) {
+        throw std::runtime_error("Minimal Surface: Failed to factorize the Laplacian.");
+    }
+    auto solution = solver->solve_with_fixed_values(boundary_positions);
+
+    auto& positions = halfedge_mesh.positions;
+    for (int v = 0; v < positions.size(); ++v) {
+        positions[v] = pxr::GfVec3f(solution(v, 0), solution(v, 1), solution(v, 2));
+    }
 
     /* ----------------------------- Postprocess ------------------------------
-    ** Convert the minimal surface mesh from the halfedge structure back to
-    ** GOperandBase format as the node's output.
+    ** Write the new positions to a copy of the input as the node's output. The
+    ** copy shares the topology and the other attributes with the input.
     */
-    auto operand_base = openmesh_to_operand(halfedge_mesh.get());
+    GOperandBase output = input;
+    output.get_component<MeshComponent>()->vertices = halfedge_mesh.positions;
 
     // Set the output of the nodes
-    params.set_output("Output", std::move(*operand_base));
+    params.set_output("Output", std::move(output));
 }
 
 static void node_register()
@@ -0,0 +1,60 @@
+#include "GCore/Components/PointsComponent.h"
+#include "GCore/Components/VolumeComponent.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_volume.h"
+
+namespace USTC_CG::node_points_to_sdf {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Points");
+    b.add_input<decl::Float>("Voxel Size").min(0.01).max(5).default_val(0.1f);
+    // Width of the narrow band on either side of the surface, in voxels.
+    b.add_input<decl::Float>("Half Width").min(1).max(10).default_val(3.0f);
+    b.add_output<decl::Geometry>("Volume");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& points_geometry = params.get_input_ref<GOperandBase>("Points");
+    auto points = points_geometry.get_component<PointsComponent>();
+    if (!points) {
+        throw std::runtime_error("Input does not contain points");
+    }
+
+    float voxel_size = std::max(params.get_input<float>("Voxel Size"), 0.001f);
+    float half_width = std::max(params.get_input<float>("Half Width"), 1.0f);
+
+    // The field is shared with the output. The outputs of the last frame are gone by the time the
+    // node runs again, so it is reused in place unless something downstream still holds it.
+    auto grid =
+        rasterize_points(*points, voxel_size, half_width, take_previous_grid(&params.node_));
+    keep_grid(&params.node_, grid);
+
+    GOperandBase volume_geometry;
+    auto volume = std::make_shared<VolumeComponent>(&volume_geometry);
+    volume->set_grid(VolumeComponent::surface, std::move(grid));
+    volume_geometry.attach_component(volume);
+
+    params.set_output("Volume", std::move(volume_geometry));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Points To SDF");
+    strcpy_s(ntype.id_name, "geom_points_to_sdf");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    // The grid kept from the last execution is not among the inputs.
+    ntype.CACHE_OUTPUTS = false;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_points_to_sdf
@@ -40,6 +40,8 @@ static void node_register()
     ntype.node_execute = node_exec;
     ntype.declare = node_declare;
     ntype.ALWAYS_REQUIRED = true;
+    // Keeps its output in one piece.
+    ntype.THREAD_SAFE = false;
     nodeRegisterType(&ntype);
 }
 
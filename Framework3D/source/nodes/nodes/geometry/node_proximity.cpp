@@ -0,0 +1,57 @@
+#include "GCore/Components/MeshOperand.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_spatial_query.h"
+
+namespace USTC_CG::node_proximity {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Mesh");
+    b.add_input<decl::Float3Buffer>("Points");
+    b.add_input<decl::Float>("Radius").min(0).max(10).default_val(0.1f);
+
+    // The number of faces within the radius of each point, and those faces, point after point.
+    b.add_output<decl::Int1Buffer>("Face Counts");
+    b.add_output<decl::Int1Buffer>("Faces");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& geometry = params.get_input_ref<GOperandBase>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("Proximity: Need Geometry Input.");
+    }
+
+    const auto& points = params.get_input_ref<pxr::VtArray<pxr::GfVec3f>>("Points");
+
+    auto query = MeshSpatialQuery::get(mesh->half_edge_mesh());
+    std::vector<int> offsets, faces;
+    query->faces_within(points, params.get_input<float>("Radius"), offsets, faces);
+
+    pxr::VtArray<int> face_counts(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        face_counts[i] = offsets[i + 1] - offsets[i];
+    }
+
+    params.set_output("Face Counts", std::move(face_counts));
+    params.set_output("Faces", pxr::VtArray<int>(faces.begin(), faces.end()));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Proximity");
+    strcpy_s(ntype.id_name, "geom_proximity");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_proximity
@@ -0,0 +1,68 @@
+#include "GCore/Components/MeshOperand.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_spatial_query.h"
+
+namespace USTC_CG::node_raycast {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Mesh");
+    b.add_input<decl::Float3Buffer>("Origins");
+    // One direction for every ray, or one per origin.
+    b.add_input<decl::Float3Buffer>("Directions");
+    b.add_input<decl::Float>("Max Distance").min(0).max(1000).default_val(100);
+
+    // For a ray that misses: the origin, a zero normal, an infinite distance and face -1.
+    b.add_output<decl::Float3Buffer>("Positions");
+    b.add_output<decl::Float3Buffer>("Normals");
+    b.add_output<decl::Float1Buffer>("Distances");
+    b.add_output<decl::Int1Buffer>("Faces");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& geometry = params.get_input_ref<GOperandBase>("Mesh");
+    auto mesh = geometry.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("Raycast: Need Geometry Input.");
+    }
+
+    const auto& origins = params.get_input_ref<pxr::VtArray<pxr::GfVec3f>>("Origins");
+    const auto& directions = params.get_input_ref<pxr::VtArray<pxr::GfVec3f>>("Directions");
+
+    auto query = MeshSpatialQuery::get(mesh->half_edge_mesh());
+    auto hits = query->ray_cast(origins, directions, params.get_input<float>("Max Distance"));
+
+    pxr::VtArray<pxr::GfVec3f> positions(hits.size()), normals(hits.size());
+    pxr::VtArray<float> distances(hits.size());
+    pxr::VtArray<int> faces(hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        positions[i] = hits[i].face < 0 ? origins[i] : hits[i].position;
+        normals[i] = hits[i].normal;
+        distances[i] = hits[i].distance;
+        faces[i] = hits[i].face;
+    }
+
+    params.set_output("Positions", std::move(positions));
+    params.set_output("Normals", std::move(normals));
+    params.set_output("Distances", std::move(distances));
+    params.set_output("Faces", std::move(faces));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Raycast");
+    strcpy_s(ntype.id_name, "geom_raycast");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_raycast
@@ -11,6 +11,7 @@
 #include "Nodes/node.hpp"
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
+#include "Nodes/usd_stage_cache.hpp"
 #include "geom_node_base.h"
 #include "pxr/base/gf/rotation.h"
 
@@ -38,46 +39,47 @@ static void node_exec(ExeParams params)
         time = pxr::UsdTimeCode::Default();
     }
 
-    auto stage = pxr::UsdStage::Open(file_name.c_str());
+    // Here 'c_str' call is necessary since prim_path
+    auto sdf_path =
+        pxr::SdfPath(prim_path.c_str()).MakeAbsolutePath(pxr::SdfPath::AbsoluteRootPath());
+    auto stage = open_cached_stage(file_name, sdf_path);
+    if (!stage) {
+        throw std::runtime_error("Read USD: Failed to open " + file_name + ".");
+    }
 
-    if (stage) {
-        // Here 'c_str' call is necessary since prim_path
-        auto sdf_path = pxr::SdfPath(prim_path.c_str());
-        pxr::UsdGeomMesh usdgeom(stage->GetPrimAtPath(sdf_path));
+    pxr::UsdGeomMesh usdgeom(stage->GetPrimAtPath(sdf_path));
 
-        if (usdgeom) {
-            // Fill in the vertices and faces here
-            usdgeom.CreatePointsAttr().Get(&mesh->vertices, time);
-            usdgeom.CreateFaceVertexCountsAttr().Get(&mesh->faceVertexCounts, time);
-            usdgeom.CreateFaceVertexIndicesAttr().Get(&mesh->faceVertexIndices, time);
+    if (usdgeom) {
+        // Fill in the vertices and faces here. Only the attributes that change between frames
+        // are read again.
+        read_cached_attribute(usdgeom.GetPointsAttr(), time, &mesh->vertices);
+        read_cached_attribute(usdgeom.GetFaceVertexCountsAttr(), time, &mesh->faceVertexCounts);
+        read_cached_attribute(
+            usdgeom.GetFaceVertexIndicesAttr(), time, &mesh->faceVertexIndices);
 
-            usdgeom.CreateNormalsAttr().Get(&mesh->normals, time);
+        read_cached_attribute(usdgeom.GetNormalsAttr(), time, &mesh->normals);
 
-            auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
-            pxr::UsdGeomPrimvar primvar = PrimVarAPI.GetPrimvar(pxr::TfToken("UVMap"));
-            primvar.Get(&mesh->texcoordsArray, time);
+        auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
+        pxr::UsdGeomPrimvar primvar = PrimVarAPI.GetPrimvar(pxr::TfToken("UVMap"));
+        read_cached_attribute(primvar.GetAttr(), time, &mesh->texcoordsArray);
 
-            pxr::GfMatrix4d final_transform  = usdgeom.ComputeLocalToWorldTransform(time);
+        pxr::GfMatrix4d final_transform = usdgeom.ComputeLocalToWorldTransform(time);
 
-            if (final_transform != pxr::GfMatrix4d().SetIdentity()) {
-                auto xform_component = std::make_shared<XformComponent>(&geometry);
-                geometry.attach_component(xform_component);
+        if (final_transform != pxr::GfMatrix4d().SetIdentity()) {
+            auto xform_component = std::make_shared<XformComponent>(&geometry);
+            geometry.attach_component(xform_component);
 
-                auto rotation = final_transform.ExtractRotation();
-                auto translation = final_transform.ExtractTranslation();
-                // TODO: rotation not read.
+            auto rotation = final_transform.ExtractRotation();
+            auto translation = final_transform.ExtractTranslation();
+            // TODO: rotation not read.
 
-                xform_component->translation.push_back(pxr::GfVec3f(translation));
-                xform_component->rotation.push_back(pxr::GfVec3f(0.0f));
-                xform_component->scale.push_back(pxr::GfVec3f(1.0f));
-            }
+            xform_component->translation.push_back(pxr::GfVec3f(translation));
+            xform_component->rotation.push_back(pxr::GfVec3f(0.0f));
+            xform_component->scale.push_back(pxr::GfVec3f(1.0f));
         }
-
-        // TODO: add material reading
-    }
-    else {
-        // TODO: throw something
     }
+
+    // TODO: add material reading
     params.set_output("Geometry", std::move(geometry));
 }
 
@@ -91,6 +93,8 @@ static void node_register()
     geo_node_type_base(&ntype);
     ntype.node_execute = node_exec;
     ntype.declare = node_declare;
+    // The file may change on disk, which the inputs do not show. The stage cache reopens it.
+    ntype.CACHE_OUTPUTS = false;
     nodeRegisterType(&ntype);
 }
 
@@ -0,0 +1,57 @@
+#include <openvdb/tools/Composite.h>
+
+#include "GCore/Components/VolumeComponent.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_volume.h"
+
+namespace USTC_CG::node_sdf_boolean {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("A");
+    b.add_input<decl::Geometry>("B");
+    // 0: union, 1: intersection, 2: difference, A minus B
+    b.add_input<decl::Int>("Operation").min(0).max(2).default_val(0);
+    b.add_output<decl::Geometry>("Volume");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& a = params.get_input_ref<GOperandBase>("A");
+    auto& b = params.get_input_ref<GOperandBase>("B");
+    auto grid_a = surface_grid(a);
+    auto grid_b = surface_grid(b);
+
+    // The copying operations leave both inputs untouched, and resample B if its transform
+    // differs from A's.
+    openvdb::FloatGrid::Ptr result;
+    switch (params.get_input<int>("Operation")) {
+        case 0: result = openvdb::tools::csgUnionCopy(*grid_a, *grid_b); break;
+        case 1: result = openvdb::tools::csgIntersectionCopy(*grid_a, *grid_b); break;
+        case 2: result = openvdb::tools::csgDifferenceCopy(*grid_a, *grid_b); break;
+        default: throw std::runtime_error("SDF Boolean: Unknown operation.");
+    }
+
+    // The other grids of A are kept.
+    GOperandBase output = a;
+    output.get_component<VolumeComponent>()->set_grid(VolumeComponent::surface, result);
+    params.set_output("Volume", std::move(output));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "SDF Boolean");
+    strcpy_s(ntype.id_name, "geom_sdf_boolean");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_sdf_boolean
@@ -0,0 +1,50 @@
+#include <openvdb/tools/LevelSetFilter.h>
+
+#include "GCore/Components/VolumeComponent.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_volume.h"
+
+namespace USTC_CG::node_sdf_offset {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Volume");
+    // World distance to move the surface by, outwards (dilation) when positive and inwards
+    // (erosion) when negative.
+    b.add_input<decl::Float>("Distance").min(-1).max(1).default_val(0.1f);
+    b.add_output<decl::Geometry>("Volume");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& input = params.get_input_ref<GOperandBase>("Volume");
+    surface_grid(input);
+
+    GOperandBase output = input;
+    auto grid = output.get_component<VolumeComponent>()->writable_grid<openvdb::FloatGrid>(
+        VolumeComponent::surface);
+
+    // The filter adds its offset to the distances, so a positive one shrinks the surface.
+    openvdb::tools::LevelSetFilter<openvdb::FloatGrid> filter(*grid);
+    filter.offset(-params.get_input<float>("Distance"));
+
+    params.set_output("Volume", std::move(output));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "SDF Offset");
+    strcpy_s(ntype.id_name, "geom_sdf_offset");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_sdf_offset
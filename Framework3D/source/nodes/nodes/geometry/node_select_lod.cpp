@@ -0,0 +1,68 @@
+#include "GCore/Components/MeshOperand.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "pxr/base/gf/range3f.h"
+
+namespace USTC_CG::node_select_lod {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("LOD");
+    b.add_input<decl::Float1Buffer>("LOD Errors");
+    // How many pixels the diagonal of the bounding box of the mesh covers on screen.
+    b.add_input<decl::Float>("Screen Size").default_val(500).min(0).max(4000);
+    b.add_input<decl::Float>("Pixel Error").default_val(1).min(0.1f).max(16);
+
+    b.add_output<decl::Geometry>("Mesh");
+    b.add_output<decl::Int>("Level");
+}
+
+// The coarsest level whose error, projected to the screen, stays within the pixel error.
+static void node_exec(ExeParams params)
+{
+    const auto& lod = params.get_input_ref<GOperandBase>("LOD");
+    const auto& errors = params.get_input_ref<pxr::VtArray<float>>("LOD Errors");
+    auto finest = lod.get_component<MeshComponent>();
+    if (!finest) {
+        throw std::runtime_error("Select LOD: Need LOD Input.");
+    }
+
+    pxr::GfRange3f bounds;
+    for (const auto& vertex : finest->vertices) {
+        bounds.UnionWith(vertex);
+    }
+    const float diagonal = bounds.IsEmpty() ? 0 : bounds.GetSize().GetLength();
+    const float pixels_per_unit =
+        diagonal > 0 ? params.get_input<float>("Screen Size") / diagonal : 0;
+    const float pixel_error = params.get_input<float>("Pixel Error");
+
+    size_t level = 0;
+    for (size_t i = 1; i < errors.size() && lod.get_component<MeshComponent>(i); ++i) {
+        if (errors[i] * pixels_per_unit <= pixel_error) {
+            level = i;
+        }
+    }
+
+    GOperandBase mesh_geometry;
+    mesh_geometry.attach_component(lod.get_component<MeshComponent>(level)->copy(&mesh_geometry));
+
+    params.set_output("Mesh", std::move(mesh_geometry));
+    params.set_output("Level", static_cast<int>(level));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Select LOD");
+    strcpy_s(ntype.id_name, "geom_select_lod");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_select_lod
@@ -16,14 +16,14 @@ static void node_exec(ExeParams params)
 {
     auto texture = params.get_input<std::string>("Texture Name");
 
-    auto geometry = params.get_input<GOperandBase>("Geometry");
+    auto geometry = params.take_input<GOperandBase>("Geometry");
     auto material = geometry.get_component<MaterialComponent>();
     if (!material) {
         material = std::make_shared<MaterialComponent>(&geometry);
+        geometry.attach_component(material);
     }
     material->textures.clear();
     material->textures.push_back(texture);
-    geometry.attach_component(material);
 
     params.set_output("Geometry", std::move(geometry));
 }
@@ -68,6 +68,7 @@ static void node_register()
     geo_node_type_base(&storage_out_ntype);
     storage_out_ntype.node_execute = node_exec_storage_out;
     storage_out_ntype.declare = node_declare_storage_out;
+    storage_out_ntype.CACHE_OUTPUTS = false;
     nodeRegisterType(&storage_out_ntype);
 
     static NodeTypeInfo time_gain_ntype;
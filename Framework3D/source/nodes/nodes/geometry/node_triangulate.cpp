@@ -1,3 +1,4 @@
+#include "GCore/Components/MeshOperand.h"
 #include "Nodes/node.hpp"
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
@@ -10,12 +11,53 @@ static void node_declare(NodeDeclarationBuilder& b)
     b.add_output<decl::Geometry>("G-out");
 }
 
-static void node_exec(ExeParams params)
+// Attributes per face corner or per face follow the triangles, per vertex ones stay as they are.
+template<typename T>
+static void triangulate_attribute(
+    pxr::VtArray<T>& values,
+    const Triangulation& triangulation,
+    size_t corner_count,
+    size_t face_count,
+    size_t vertex_count)
 {
-    // Left empty.
-    throw std::runtime_error("Not implemented!");
+    if (values.size() == vertex_count) {
+        return;
+    }
+    if (values.size() == corner_count) {
+        values = triangulation.face_varying(values);
+    }
+    else if (values.size() == face_count) {
+        values = triangulation.uniform(values);
+    }
 }
 
+static void node_exec(ExeParams params)
+{
+    const auto& input = params.get_input_ref<GOperandBase>("G-IN");
+    auto mesh = input.get_component<MeshComponent>();
+    if (!mesh) {
+        throw std::runtime_error("Triangulate: Need Geometry Input.");
+    }
+
+    auto triangulation = mesh->triangulation();
+
+    GOperandBase output = input;
+    auto triangles = output.get_component<MeshComponent>();
+    const size_t corner_count = mesh->faceVertexIndices.size();
+    const size_t face_count = mesh->faceVertexCounts.size();
+    const size_t vertex_count = mesh->vertices.size();
+    triangulate_attribute(
+        triangles->normals, *triangulation, corner_count, face_count, vertex_count);
+    triangulate_attribute(
+        triangles->texcoordsArray, *triangulation, corner_count, face_count, vertex_count);
+    triangulate_attribute(
+        triangles->displayColor, *triangulation, corner_count, face_count, vertex_count);
+
+    triangles->faceVertexCounts = pxr::VtArray<int>(triangulation->n_triangles(), 3);
+    triangles->faceVertexIndices = triangulation->triangle_vertices;
+
+    params.set_output("G-out", std::move(output));
+}
 
 static void node_register()
 {
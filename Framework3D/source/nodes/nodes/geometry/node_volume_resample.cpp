@@ -0,0 +1,58 @@
+#include <openvdb/tools/GridTransformer.h>
+
+#include "GCore/Components/VolumeComponent.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_volume.h"
+
+namespace USTC_CG::node_volume_resample {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Volume");
+    b.add_input<decl::Float>("Voxel Size").min(0.01).max(5).default_val(0.1f);
+    b.add_output<decl::Geometry>("Volume");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& input = params.get_input_ref<GOperandBase>("Volume");
+    auto source = surface_grid(input);
+
+    float voxel_size = std::max(params.get_input<float>("Voxel Size"), 0.001f);
+
+    // A level set is rebuilt at the new resolution with a band as many voxels wide, other fields
+    // are sampled trilinearly.
+    openvdb::FloatGrid::Ptr target;
+    if (source->getGridClass() == openvdb::GRID_LEVEL_SET) {
+        float half_width = source->background() / source->voxelSize()[0];
+        target = openvdb::createLevelSet<openvdb::FloatGrid>(voxel_size, half_width);
+    }
+    else {
+        target = openvdb::FloatGrid::create(source->background());
+        target->setTransform(openvdb::math::Transform::createLinearTransform(voxel_size));
+        target->setGridClass(source->getGridClass());
+    }
+    openvdb::tools::resampleToMatch<openvdb::tools::BoxSampler>(*source, *target);
+
+    GOperandBase output = input;
+    output.get_component<VolumeComponent>()->set_grid(VolumeComponent::surface, target);
+    params.set_output("Volume", std::move(output));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Volume Resample");
+    strcpy_s(ntype.id_name, "geom_volume_resample");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_volume_resample
@@ -0,0 +1,51 @@
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/VolumeComponent.h"
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "geom_node_base.h"
+#include "utils/util_volume.h"
+
+namespace USTC_CG::node_volume_to_mesh {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Geometry>("Volume");
+    b.add_input<decl::Float>("Isovalue").min(-1).max(1).default_val(0.0f);
+    // 0 gives one face per voxel the surface crosses, higher merges the flat parts.
+    b.add_input<decl::Float>("Adaptivity").min(0).max(1).default_val(0.2f);
+    b.add_output<decl::Geometry>("Mesh");
+}
+
+static void node_exec(ExeParams params)
+{
+    auto& input = params.get_input_ref<GOperandBase>("Volume");
+    auto grid = surface_grid(input);
+
+    GOperandBase mesh_geometry;
+    auto mesh = std::make_shared<MeshComponent>(&mesh_geometry);
+    mesh_geometry.attach_component(mesh);
+
+    volume_to_mesh(
+        *grid,
+        params.get_input<float>("Isovalue"),
+        std::clamp(params.get_input<float>("Adaptivity"), 0.0f, 1.0f),
+        *mesh);
+
+    params.set_output("Mesh", std::move(mesh_geometry));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Volume To Mesh");
+    strcpy_s(ntype.id_name, "geom_volume_to_mesh");
+
+    geo_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_volume_to_mesh
@@ -1,4 +1,7 @@
 // #define __GNUC__
+#include <filesystem>
+#include <map>
+
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usdGeom/mesh.h>
 #include <pxr/usd/usdGeom/points.h>
@@ -17,6 +20,12 @@
 #include "geom_node_base.h"
 #include "pxr/base/gf/matrix4d.h"
 #include "pxr/base/gf/rotation.h"
+#include "pxr/usd/sdf/attributeSpec.h"
+#include "pxr/usd/sdf/changeBlock.h"
+#include "pxr/usd/sdf/copyUtils.h"
+#include "pxr/usd/sdf/layer.h"
+#include "pxr/usd/sdf/primSpec.h"
+#include "pxr/usd/sdf/schema.h"
 
 namespace USTC_CG::node_write_usd {
 static void node_declare(NodeDeclarationBuilder& b)
@@ -25,6 +34,8 @@ static void node_declare(NodeDeclarationBuilder& b)
     b.add_input<decl::String>("File Name").default_val("Default");
     b.add_input<decl::String>("Prim Path").default_val("geometry");
     b.add_input<decl::Float>("Time Code").default_val(0).min(0).max(240);
+    // When set, every executed frame is also appended as time samples to this crate file.
+    b.add_input<decl::String>("Export File").default_val("");
 }
 
 bool legal(const std::string& string)
@@ -40,12 +51,191 @@ bool legal(const std::string& string)
     return false;
 }
 
+// Values for the attributes of a prim, authored together in one change block once every
+// attribute exists. A value the layer already holds is not authored again, so unchanged
+// attributes send no notice and the viewport only updates what changed. An attribute keeps only
+// the sample of the latest execution: the frames before it are kept by the simulation frame
+// cache, which would otherwise snapshot every earlier sample with each frame.
+class AttributeEdits {
+   public:
+    void set(const pxr::UsdAttribute& attribute, const pxr::VtValue& value, pxr::UsdTimeCode time)
+    {
+        edits_.push_back({ attribute.GetPath(), value, time });
+    }
+
+    // Removes what was written to the attribute before, if anything.
+    void clear(const pxr::UsdAttribute& attribute)
+    {
+        if (attribute) {
+            edits_.push_back({ attribute.GetPath(), pxr::VtValue(), pxr::UsdTimeCode::Default() });
+        }
+    }
+
+    void apply(const pxr::SdfLayerHandle& layer) const
+    {
+        pxr::SdfChangeBlock change_block;
+        for (auto& edit : edits_) {
+            if (edit.value.IsEmpty()) {
+                if (auto property = layer->GetPropertyAtPath(edit.path)) {
+                    layer->GetPrimAtPath(edit.path.GetPrimPath())->RemoveProperty(property);
+                }
+                continue;
+            }
+
+            pxr::VtValue authored;
+            if (edit.time.IsDefault()) {
+                authored = layer->GetField(edit.path, pxr::SdfFieldKeys->Default);
+                if (authored != edit.value) {
+                    layer->SetField(edit.path, pxr::SdfFieldKeys->Default, edit.value);
+                }
+            }
+            else {
+                // A lone sample resolves to its value at every time, so holding the value already
+                // is as good as holding it at this time.
+                auto times = layer->ListTimeSamplesForPath(edit.path);
+                if (times.size() == 1 &&
+                    layer->QueryTimeSample(edit.path, *times.begin(), &authored) &&
+                    authored == edit.value) {
+                    continue;
+                }
+                if (!times.empty()) {
+                    layer->EraseField(edit.path, pxr::SdfFieldKeys->TimeSamples);
+                }
+                layer->SetTimeSample(edit.path, edit.time.GetValue(), edit.value);
+            }
+        }
+    }
+
+    // Authors every value as a sample at time, copying the specs of attributes the target does
+    // not have yet from the source.
+    void append_samples(
+        const pxr::SdfLayerHandle& source,
+        const pxr::SdfLayerHandle& target,
+        double time) const
+    {
+        for (auto& edit : edits_) {
+            if (edit.value.IsEmpty()) {
+                continue;
+            }
+            if (!target->HasSpec(edit.path)) {
+                pxr::SdfCopySpec(source, edit.path, target, edit.path);
+                target->EraseField(edit.path, pxr::SdfFieldKeys->TimeSamples);
+            }
+            target->SetTimeSample(edit.path, time, edit.value);
+        }
+    }
+
+   private:
+    struct Edit {
+        pxr::SdfPath path;
+        // Empty to clear the attribute.
+        pxr::VtValue value;
+        pxr::UsdTimeCode time;
+    };
+    std::vector<Edit> edits_;
+};
+
+// Crate layers being exported to, kept open across the frames of a run. Saving a crate file
+// again appends what changed to it, and the saved samples are then read back from the file on
+// demand rather than kept in memory, so a long range streams to disk.
+struct Export {
+    // Released when the simulation stops, and reopened to append to when it goes on.
+    pxr::SdfLayerRefPtr layer;
+    // Last time exported for each prim. Going back in time starts the prim over.
+    std::map<pxr::SdfPath, double> last_times;
+};
+
+// Every file exported to in this session. Only these are written over.
+static std::map<std::string, Export> exports;
+
+static void release_exports()
+{
+    for (auto& [file_name, exported] : exports) {
+        exported.layer = nullptr;
+    }
+}
+
+static void export_frame(
+    const std::string& file_name,
+    const pxr::SdfLayerHandle& source,
+    const pxr::SdfPath& prim_path,
+    const AttributeEdits& edits,
+    double time)
+{
+    auto found = exports.find(file_name);
+    if (found == exports.end()) {
+        std::error_code error;
+        if (std::filesystem::exists(file_name, error)) {
+            throw std::runtime_error(
+                "Write USD: " + file_name +
+                " already exists. Remove it or export to another file.");
+        }
+        auto layer = pxr::SdfLayer::CreateNew(file_name);
+        if (!layer) {
+            throw std::runtime_error("Write USD: Failed to create " + file_name + ".");
+        }
+        layer->SetTimeCodesPerSecond(GlobalUsdStage::timeCodesPerSecond);
+        found = exports.emplace(file_name, Export{ layer }).first;
+    }
+    auto& exported = found->second;
+    if (!exported.layer) {
+        exported.layer = pxr::SdfLayer::FindOrOpen(file_name);
+        if (!exported.layer) {
+            throw std::runtime_error("Write USD: Failed to open " + file_name + ".");
+        }
+    }
+    auto& layer = exported.layer;
+
+    auto last_time = exported.last_times.find(prim_path);
+    {
+        pxr::SdfChangeBlock change_block;
+        if (last_time == exported.last_times.end() || time < last_time->second) {
+            // The prim starts over as it is now, without the samples of an earlier run.
+            if (auto spec = layer->GetPrimAtPath(prim_path)) {
+                spec->GetRealNameParent()->RemoveNameChild(spec);
+            }
+            for (auto ancestor = prim_path.GetParentPath(); !ancestor.IsAbsoluteRootPath();
+                 ancestor = ancestor.GetParentPath()) {
+                auto spec = pxr::SdfCreatePrimInLayer(layer, ancestor);
+                spec->SetSpecifier(pxr::SdfSpecifierDef);
+            }
+            pxr::SdfCopySpec(source, prim_path, layer, prim_path);
+
+            std::vector<pxr::SdfPath> sampled;
+            layer->Traverse(prim_path, [&](const pxr::SdfPath& path) {
+                if (path.IsPropertyPath()) {
+                    sampled.push_back(path);
+                }
+            });
+            for (auto& path : sampled) {
+                layer->EraseField(path, pxr::SdfFieldKeys->TimeSamples);
+            }
+        }
+        edits.append_samples(source, layer, time);
+    }
+    exported.last_times[prim_path] = time;
+
+    double start = time, end = time;
+    for (auto& [path, last] : exported.last_times) {
+        end = std::max(end, last);
+    }
+    if (layer->HasStartTimeCode()) {
+        start = std::min(start, layer->GetStartTimeCode());
+    }
+    layer->SetStartTimeCode(start);
+    layer->SetEndTimeCode(end);
+
+    if (!layer->Save()) {
+        throw std::runtime_error("Write USD: Failed to save " + file_name + ".");
+    }
+}
+
 static void node_exec(ExeParams params)
 {
     auto file_name = params.get_input<std::string>("File Name");
     auto prim_path = params.get_input<std::string>("Prim Path");
 
-    auto geometry = params.get_input<GOperandBase>("Geometry");
+    auto& geometry = params.get_input_ref<GOperandBase>("Geometry");
 
     auto mesh = geometry.get_component<MeshComponent>();
 
@@ -59,29 +249,44 @@ static void node_exec(ExeParams params)
     }
 
     auto& stage = GlobalUsdStage::global_usd_stage;
-    if (!legal(prim_path.c_str())) {
+    if (!legal(prim_path.c_str()) || !(mesh || points)) {
         return;
     }
     // Here 'c_str' call is necessary since prim_path
     auto sdf_path = pxr::SdfPath(prim_path.c_str());
+    auto geom_path = pxr::SdfPath("/geom").AppendPath(sdf_path);
 
-    if (stage->GetPrimAtPath(sdf_path)) {
-        stage->RemovePrim(sdf_path);
+    // The prim is kept across executions and only its changed values are authored. A prim of
+    // another type is replaced.
+    pxr::TfToken type_name(mesh ? "Mesh" : "Points");
+    if (auto prim = stage->GetPrimAtPath(geom_path); prim && prim.GetTypeName() != type_name) {
+        stage->RemovePrim(geom_path);
     }
+    GlobalUsdStage::written_prims.insert(geom_path);
+
+    // Prims and attributes are created first, through Usd, which does nothing for the ones that
+    // exist. The values are then authored in one change block.
+    AttributeEdits edits;
 
     if (mesh) {
-        pxr::UsdGeomMesh usdgeom =
-            pxr::UsdGeomMesh::Define(stage, pxr::SdfPath("/geom").AppendPath(sdf_path));
+        pxr::UsdGeomMesh usdgeom = pxr::UsdGeomMesh::Define(stage, geom_path);
         if (usdgeom) {
             // Fill in the vertices and faces here
-            usdgeom.CreatePointsAttr().Set(mesh->vertices, time);
-            usdgeom.CreateFaceVertexCountsAttr().Set(mesh->faceVertexCounts, time);
-            usdgeom.CreateFaceVertexIndicesAttr().Set(mesh->faceVertexIndices, time);
+            edits.set(usdgeom.CreatePointsAttr(), pxr::VtValue(mesh->vertices), time);
+            edits.set(
+                usdgeom.CreateFaceVertexCountsAttr(), pxr::VtValue(mesh->faceVertexCounts), time);
+            edits.set(
+                usdgeom.CreateFaceVertexIndicesAttr(),
+                pxr::VtValue(mesh->faceVertexIndices),
+                time);
 
             usdgeom.CreateDoubleSidedAttr(pxr::VtValue(true));
 
             if (mesh->normals.size() > 0) {
-                usdgeom.CreateNormalsAttr().Set(mesh->normals, time);
+                edits.set(usdgeom.CreateNormalsAttr(), pxr::VtValue(mesh->normals), time);
+            }
+            else {
+                edits.clear(usdgeom.GetNormalsAttr());
             }
 
             auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdgeom);
@@ -89,7 +294,7 @@ static void node_exec(ExeParams params)
             if (mesh->texcoordsArray.size() > 0) {
                 pxr::UsdGeomPrimvar primvar = PrimVarAPI.CreatePrimvar(
                     pxr::TfToken("UVMap"), pxr::SdfValueTypeNames->TexCoord2fArray);
-                primvar.Set(mesh->texcoordsArray, time);
+                edits.set(primvar.GetAttr(), pxr::VtValue(mesh->texcoordsArray), time);
 
                 // Here only consider two modes
                 if (mesh->texcoordsArray.size() == mesh->vertices.size()) {
@@ -99,12 +304,21 @@ static void node_exec(ExeParams params)
                     primvar.SetInterpolation(pxr::UsdGeomTokens->faceVarying);
                 }
             }
+            else {
+                edits.clear(PrimVarAPI.GetPrimvar(pxr::TfToken("UVMap")).GetAttr());
+            }
 
             if (mesh->displayColor.size()) {
                 pxr::UsdGeomPrimvar colorPrimvar = PrimVarAPI.CreatePrimvar(
                     pxr::TfToken("displayColor"), pxr::SdfValueTypeNames->Color3fArray);
                 colorPrimvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-                colorPrimvar.Set(mesh->displayColor);
+                edits.set(
+                    colorPrimvar.GetAttr(),
+                    pxr::VtValue(mesh->displayColor),
+                    pxr::UsdTimeCode::Default());
+            }
+            else {
+                edits.clear(PrimVarAPI.GetPrimvar(pxr::TfToken("displayColor")).GetAttr());
             }
         }
 
@@ -124,6 +338,7 @@ static void node_exec(ExeParams params)
                     material_path.AppendPath(pxr::SdfPath("diffuseTexture"));
 
                 auto material = pxr::UsdShadeMaterial::Define(stage, material_path);
+                GlobalUsdStage::written_prims.insert(material_path);
                 auto pbrShader = pxr::UsdShadeShader::Define(stage, material_shader_path);
 
                 pbrShader.CreateIdAttr(pxr::VtValue(pxr::TfToken("UsdPreviewSurface")));
@@ -173,29 +388,32 @@ static void node_exec(ExeParams params)
         }
     }
     else if (points) {
-        pxr::UsdGeomPoints usdpoints =
-            pxr::UsdGeomPoints::Define(stage, pxr::SdfPath("/geom").AppendPath(sdf_path));
+        pxr::UsdGeomPoints usdpoints = pxr::UsdGeomPoints::Define(stage, geom_path);
 
-        usdpoints.CreatePointsAttr().Set(points->vertices, time);
+        edits.set(usdpoints.CreatePointsAttr(), pxr::VtValue(points->vertices), time);
 
         if (points->width.size() > 0) {
-            usdpoints.CreateWidthsAttr().Set(points->width, time);
+            edits.set(usdpoints.CreateWidthsAttr(), pxr::VtValue(points->width), time);
+        }
+        else {
+            edits.clear(usdpoints.GetWidthsAttr());
         }
 
         auto PrimVarAPI = pxr::UsdGeomPrimvarsAPI(usdpoints);
-		if (points->displayColor.size() > 0) {
-			pxr::UsdGeomPrimvar colorPrimvar = PrimVarAPI.CreatePrimvar(
-				pxr::TfToken("displayColor"), pxr::SdfValueTypeNames->Color3fArray);
-			colorPrimvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
-			colorPrimvar.Set(points->displayColor, time);
-		}
-
+        if (points->displayColor.size() > 0) {
+            pxr::UsdGeomPrimvar colorPrimvar = PrimVarAPI.CreatePrimvar(
+                pxr::TfToken("displayColor"), pxr::SdfValueTypeNames->Color3fArray);
+            colorPrimvar.SetInterpolation(pxr::UsdGeomTokens->vertex);
+            edits.set(colorPrimvar.GetAttr(), pxr::VtValue(points->displayColor), time);
+        }
+        else {
+            edits.clear(PrimVarAPI.GetPrimvar(pxr::TfToken("displayColor")).GetAttr());
+        }
     }
 
+    auto usdgeom = pxr::UsdGeomXformable::Get(stage, geom_path);
     auto xform_component = geometry.get_component<XformComponent>();
-    if (xform_component) {
-        auto usdgeom =
-            pxr::UsdGeomXformable ::Get(stage, pxr::SdfPath("/geom").AppendPath(sdf_path));
+    if (xform_component && usdgeom) {
         // Transform
         assert(xform_component->translation.size() == xform_component->rotation.size());
 
@@ -223,7 +441,20 @@ static void node_exec(ExeParams params)
         if (!xform_op) {
             xform_op = usdgeom.AddTransformOp();
         }
-        xform_op.Set(final_transform, time);
+        edits.set(xform_op.GetAttr(), pxr::VtValue(final_transform), time);
+    }
+    else if (usdgeom && usdgeom.GetTransformOp()) {
+        edits.clear(usdgeom.GetTransformOp().GetAttr());
+        usdgeom.ClearXformOpOrder();
+    }
+
+    auto layer = stage->GetRootLayer();
+    edits.apply(layer);
+
+    // The string socket holds a fixed size buffer, so the path ends at the first NUL.
+    auto export_file = std::string(params.get_input<std::string>("Export File").c_str());
+    if (!export_file.empty()) {
+        export_frame(export_file, layer, geom_path, edits, t);
     }
 }
 
@@ -236,9 +467,13 @@ static void node_register()
     ntype.ALWAYS_REQUIRED = true;
 
     geo_node_type_base(&ntype);
+    // Writes to the global stage.
+    ntype.THREAD_SAFE = false;
     ntype.node_execute = node_exec;
     ntype.declare = node_declare;
     nodeRegisterType(&ntype);
+
+    GlobalUsdStage::on_simulation_stopped(release_exports);
 }
 
 NOD_REGISTER_NODE(node_register)
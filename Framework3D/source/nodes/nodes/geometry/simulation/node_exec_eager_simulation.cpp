@@ -1,4 +1,4 @@
-#include "Nodes/node_exec_eager.hpp"
+#include "Nodes/node_exec_parallel.hpp"
 #include "Nodes/node_tree.hpp"
 #include "USTC_CG.h"
 // #include "Utils/Functions/GenericPointer_.hpp"
@@ -8,7 +8,7 @@
 #include <map>
 #include <set>
 USTC_CG_NAMESPACE_OPEN_SCOPE
-class EagerNodeTreeExecutorSimulation : public EagerNodeTreeExecutor {
+class EagerNodeTreeExecutorSimulation : public ParallelNodeTreeExecutor {
    public:
     void prepare_tree(NodeTree* node_tree) override;
     void execute_tree(NodeTree* tree) override;
@@ -23,7 +23,7 @@ class EagerNodeTreeExecutorSimulation : public EagerNodeTreeExecutor {
 
 void EagerNodeTreeExecutorSimulation::prepare_tree(NodeTree* node_tree)
 {
-    EagerNodeTreeExecutor::prepare_tree(node_tree);
+    ParallelNodeTreeExecutor::prepare_tree(node_tree);
     std::set<std::string> refreshed;
 
     for (int i = 0; i < input_states.size(); ++i) {
@@ -96,7 +96,7 @@ void EagerNodeTreeExecutorSimulation::prepare_tree(NodeTree* node_tree)
 
 void EagerNodeTreeExecutorSimulation::execute_tree(NodeTree* tree)
 {
-    EagerNodeTreeExecutor::execute_tree(tree);
+    ParallelNodeTreeExecutor::execute_tree(tree);
 }
 
 EagerNodeTreeExecutorSimulation::~EagerNodeTreeExecutorSimulation()
@@ -125,14 +125,14 @@ bool EagerNodeTreeExecutorSimulation::execute_node(NodeTree* tree, Node* node)
                 // Check all the connected input type
 
                 for (auto input : node->outputs[0]->directly_linked_sockets) {
-                    if (pointer.type() != input_states[index_cache[input]].value.type()) {
+                    if (pointer.type() != input_states[index_cache.at(input)].value.type()) {
                         node->execution_failed = "Type Mismatch";
                         return false;
                     }
                 }
 
                 CPPType::get<GMutablePointer>().copy_assign(
-                    &pointer, output_states[index_cache[node->outputs[0]]].value.get());
+                    &pointer, output_states[index_cache.at(node->outputs[0])].value.get());
 
                 node->execution_failed = {};
                 return true;
@@ -144,7 +144,7 @@ bool EagerNodeTreeExecutorSimulation::execute_node(NodeTree* tree, Node* node)
         }
     }
 
-    return EagerNodeTreeExecutor::execute_node(tree, node);
+    return ParallelNodeTreeExecutor::execute_node(tree, node);
 }
 
 std::unique_ptr<EagerNodeTreeExecutor> CreateEagerNodeTreeExecutorSimulation()
@@ -0,0 +1,398 @@
+#include "util_arap.h"
+
+#include <Eigen/SVD>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "pxr/base/gf/vec2d.h"
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static std::vector<int> isolated_vertices(const HalfEdgeTopology& topology)
+{
+    std::vector<int> isolated;
+    for (int v = 0; v < topology.n_vertices(); ++v) {
+        if (topology.vertex_half_edge[v] < 0) {
+            isolated.push_back(v);
+        }
+    }
+    return isolated;
+}
+
+// The connected component of each vertex, -1 for vertices with no face, and their count.
+static std::vector<int> vertex_components(const HalfEdgeTopology& topology, int& count)
+{
+    std::vector<int> parent(topology.n_vertices());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int v) {
+        while (parent[v] != v) {
+            v = parent[v] = parent[parent[v]];
+        }
+        return v;
+    };
+    for (int h = 0; h < topology.n_half_edges(); ++h) {
+        int a = find(topology.from_vertex(h)), b = find(topology.to_vertex(h));
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    std::vector<int> component(topology.n_vertices(), -1);
+    count = 0;
+    for (int v = 0; v < topology.n_vertices(); ++v) {
+        if (topology.vertex_half_edge[v] < 0) {
+            continue;
+        }
+        const int root = find(v);
+        component[v] = root == v ? count++ : component[root];
+    }
+    return component;
+}
+
+static float milliseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+ArapParameterization::ArapParameterization(const HalfEdgeMesh& mesh) : mesh_(mesh)
+{
+    const auto& topology = *mesh.topology;
+    if (!LaplacianPattern::get(mesh.topology)->triangles) {
+        throw std::runtime_error("ARAP needs a triangle mesh.");
+    }
+
+    const size_t half_edge_count = topology.n_half_edges();
+    edge_x_.resize(half_edge_count);
+    edge_y_.resize(half_edge_count);
+    half_cotangent_.resize(half_edge_count);
+
+    pxr::WorkParallelForN(topology.n_faces(), [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const int first = topology.face_half_edge[f];
+            pxr::GfVec3d p[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = pxr::GfVec3d(mesh.positions[topology.from_vertex(first + k)]);
+            }
+
+            // The first edge goes along the x axis, the third corner is above it.
+            double length = (p[1] - p[0]).GetLength();
+            pxr::GfVec3d axis = length > 0 ? (p[1] - p[0]) / length : pxr::GfVec3d(1, 0, 0);
+            double x[3] = { 0, length, pxr::GfDot(p[2] - p[0], axis) };
+            double y[3] = { 0, 0, pxr::GfCross(axis, p[2] - p[0]).GetLength() };
+
+            for (int k = 0; k < 3; ++k) {
+                const int from = k, to = (k + 1) % 3, opposite = (k + 2) % 3;
+                const int h = first + k;
+                edge_x_[h] = x[from] - x[to];
+                edge_y_[h] = y[from] - y[to];
+
+                double ax = x[from] - x[opposite], ay = y[from] - y[opposite];
+                double bx = x[to] - x[opposite], by = y[to] - y[opposite];
+                double sine = std::abs(ax * by - ay * bx);
+                half_cotangent_[h] = sine < 1e-12 ? 0 : 0.5 * (ax * bx + ay * by) / sine;
+            }
+        }
+    });
+
+    const size_t vertex_count = topology.n_vertices();
+    corner_offsets_.assign(vertex_count + 1, 0);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        ++corner_offsets_[topology.from_vertex(h) + 1];
+    }
+    std::partial_sum(corner_offsets_.begin(), corner_offsets_.end(), corner_offsets_.begin());
+    corners_.resize(half_edge_count);
+    std::vector<int> fill(corner_offsets_.begin(), corner_offsets_.end() - 1);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        corners_[fill[topology.from_vertex(h)]++] = static_cast<int>(h);
+    }
+
+    // Pinning one vertex per connected component removes the translations; the rotations are not
+    // in the null space of the energy, the local step picks them.
+    fixed_vertices_ = isolated_vertices(topology);
+    int component_count = 0;
+    auto component = vertex_components(topology, component_count);
+    std::vector<bool> pinned(component_count, false);
+    for (int v = 0; v < topology.n_vertices(); ++v) {
+        if (component[v] >= 0 && !pinned[component[v]]) {
+            pinned[component[v]] = true;
+            fixed_vertices_.push_back(v);
+        }
+    }
+    solver_ = LaplacianSolver::get(mesh, LaplacianWeights::Cotangent, fixed_vertices_);
+    if (!solver_->succeeded()) {
+        throw std::runtime_error("ARAP: Failed to factorize the Laplacian.");
+    }
+}
+
+Eigen::MatrixXd ArapParameterization::initial_uv() const
+{
+    const auto& topology = *mesh_.topology;
+
+    int component_count = 0;
+    auto component = vertex_components(topology, component_count);
+
+    // Walk the boundary loop of the first boundary half-edge of each component. Components are
+    // laid out side by side along u.
+    std::vector<bool> placed(component_count, false);
+    std::vector<int> fixed;
+    std::vector<pxr::GfVec2d> fixed_values;
+    for (int first = 0; first < topology.n_half_edges(); ++first) {
+        const int c = component[topology.from_vertex(first)];
+        if (placed[c] || !topology.is_boundary_half_edge(first)) {
+            continue;
+        }
+        placed[c] = true;
+
+        const int start = topology.vertex_half_edge[topology.from_vertex(first)];
+        const size_t loop_begin = fixed.size();
+        std::vector<double> arc_length = { 0 };
+        for (int h = start; fixed.size() - loop_begin < topology.n_vertices();) {
+            fixed.push_back(topology.from_vertex(h));
+            auto a = mesh_.positions[topology.from_vertex(h)];
+            auto b = mesh_.positions[topology.to_vertex(h)];
+            arc_length.push_back(arc_length.back() + (b - a).GetLength());
+            h = topology.vertex_half_edge[topology.to_vertex(h)];
+            if (h == start || h < 0 || !topology.is_boundary_half_edge(h)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < fixed.size() - loop_begin; ++i) {
+            double angle = 2 * M_PI * arc_length[i] / arc_length.back();
+            fixed_values.emplace_back(
+                1.1 * c + 0.5 + 0.5 * std::cos(angle), 0.5 + 0.5 * std::sin(angle));
+        }
+    }
+    if (std::find(placed.begin(), placed.end(), false) != placed.end()) {
+        throw std::runtime_error("ARAP: The mesh needs a boundary to be parameterized.");
+    }
+
+    for (int v : isolated_vertices(topology)) {
+        fixed.push_back(v);
+        fixed_values.emplace_back(0.5, 0.5);
+    }
+    Eigen::MatrixXd fixed_uv(fixed.size(), 2);
+    for (int i = 0; i < fixed.size(); ++i) {
+        fixed_uv.row(i) << fixed_values[i][0], fixed_values[i][1];
+    }
+
+    auto tutte = LaplacianSolver::get(mesh_, LaplacianWeights::Uniform, fixed);
+    if (!tutte->succeeded()) {
+        throw std::runtime_error("ARAP: Failed to compute the initial parameterization.");
+    }
+    return tutte->solve_with_fixed_values(fixed_uv);
+}
+
+ArapReport ArapParameterization::solve(
+    Eigen::MatrixXd& uv,
+    int max_iterations,
+    double tolerance) const
+{
+    const auto& topology = *mesh_.topology;
+    const size_t face_count = topology.n_faces();
+    const size_t vertex_count = topology.n_vertices();
+    if (uv.rows() != vertex_count || uv.cols() != 2) {
+        throw std::runtime_error("ARAP: The initial parameterization does not match the mesh.");
+    }
+
+    // Per half-edge: its rotated flat vector, weighted, which the global step pulls towards.
+    std::vector<double> target_x(topology.n_half_edges());
+    std::vector<double> target_y(topology.n_half_edges());
+    std::vector<double> face_energy(face_count);
+    Eigen::MatrixXd rhs(vertex_count, 2);
+    Eigen::MatrixXd fixed_uv(fixed_vertices_.size(), 2);
+
+    ArapReport report;
+    double previous_energy = std::numeric_limits<double>::infinity();
+    for (int iteration = 0; iteration < max_iterations; ++iteration) {
+        auto start = std::chrono::steady_clock::now();
+
+        // Local step. The rotation maximizing tr(R^T S), for the 2x2 covariance S of the flat and
+        // the parameterized edges, has the angle atan2(S10 - S01, S00 + S11).
+        pxr::WorkParallelForN(face_count, [&](size_t begin, size_t end) {
+            for (size_t f = begin; f < end; ++f) {
+                const int first = topology.face_half_edge[f];
+                double du[3], dv[3];
+                double s00 = 0, s01 = 0, s10 = 0, s11 = 0;
+                for (int k = 0; k < 3; ++k) {
+                    const int h = first + k;
+                    const int from = topology.from_vertex(h), to = topology.to_vertex(h);
+                    du[k] = uv(from, 0) - uv(to, 0);
+                    dv[k] = uv(from, 1) - uv(to, 1);
+                    const double w = half_cotangent_[h];
+                    s00 += w * du[k] * edge_x_[h];
+                    s01 += w * du[k] * edge_y_[h];
+                    s10 += w * dv[k] * edge_x_[h];
+                    s11 += w * dv[k] * edge_y_[h];
+                }
+                const double angle = std::atan2(s10 - s01, s00 + s11);
+                const double cos = std::cos(angle), sin = std::sin(angle);
+
+                double energy = 0;
+                for (int k = 0; k < 3; ++k) {
+                    const int h = first + k;
+                    const double w = half_cotangent_[h];
+                    const double rx = cos * edge_x_[h] - sin * edge_y_[h];
+                    const double ry = sin * edge_x_[h] + cos * edge_y_[h];
+                    energy += w * ((du[k] - rx) * (du[k] - rx) + (dv[k] - ry) * (dv[k] - ry));
+                    target_x[h] = w * rx;
+                    target_y[h] = w * ry;
+                }
+                face_energy[f] = energy;
+            }
+        });
+
+        report.energy = std::accumulate(face_energy.begin(), face_energy.end(), 0.0);
+        if (previous_energy - report.energy <= tolerance * report.energy) {
+            report.converged = true;
+            report.iteration_milliseconds.push_back(milliseconds_since(start));
+            break;
+        }
+        previous_energy = report.energy;
+
+        // Global step. Each half-edge pulls its start by its target and its end by the opposite,
+        // and the half-edge before a corner is the one ending there.
+        pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                double x = 0, y = 0;
+                for (int i = corner_offsets_[v]; i < corner_offsets_[v + 1]; ++i) {
+                    const int h = corners_[i];
+                    const int incoming = topology.prev[h];
+                    x += target_x[h] - target_x[incoming];
+                    y += target_y[h] - target_y[incoming];
+                }
+                rhs(v, 0) = x;
+                rhs(v, 1) = y;
+            }
+        });
+        for (int i = 0; i < fixed_vertices_.size(); ++i) {
+            fixed_uv.row(i) = uv.row(fixed_vertices_[i]);
+        }
+        uv = solver_->solve(rhs, fixed_uv);
+
+        report.iteration_milliseconds.push_back(milliseconds_since(start));
+    }
+    return report;
+}
+
+ArapDeformation::ArapDeformation(const HalfEdgeMesh& rest, const std::vector<int>& handles)
+    : handles_(handles)
+{
+    const size_t vertex_count = rest->n_vertices();
+    rest_positions_.resize(vertex_count, 3);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        const auto& position = rest.positions[v];
+        rest_positions_.row(v) << position[0], position[1], position[2];
+    }
+
+    auto weights = LaplacianPattern::get(rest.topology)->triangles ? LaplacianWeights::Cotangent
+                                                                   : LaplacianWeights::Uniform;
+    auto fixed = handles;
+    for (int v : isolated_vertices(*rest.topology)) {
+        if (std::find(handles.begin(), handles.end(), v) == handles.end()) {
+            fixed.push_back(v);
+            handles_.push_back(v);
+        }
+    }
+    laplacian_ = assemble_laplacian(rest, weights);
+    solver_ = LaplacianSolver::get(rest, weights, fixed);
+    if (!solver_->succeeded()) {
+        throw std::runtime_error("ARAP: Failed to factorize the Laplacian.");
+    }
+}
+
+ArapReport ArapDeformation::solve(
+    Eigen::MatrixXd& positions,
+    int max_iterations,
+    double tolerance) const
+{
+    const Eigen::Index vertex_count = rest_positions_.rows();
+    if (positions.rows() != vertex_count || positions.cols() != 3) {
+        throw std::runtime_error("ARAP: The initial positions do not match the mesh.");
+    }
+
+    std::vector<Eigen::Matrix3d> rotations(vertex_count);
+    std::vector<double> vertex_energy(vertex_count);
+    Eigen::MatrixXd rhs(vertex_count, 3);
+    Eigen::MatrixXd fixed_positions(handles_.size(), 3);
+    for (int i = 0; i < handles_.size(); ++i) {
+        fixed_positions.row(i) = positions.row(handles_[i]);
+    }
+
+    // The off-diagonal entries of a Laplacian row are the negated weights of the neighbors.
+    auto for_each_neighbor = [this](Eigen::Index v, auto&& function) {
+        for (LaplacianMatrix::InnerIterator it(laplacian_, v); it; ++it) {
+            if (it.col() != v) {
+                function(it.col(), -it.value());
+            }
+        }
+    };
+
+    ArapReport report;
+    double previous_energy = std::numeric_limits<double>::infinity();
+    for (int iteration = 0; iteration < max_iterations; ++iteration) {
+        auto start = std::chrono::steady_clock::now();
+
+        // Local step: the rotation closest to the covariance of the rest and deformed edges.
+        pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+                for_each_neighbor(v, [&](Eigen::Index u, double w) {
+                    Eigen::Vector3d rest_edge = rest_positions_.row(v) - rest_positions_.row(u);
+                    Eigen::Vector3d edge = positions.row(v) - positions.row(u);
+                    covariance += w * rest_edge * edge.transpose();
+                });
+
+                Eigen::JacobiSVD<Eigen::Matrix3d> svd(
+                    covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+                Eigen::Matrix3d u = svd.matrixU();
+                Eigen::Matrix3d rotation = svd.matrixV() * u.transpose();
+                if (rotation.determinant() < 0) {
+                    u.col(2) *= -1;
+                    rotation = svd.matrixV() * u.transpose();
+                }
+                rotations[v] = rotation;
+
+                double energy = 0;
+                for_each_neighbor(v, [&](Eigen::Index u, double w) {
+                    Eigen::Vector3d rest_edge = rest_positions_.row(v) - rest_positions_.row(u);
+                    Eigen::Vector3d edge = positions.row(v) - positions.row(u);
+                    energy += w * (edge - rotation * rest_edge).squaredNorm();
+                });
+                vertex_energy[v] = energy;
+            }
+        });
+
+        report.energy = std::accumulate(vertex_energy.begin(), vertex_energy.end(), 0.0);
+        if (previous_energy - report.energy <= tolerance * report.energy) {
+            report.converged = true;
+            report.iteration_milliseconds.push_back(milliseconds_since(start));
+            break;
+        }
+        previous_energy = report.energy;
+
+        // Global step.
+        pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                Eigen::Vector3d b = Eigen::Vector3d::Zero();
+                for_each_neighbor(v, [&](Eigen::Index u, double w) {
+                    Eigen::Vector3d rest_edge = rest_positions_.row(v) - rest_positions_.row(u);
+                    b += 0.5 * w * (rotations[v] + rotations[u]) * rest_edge;
+                });
+                rhs.row(v) = b.transpose();
+            }
+        });
+        positions = solver_->solve(rhs, fixed_positions);
+
+        report.iteration_milliseconds.push_back(milliseconds_since(start));
+    }
+    return report;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
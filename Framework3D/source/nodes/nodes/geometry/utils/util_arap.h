@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "util_laplacian.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+struct ArapReport {
+    std::vector<float> iteration_milliseconds;
+    double energy = 0;
+    bool converged = false;
+};
+
+// As-rigid-as-possible parameterization of a triangle mesh with a boundary (Liu et al. 2008).
+//
+// The local step fits a rotation to every triangle in closed form, in parallel. The global step
+// solves the cotangent Laplacian with one vertex of each connected component pinned, which is
+// factorized once for the mesh and then only substituted, for u and v together.
+class ArapParameterization {
+   public:
+    explicit ArapParameterization(const HalfEdgeMesh& mesh);
+
+    // Tutte embedding with the boundary loop on the circle inscribed in [0, 1]^2, and that of the
+    // c-th connected component moved by 1.1 c along u.
+    Eigen::MatrixXd initial_uv() const;
+
+    // Iterates from uv, with a row per vertex, until the energy decreases by less than tolerance
+    // relative to it.
+    ArapReport solve(Eigen::MatrixXd& uv, int max_iterations, double tolerance) const;
+
+   private:
+    HalfEdgeMesh mesh_;
+    // Vertices with no face are pinned too, they would make the system singular.
+    std::vector<int> fixed_vertices_;
+    std::shared_ptr<const LaplacianSolver> solver_;
+
+    // Per half-edge: its vector in the isometric flattening of its triangle, and half the
+    // cotangent of the angle opposite to it. Flat arrays, so the local step vectorizes.
+    std::vector<double> edge_x_;
+    std::vector<double> edge_y_;
+    std::vector<double> half_cotangent_;
+
+    // The half-edges starting at each vertex, for gathering the right-hand side without atomics.
+    std::vector<int> corner_offsets_;
+    std::vector<int> corners_;
+};
+
+// As-rigid-as-possible surface deformation (Sorkine and Alexa 2007), with a rotation per vertex
+// fitted from the 3x3 covariance of its edges.
+class ArapDeformation {
+   public:
+    ArapDeformation(const HalfEdgeMesh& rest, const std::vector<int>& handles);
+
+    // Iterates from positions, with a row per vertex and the handles at their targets.
+    ArapReport solve(Eigen::MatrixXd& positions, int max_iterations, double tolerance) const;
+
+   private:
+    std::vector<int> handles_;
+    Eigen::MatrixXd rest_positions_;
+    LaplacianMatrix laplacian_;
+    std::shared_ptr<const LaplacianSolver> solver_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
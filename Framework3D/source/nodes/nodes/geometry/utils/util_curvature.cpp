@@ -0,0 +1,240 @@
+#include "util_curvature.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Signed angle between the normals of the corner triangles on both sides of half-edge h, positive
+// where the surface is convex.
+static double dihedral_angle(
+    const HalfEdgeTopology& topology,
+    const pxr::VtArray<pxr::GfVec3f>& positions,
+    int h)
+{
+    auto corner_normal = [&](int corner) {
+        const pxr::GfVec3d p(positions[topology.from_vertex(corner)]);
+        return pxr::GfCross(
+            pxr::GfVec3d(positions[topology.to_vertex(corner)]) - p,
+            pxr::GfVec3d(positions[topology.from_vertex(topology.prev[corner])]) - p);
+    };
+    const pxr::GfVec3d normal = corner_normal(h);
+    const pxr::GfVec3d opposite_normal = corner_normal(topology.opposite[h]);
+    const pxr::GfVec3d edge = pxr::GfGetNormalized(
+        pxr::GfVec3d(positions[topology.to_vertex(h)]) -
+        pxr::GfVec3d(positions[topology.from_vertex(h)]));
+    return std::atan2(
+        pxr::GfDot(pxr::GfCross(normal, opposite_normal), edge),
+        pxr::GfDot(normal, opposite_normal));
+}
+
+MeshCurvature::MeshCurvature(
+    const HalfEdgeMesh& mesh,
+    std::shared_ptr<const VertexCorners> corners)
+    : positions_(mesh.positions),
+      corners_(std::move(corners))
+{
+    const auto& topology = *mesh.topology;
+    const auto& positions = positions_;
+    const size_t vertex_count = topology.n_vertices();
+
+    mean.resize(vertex_count);
+    gaussian.resize(vertex_count);
+    max_curvature.resize(vertex_count);
+    min_curvature.resize(vertex_count);
+    max_direction.resize(vertex_count);
+    min_direction.resize(vertex_count);
+    float* mean_data = mean.data();
+    float* gaussian_data = gaussian.data();
+    float* max_data = max_curvature.data();
+    float* min_data = min_curvature.data();
+    pxr::GfVec3f* max_direction_data = max_direction.data();
+    pxr::GfVec3f* min_direction_data = min_direction.data();
+
+    // Every vertex gathers the terms of its corners, so nothing is written by two threads. The
+    // terms of a face are computed once per corner rather than stored per corner, which costs
+    // less than the memory traffic of the stored terms.
+    pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const pxr::GfVec3d xi(positions[v]);
+            pxr::GfVec3d laplacian(0), normal(0);
+            double area = 0, angle_sum = 0;
+            // The upper triangle of the symmetric edge tensor.
+            double tensor[6] = {};
+            bool boundary = false;
+
+            auto add_edge = [&](int h, const pxr::GfVec3d& edge) {
+                if (topology.opposite[h] < 0) {
+                    boundary = true;
+                    return;
+                }
+                // Half of the edge is around v, and each of its two corners at v adds half.
+                const double length = edge.GetLength();
+                const double weight = dihedral_angle(topology, positions, h) / (4 * length);
+                for (int a = 0, k = 0; a < 3; ++a) {
+                    for (int b = a; b < 3; ++b) {
+                        tensor[k++] += weight * edge[a] * edge[b];
+                    }
+                }
+            };
+
+            for (int i = corners_->offsets[v]; i < corners_->offsets[v + 1]; ++i) {
+                const int h = corners_->corners[i];
+                const int f = topology.face[h];
+                const int corner_count =
+                    topology.face_half_edge[f + 1] - topology.face_half_edge[f];
+
+                const pxr::GfVec3d xj(positions[topology.to_vertex(h)]);
+                const pxr::GfVec3d xk(positions[topology.from_vertex(topology.prev[h])]);
+                const pxr::GfVec3d eij = xj - xi, eik = xk - xi;
+                const pxr::GfVec3d cross = pxr::GfCross(eij, eik);
+                const double double_area = cross.GetLength();
+                normal += cross;
+                add_edge(h, eij);
+                add_edge(topology.prev[h], eik);
+                if (double_area == 0) {
+                    continue;
+                }
+
+                const double cos_i = pxr::GfDot(eij, eik);
+                const double cot_j = pxr::GfDot(xi - xj, xk - xj) / double_area;
+                const double cot_k = pxr::GfDot(xi - xk, xj - xk) / double_area;
+                angle_sum += std::atan2(double_area, cos_i);
+                laplacian += 0.5 * (cot_k * eij + cot_j * eik);
+
+                const double triangle_area = 0.5 * double_area;
+                if (corner_count != 3) {
+                    area += 2 * triangle_area / corner_count;
+                }
+                else if (cos_i < 0) {
+                    area += triangle_area / 2;
+                }
+                else if (cot_j < 0 || cot_k < 0) {
+                    area += triangle_area / 4;
+                }
+                else {
+                    area += (eij.GetLengthSq() * cot_k + eik.GetLengthSq() * cot_j) / 8;
+                }
+            }
+
+            if (area <= 0 || normal.GetLengthSq() == 0) {
+                mean_data[v] = gaussian_data[v] = max_data[v] = min_data[v] = 0;
+                max_direction_data[v] = min_direction_data[v] = pxr::GfVec3f(0);
+                continue;
+            }
+            normal.Normalize();
+
+            const double H = -pxr::GfDot(laplacian, normal) / (2 * area);
+            const double K = ((boundary ? M_PI : 2 * M_PI) - angle_sum) / area;
+            const double spread = std::sqrt(std::max(H * H - K, 0.0));
+            mean_data[v] = static_cast<float>(H);
+            gaussian_data[v] = static_cast<float>(K);
+            max_data[v] = static_cast<float>(H + spread);
+            min_data[v] = static_cast<float>(H - spread);
+
+            // The edges bend across themselves, so the tensor is largest along the direction of
+            // least curvature.
+            pxr::GfVec3d t1 = std::abs(normal[0]) < 0.9 ? pxr::GfVec3d(1, 0, 0)
+                                                        : pxr::GfVec3d(0, 1, 0);
+            t1 = pxr::GfGetNormalized(t1 - pxr::GfDot(t1, normal) * normal);
+            const pxr::GfVec3d t2 = pxr::GfCross(normal, t1);
+            auto quadratic_form = [&](const pxr::GfVec3d& x, const pxr::GfVec3d& y) {
+                return tensor[0] * x[0] * y[0] + tensor[3] * x[1] * y[1] +
+                       tensor[5] * x[2] * y[2] + tensor[1] * (x[0] * y[1] + x[1] * y[0]) +
+                       tensor[2] * (x[0] * y[2] + x[2] * y[0]) +
+                       tensor[4] * (x[1] * y[2] + x[2] * y[1]);
+            };
+            const double theta = 0.5 * std::atan2(
+                                           2 * quadratic_form(t1, t2),
+                                           quadratic_form(t1, t1) - quadratic_form(t2, t2));
+            const pxr::GfVec3d min_dir = std::cos(theta) * t1 + std::sin(theta) * t2;
+            min_direction_data[v] = pxr::GfVec3f(min_dir);
+            max_direction_data[v] = pxr::GfVec3f(pxr::GfCross(normal, min_dir));
+        }
+    });
+}
+
+// The curvatures of a few meshes, for the ones in use.
+struct CurvatureCache {
+    struct Entry {
+        std::weak_ptr<const HalfEdgeTopology> topology;
+        const HalfEdgeTopology* topology_key;
+        std::shared_ptr<const MeshCurvature> curvature;
+        size_t last_used;
+    };
+
+    static constexpr size_t capacity = 8;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    size_t use_counter = 0;
+
+    static CurvatureCache& instance()
+    {
+        static CurvatureCache cache;
+        return cache;
+    }
+};
+
+std::shared_ptr<const MeshCurvature> MeshCurvature::get(const HalfEdgeMesh& mesh)
+{
+    auto& cache = CurvatureCache::instance();
+    std::shared_ptr<const VertexCorners> corners;
+    {
+        std::lock_guard lock(cache.mutex);
+        std::erase_if(cache.entries, [](const CurvatureCache::Entry& entry) {
+            return entry.topology.expired();
+        });
+        for (auto& entry : cache.entries) {
+            if (entry.topology_key != mesh.topology.get()) {
+                continue;
+            }
+            if (entry.curvature->positions_.IsIdentical(mesh.positions)) {
+                entry.last_used = ++cache.use_counter;
+                return entry.curvature;
+            }
+            corners = entry.curvature->corners_;
+        }
+    }
+
+    if (!corners) {
+        const auto& topology = *mesh.topology;
+        auto built = std::make_shared<VertexCorners>();
+        built->offsets.assign(topology.n_vertices() + 1, 0);
+        for (size_t h = 0; h < topology.n_half_edges(); ++h) {
+            ++built->offsets[topology.from_vertex(h) + 1];
+        }
+        std::partial_sum(built->offsets.begin(), built->offsets.end(), built->offsets.begin());
+        built->corners.resize(topology.n_half_edges());
+        std::vector<int> fill(built->offsets.begin(), built->offsets.end() - 1);
+        for (size_t h = 0; h < topology.n_half_edges(); ++h) {
+            built->corners[fill[topology.from_vertex(h)]++] = static_cast<int>(h);
+        }
+        corners = std::move(built);
+    }
+
+    std::shared_ptr<const MeshCurvature> curvature(new MeshCurvature(mesh, std::move(corners)));
+
+    std::lock_guard lock(cache.mutex);
+    std::erase_if(cache.entries, [&](const CurvatureCache::Entry& entry) {
+        return entry.topology_key == mesh.topology.get();
+    });
+    cache.entries.push_back({ mesh.topology, mesh.topology.get(), curvature, ++cache.use_counter });
+    while (cache.entries.size() > CurvatureCache::capacity) {
+        auto oldest = std::min_element(
+            cache.entries.begin(),
+            cache.entries.end(),
+            [](const CurvatureCache::Entry& a, const CurvatureCache::Entry& b) {
+                return a.last_used < b.last_used;
+            });
+        cache.entries.erase(oldest);
+    }
+    return curvature;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
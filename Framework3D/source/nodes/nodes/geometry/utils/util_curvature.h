@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "GCore/HalfEdgeTopology.h"
+#include "USTC_CG.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/vt/array.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Discrete curvatures per vertex, all from one parallel pass over the corners of each vertex.
+//
+// Mean and Gaussian curvatures are those of Meyer et al. 2003: the cotangent Laplacian and the
+// angle defect over mixed Voronoi areas, with the mean curvature positive on a sphere whose faces
+// wind counterclockwise seen from outside. The principal curvatures follow from them, and their
+// directions from the edge curvature tensor of Cohen-Steiner and Morvan 2003 in the tangent plane.
+// Polygons use the triangle of each corner, with its area shared among the corners.
+struct MeshCurvature {
+    // Cached by topology and points, so a graph reevaluated without moving the points reuses it.
+    // Only the curvature of the latest points of a topology is kept.
+    static std::shared_ptr<const MeshCurvature> get(const HalfEdgeMesh& mesh);
+
+    pxr::VtArray<float> mean;
+    pxr::VtArray<float> gaussian;
+    pxr::VtArray<float> max_curvature;
+    pxr::VtArray<float> min_curvature;
+    // Unit tangent vectors, defined up to sign, and arbitrary where both curvatures are equal.
+    pxr::VtArray<pxr::GfVec3f> max_direction;
+    pxr::VtArray<pxr::GfVec3f> min_direction;
+
+   private:
+    // The corners of each vertex, also around non-manifold vertices. Shared by the curvatures of
+    // the same topology.
+    struct VertexCorners {
+        std::vector<int> offsets;
+        std::vector<int> corners;
+    };
+
+    MeshCurvature(const HalfEdgeMesh& mesh, std::shared_ptr<const VertexCorners> corners);
+
+    // Held so that its buffer, which identifies it in the cache, is not reused by other points.
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    std::shared_ptr<const VertexCorners> corners_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
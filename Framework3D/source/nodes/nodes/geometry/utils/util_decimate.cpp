@@ -0,0 +1,743 @@
+#include "util_decimate.h"
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
+
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Boundary edges keep their place through planes orthogonal to their face, weighted against the
+// unit weight of the face planes.
+static constexpr double kBoundaryWeight = 100;
+// A collapse may not turn a triangle by more than about 78 degrees, which also rejects folds.
+static constexpr double kMinNormalCosine = 0.2;
+
+// A 32-bit hash of the round and the edge (SplitMix64).
+static uint64_t draw(uint64_t round, uint64_t edge)
+{
+    uint64_t x = round * 0x9e3779b97f4a7c15ull + edge;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return (x ^ (x >> 31)) >> 32;
+}
+
+namespace {
+
+// The squared distance to a set of planes, as the upper triangle of a symmetric 4x4 matrix.
+struct Quadric {
+    double a[10] = {};
+
+    static Quadric plane(const Eigen::Vector3d& n, double d, double weight)
+    {
+        Quadric q;
+        const double coefficients[4] = { n.x(), n.y(), n.z(), d };
+        for (int i = 0, k = 0; i < 4; ++i) {
+            for (int j = i; j < 4; ++j) {
+                q.a[k++] = weight * coefficients[i] * coefficients[j];
+            }
+        }
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (int k = 0; k < 10; ++k) {
+            a[k] += other.a[k];
+        }
+        return *this;
+    }
+
+    double evaluate(const Eigen::Vector3d& p) const
+    {
+        const double x = p.x(), y = p.y(), z = p.z();
+        return a[0] * x * x + a[4] * y * y + a[7] * z * z +
+               2 * (a[1] * x * y + a[2] * x * z + a[5] * y * z) +
+               2 * (a[3] * x + a[6] * y + a[8] * z) + a[9];
+    }
+
+    // False when the planes do not pin a point down, e.g. on a flat or cylindrical patch.
+    bool minimize(Eigen::Vector3d& p) const
+    {
+        Eigen::Matrix3d A;
+        A << a[0], a[1], a[2], a[1], a[4], a[5], a[2], a[5], a[7];
+        Eigen::FullPivLU<Eigen::Matrix3d> lu(A);
+        lu.setThreshold(1e-8);
+        if (!lu.isInvertible()) {
+            return false;
+        }
+        p = lu.solve(-Eigen::Vector3d(a[3], a[6], a[8]));
+        return true;
+    }
+};
+
+Quadric operator+(Quadric lhs, const Quadric& rhs)
+{
+    return lhs += rhs;
+}
+
+// How an attribute is carried: its values are interpolated per vertex, or follow the triangles
+// per corner or per face. Any other count of values is written back unchanged.
+enum class Interpolation { Unchanged, Vertex, Corner, Face };
+
+struct Attribute {
+    Interpolation interpolation = Interpolation::Unchanged;
+    int offset = 0;
+    int dimension = 0;
+};
+
+enum VertexFlags : uint8_t { kBoundary = 1, kLocked = 2 };
+
+// What a round needs beyond the half-edge topology of its triangles.
+struct Connectivity {
+    // All the half-edges going out of each vertex, also around non-manifold vertices.
+    std::vector<int> corner_offsets;
+    std::vector<int> corners;
+    std::vector<int> edge_faces;
+    std::vector<uint8_t> vertex_flags;
+
+    template<typename Function>
+    void for_each_corner(int v, Function&& function) const
+    {
+        for (int i = corner_offsets[v]; i < corner_offsets[v + 1]; ++i) {
+            function(corners[i]);
+        }
+    }
+};
+
+class Decimator {
+   public:
+    explicit Decimator(const MeshComponent& mesh);
+
+    DecimationReport run(size_t target_triangles, double max_error);
+    void write(MeshComponent& output) const;
+
+   private:
+    size_t triangle_count() const
+    {
+        return counts_.size();
+    }
+
+    Connectivity connect(const HalfEdgeTopology& topology) const;
+    void initialize_quadrics(const HalfEdgeTopology& topology, const Connectivity& connectivity);
+    bool is_seam(const Connectivity& connectivity, int v) const;
+    bool folds(
+        const HalfEdgeTopology& topology,
+        const Connectivity& connectivity,
+        int a,
+        int b,
+        const Eigen::Vector3d& position) const;
+    void remove_degenerate_triangles(const std::vector<int>& remap);
+
+    template<typename Vec>
+    void gather(const pxr::VtArray<Vec>& values, const Attribute& attribute);
+    template<typename Vec>
+    void scatter(
+        const Attribute& attribute,
+        const std::vector<int>& kept_vertices,
+        const pxr::VtArray<Vec>& input,
+        pxr::VtArray<Vec>& output) const;
+
+    std::vector<Eigen::Vector3d> positions_;
+    std::vector<Quadric> quadrics_;
+    pxr::VtArray<int> counts_;
+    pxr::VtArray<int> triangles_;
+
+    // For each triangle corner and triangle of the fan triangulation, where it came from.
+    std::vector<int> corner_sources_;
+    std::vector<int> face_sources_;
+
+    Attribute normals_, texcoords_, colors_;
+    pxr::VtArray<pxr::GfVec3f> input_normals_, input_colors_;
+    pxr::VtArray<pxr::GfVec2f> input_texcoords_;
+
+    // Packed attribute values, with a stride per interpolation.
+    int strides_[4] = {};
+    std::vector<float> values_[4];
+};
+
+}  // namespace
+
+Decimator::Decimator(const MeshComponent& mesh)
+    : input_normals_(mesh.normals),
+      input_colors_(mesh.displayColor),
+      input_texcoords_(mesh.texcoordsArray)
+{
+    positions_.resize(mesh.vertices.size());
+    for (size_t v = 0; v < positions_.size(); ++v) {
+        const auto& p = mesh.vertices[v];
+        positions_[v] = Eigen::Vector3d(p[0], p[1], p[2]);
+    }
+
+    int corner = 0;
+    for (size_t f = 0; f < mesh.faceVertexCounts.size(); ++f) {
+        const int count = mesh.faceVertexCounts[f];
+        for (int k = 1; k + 1 < count; ++k) {
+            for (int source : { corner, corner + k, corner + k + 1 }) {
+                triangles_.push_back(mesh.faceVertexIndices[source]);
+                corner_sources_.push_back(source);
+            }
+            face_sources_.push_back(static_cast<int>(f));
+        }
+        corner += count;
+    }
+    counts_.assign(face_sources_.size(), 3);
+
+    auto layout = [&](size_t size, int dimension) {
+        Attribute attribute;
+        if (size == 0) {
+            return attribute;
+        }
+        else if (size == mesh.vertices.size()) {
+            attribute.interpolation = Interpolation::Vertex;
+        }
+        else if (size == mesh.faceVertexIndices.size()) {
+            attribute.interpolation = Interpolation::Corner;
+        }
+        else if (size == mesh.faceVertexCounts.size()) {
+            attribute.interpolation = Interpolation::Face;
+        }
+        else {
+            return attribute;
+        }
+        int& stride = strides_[static_cast<int>(attribute.interpolation)];
+        attribute.offset = stride;
+        attribute.dimension = dimension;
+        stride += dimension;
+        return attribute;
+    };
+    normals_ = layout(mesh.normals.size(), 3);
+    texcoords_ = layout(mesh.texcoordsArray.size(), 2);
+    colors_ = layout(mesh.displayColor.size(), 3);
+
+    values_[static_cast<int>(Interpolation::Vertex)].resize(
+        positions_.size() * strides_[static_cast<int>(Interpolation::Vertex)]);
+    values_[static_cast<int>(Interpolation::Corner)].resize(
+        triangles_.size() * strides_[static_cast<int>(Interpolation::Corner)]);
+    values_[static_cast<int>(Interpolation::Face)].resize(
+        counts_.size() * strides_[static_cast<int>(Interpolation::Face)]);
+    gather(mesh.normals, normals_);
+    gather(mesh.texcoordsArray, texcoords_);
+    gather(mesh.displayColor, colors_);
+}
+
+template<typename Vec>
+void Decimator::gather(const pxr::VtArray<Vec>& values, const Attribute& attribute)
+{
+    const int kind = static_cast<int>(attribute.interpolation);
+    if (attribute.interpolation == Interpolation::Unchanged) {
+        return;
+    }
+    const size_t count = values_[kind].size() / strides_[kind];
+    for (size_t i = 0; i < count; ++i) {
+        size_t source = i;
+        if (attribute.interpolation == Interpolation::Corner) {
+            source = corner_sources_[i];
+        }
+        else if (attribute.interpolation == Interpolation::Face) {
+            source = face_sources_[i];
+        }
+        for (int d = 0; d < attribute.dimension; ++d) {
+            values_[kind][i * strides_[kind] + attribute.offset + d] = values[source][d];
+        }
+    }
+}
+
+Connectivity Decimator::connect(const HalfEdgeTopology& topology) const
+{
+    const size_t vertex_count = topology.n_vertices();
+    const size_t half_edge_count = topology.n_half_edges();
+
+    Connectivity connectivity;
+    auto& offsets = connectivity.corner_offsets;
+    offsets.assign(vertex_count + 1, 0);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        ++offsets[triangles_[h] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    connectivity.corners.resize(half_edge_count);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        connectivity.corners[fill[triangles_[h]]++] = static_cast<int>(h);
+    }
+
+    connectivity.edge_faces.assign(topology.n_edges(), 0);
+    for (size_t h = 0; h < half_edge_count; ++h) {
+        ++connectivity.edge_faces[topology.edge[h]];
+    }
+
+    connectivity.vertex_flags.assign(vertex_count, 0);
+    pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            uint8_t flags = 0;
+            int corner_count = 0;
+            connectivity.for_each_corner(v, [&](int h) {
+                ++corner_count;
+                for (int incident : { h, topology.prev[h] }) {
+                    const int faces = connectivity.edge_faces[topology.edge[incident]];
+                    if (faces == 1) {
+                        flags |= kBoundary;
+                    }
+                    else if (faces > 2 || topology.opposite[incident] < 0) {
+                        flags |= kLocked;
+                    }
+                }
+            });
+
+            // A fan that does not go around all the corners is one of several at the vertex.
+            int fan_count = 0;
+            topology.for_each_outgoing(v, [&](int) { ++fan_count; });
+            if (fan_count != corner_count || is_seam(connectivity, v)) {
+                flags |= kLocked;
+            }
+            connectivity.vertex_flags[v] = flags;
+        }
+    });
+    return connectivity;
+}
+
+bool Decimator::is_seam(const Connectivity& connectivity, int v) const
+{
+    const int stride = strides_[static_cast<int>(Interpolation::Corner)];
+    if (stride == 0 || connectivity.corner_offsets[v] == connectivity.corner_offsets[v + 1]) {
+        return false;
+    }
+    const float* values = values_[static_cast<int>(Interpolation::Corner)].data();
+    const float* first = values + connectivity.corners[connectivity.corner_offsets[v]] * stride;
+    bool seam = false;
+    connectivity.for_each_corner(v, [&](int h) {
+        seam = seam || !std::equal(first, first + stride, values + h * stride);
+    });
+    return seam;
+}
+
+void Decimator::initialize_quadrics(
+    const HalfEdgeTopology& topology,
+    const Connectivity& connectivity)
+{
+    const size_t face_count = topology.n_faces();
+    std::vector<Quadric> face_quadrics(face_count);
+    std::vector<Quadric> boundary_quadrics(topology.n_half_edges());
+
+    pxr::WorkParallelForN(face_count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const int* corner = triangles_.cdata() + 3 * f;
+            const Eigen::Vector3d& p0 = positions_[corner[0]];
+            Eigen::Vector3d n = (positions_[corner[1]] - p0).cross(positions_[corner[2]] - p0);
+            const double length = n.norm();
+            if (length == 0) {
+                continue;
+            }
+            n /= length;
+            face_quadrics[f] = Quadric::plane(n, -n.dot(p0), 1);
+
+            for (int k = 0; k < 3; ++k) {
+                const int h = static_cast<int>(3 * f + k);
+                if (connectivity.edge_faces[topology.edge[h]] != 1) {
+                    continue;
+                }
+                const Eigen::Vector3d& from = positions_[corner[k]];
+                Eigen::Vector3d side = (positions_[corner[(k + 1) % 3]] - from).cross(n);
+                if (side.squaredNorm() > 0) {
+                    side.normalize();
+                    boundary_quadrics[h] = Quadric::plane(side, -side.dot(from), kBoundaryWeight);
+                }
+            }
+        }
+    });
+
+    quadrics_.assign(positions_.size(), Quadric());
+    pxr::WorkParallelForN(positions_.size(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            connectivity.for_each_corner(v, [&](int h) {
+                quadrics_[v] += face_quadrics[topology.face[h]];
+                quadrics_[v] += boundary_quadrics[h];
+                quadrics_[v] += boundary_quadrics[topology.prev[h]];
+            });
+        }
+    });
+}
+
+bool Decimator::folds(
+    const HalfEdgeTopology& topology,
+    const Connectivity& connectivity,
+    int a,
+    int b,
+    const Eigen::Vector3d& position) const
+{
+    bool fold = false;
+    for (int v : { a, b }) {
+        connectivity.for_each_corner(v, [&](int h) {
+            const int v1 = topology.to_vertex(h);
+            const int v2 = topology.from_vertex(topology.prev[h]);
+            if (fold || v1 == a || v1 == b || v2 == a || v2 == b) {
+                return;
+            }
+            const Eigen::Vector3d& p1 = positions_[v1];
+            const Eigen::Vector3d& p2 = positions_[v2];
+            const Eigen::Vector3d before = (p1 - positions_[v]).cross(p2 - positions_[v]);
+            const Eigen::Vector3d after = (p1 - position).cross(p2 - position);
+            if (before.squaredNorm() == 0) {
+                return;
+            }
+            fold = before.dot(after) <= kMinNormalCosine * before.norm() * after.norm();
+        });
+    }
+    return fold;
+}
+
+DecimationReport Decimator::run(size_t target_triangles, double max_error)
+{
+    const double max_cost =
+        max_error > 0 ? max_error * max_error : std::numeric_limits<double>::infinity();
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    DecimationReport report;
+    for (uint64_t round = 0; triangle_count() > target_triangles; ++round) {
+        const HalfEdgeTopology topology(counts_, triangles_, positions_.size());
+        const Connectivity connectivity = connect(topology);
+        if (round == 0) {
+            initialize_quadrics(topology, connectivity);
+        }
+        const auto& flags = connectivity.vertex_flags;
+
+        // Price every edge that can collapse.
+        const size_t edge_count = topology.n_edges();
+        std::vector<double> costs(edge_count, infinity);
+        std::vector<Eigen::Vector3d> targets(edge_count);
+        std::vector<float> parameters(edge_count);
+        pxr::WorkParallelForN(edge_count, [&](size_t begin, size_t end) {
+            std::vector<int> ring_a, ring_b;
+            auto ring = [&](int v, std::vector<int>& ring) {
+                ring.clear();
+                connectivity.for_each_corner(v, [&](int h) {
+                    ring.push_back(topology.to_vertex(h));
+                    ring.push_back(topology.from_vertex(topology.prev[h]));
+                });
+                std::sort(ring.begin(), ring.end());
+                ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+            };
+
+            for (size_t e = begin; e < end; ++e) {
+                const int h = topology.edge_half_edge[e];
+                const int a = topology.from_vertex(h);
+                const int b = topology.to_vertex(h);
+                const int faces = connectivity.edge_faces[e];
+                if ((flags[a] | flags[b]) & kLocked) {
+                    continue;
+                }
+                // An inner edge between two boundary vertices would pinch the surface.
+                if (faces == 2 && (flags[a] & flags[b] & kBoundary)) {
+                    continue;
+                }
+
+                // The link condition: the ends only share the vertices opposite to the edge.
+                ring(a, ring_a);
+                ring(b, ring_b);
+                int shared = 0;
+                for (size_t i = 0, j = 0; i < ring_a.size() && j < ring_b.size();) {
+                    if (ring_a[i] < ring_b[j]) {
+                        ++i;
+                    }
+                    else if (ring_b[j] < ring_a[i]) {
+                        ++j;
+                    }
+                    else {
+                        ++shared, ++i, ++j;
+                    }
+                }
+                if (shared != faces) {
+                    continue;
+                }
+
+                const Quadric quadric = quadrics_[a] + quadrics_[b];
+                const Eigen::Vector3d& pa = positions_[a];
+                const Eigen::Vector3d& pb = positions_[b];
+                const Eigen::Vector3d direction = pb - pa;
+                Eigen::Vector3d position;
+                double parameter = 0;
+                if (quadric.minimize(position) &&
+                    (position - 0.5 * (pa + pb)).squaredNorm() <= direction.squaredNorm()) {
+                    parameter = std::clamp(
+                        (position - pa).dot(direction) / std::max(direction.squaredNorm(), 1e-30),
+                        0.0,
+                        1.0);
+                }
+                else {
+                    double best = infinity;
+                    for (double t : { 0.0, 0.5, 1.0 }) {
+                        const Eigen::Vector3d candidate = pa + t * direction;
+                        const double cost = quadric.evaluate(candidate);
+                        if (cost < best) {
+                            best = cost;
+                            position = candidate;
+                            parameter = t;
+                        }
+                    }
+                }
+
+                const double cost = std::max(quadric.evaluate(position), 0.0);
+                if (cost > max_cost || folds(topology, connectivity, a, b, position)) {
+                    continue;
+                }
+                costs[e] = cost;
+                targets[e] = position;
+                parameters[e] = static_cast<float>(parameter);
+            }
+        });
+
+        // Collapsing strictly by cost leaves few edges cheapest within their neighborhood on a
+        // smooth surface. So the cheapest quarter of the edges are candidates, and a candidate
+        // collapses if it wins a random draw against the candidates within two rings of both its
+        // ends. The selected edges then share no vertex and their one-rings share no triangle.
+        std::vector<double> valid_costs;
+        std::copy_if(
+            costs.begin(), costs.end(), std::back_inserter(valid_costs), [&](double cost) {
+                return cost < infinity;
+            });
+        if (valid_costs.empty()) {
+            break;
+        }
+        const auto quantile = valid_costs.begin() + valid_costs.size() / 4;
+        std::nth_element(valid_costs.begin(), quantile, valid_costs.end());
+        const double threshold = *quantile;
+
+        constexpr uint64_t kNotCandidate = std::numeric_limits<uint64_t>::max();
+        std::vector<uint64_t> draws(edge_count);
+        pxr::WorkParallelForN(edge_count, [&](size_t begin, size_t end) {
+            for (size_t e = begin; e < end; ++e) {
+                draws[e] = costs[e] <= threshold ? draw(round, e) << 32 | e : kNotCandidate;
+            }
+        });
+
+        const size_t vertex_count = positions_.size();
+        std::vector<uint64_t> best(vertex_count, kNotCandidate), best_around(vertex_count);
+        pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                connectivity.for_each_corner(v, [&](int h) {
+                    best[v] = std::min(
+                        { best[v],
+                          draws[topology.edge[h]],
+                          draws[topology.edge[topology.prev[h]]] });
+                });
+            }
+        });
+        pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                best_around[v] = best[v];
+                connectivity.for_each_corner(v, [&](int h) {
+                    best_around[v] = std::min(
+                        { best_around[v],
+                          best[topology.to_vertex(h)],
+                          best[topology.from_vertex(topology.prev[h])] });
+                });
+            }
+        });
+
+        std::vector<int> selected;
+        for (size_t e = 0; e < edge_count; ++e) {
+            const int h = topology.edge_half_edge[e];
+            if (draws[e] != kNotCandidate && best_around[topology.from_vertex(h)] == draws[e] &&
+                best_around[topology.to_vertex(h)] == draws[e]) {
+                selected.push_back(static_cast<int>(e));
+            }
+        }
+
+        // Near the target, only the cheapest collapses that reach it.
+        std::sort(selected.begin(), selected.end(), [&](int e, int f) {
+            return costs[e] < costs[f];
+        });
+        size_t removed = 0, kept = 0;
+        while (kept < selected.size() && triangle_count() - removed > target_triangles) {
+            removed += connectivity.edge_faces[selected[kept++]];
+        }
+        selected.resize(kept);
+        report.error = std::max(report.error, std::sqrt(costs[selected.back()]));
+
+        // Collapse b into a.
+        std::vector<int> remap(vertex_count);
+        std::iota(remap.begin(), remap.end(), 0);
+        const int vertex_stride = strides_[static_cast<int>(Interpolation::Vertex)];
+        const int corner_stride = strides_[static_cast<int>(Interpolation::Corner)];
+        pxr::WorkParallelForN(selected.size(), [&](size_t begin, size_t end) {
+            std::vector<float> corner_value(corner_stride);
+            for (size_t i = begin; i < end; ++i) {
+                const int e = selected[i];
+                const int h = topology.edge_half_edge[e];
+                const int a = topology.from_vertex(h);
+                const int b = topology.to_vertex(h);
+                const float t = parameters[e];
+
+                positions_[a] = targets[e];
+                quadrics_[a] += quadrics_[b];
+                remap[b] = a;
+
+                float* values = values_[static_cast<int>(Interpolation::Vertex)].data();
+                for (int d = 0; d < vertex_stride; ++d) {
+                    float& value = values[a * vertex_stride + d];
+                    value += t * (values[b * vertex_stride + d] - value);
+                }
+
+                // Neither end is on a seam, so each has one value for all its corners.
+                if (corner_stride > 0) {
+                    float* corners = values_[static_cast<int>(Interpolation::Corner)].data();
+                    const float* value_a = corners + h * corner_stride;
+                    const float* value_b = corners + topology.next[h] * corner_stride;
+                    for (int d = 0; d < corner_stride; ++d) {
+                        corner_value[d] = value_a[d] + t * (value_b[d] - value_a[d]);
+                    }
+                    for (int v : { a, b }) {
+                        connectivity.for_each_corner(v, [&](int corner) {
+                            std::copy(
+                                corner_value.begin(),
+                                corner_value.end(),
+                                corners + corner * corner_stride);
+                        });
+                    }
+                }
+            }
+        });
+        remove_degenerate_triangles(remap);
+    }
+
+    report.triangle_count = triangle_count();
+    return report;
+}
+
+void Decimator::remove_degenerate_triangles(const std::vector<int>& remap)
+{
+    const size_t count = triangle_count();
+    std::vector<int> kept_before(count + 1, 0);
+    pxr::WorkParallelForN(count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            int* corner = triangles_.data() + 3 * f;
+            for (int k = 0; k < 3; ++k) {
+                corner[k] = remap[corner[k]];
+            }
+            kept_before[f + 1] =
+                corner[0] != corner[1] && corner[1] != corner[2] && corner[2] != corner[0];
+        }
+    });
+    std::partial_sum(kept_before.begin(), kept_before.end(), kept_before.begin());
+    const size_t kept = kept_before.back();
+
+    const int corner_stride = strides_[static_cast<int>(Interpolation::Corner)];
+    const int face_stride = strides_[static_cast<int>(Interpolation::Face)];
+    const auto& corner_values = values_[static_cast<int>(Interpolation::Corner)];
+    const auto& face_values = values_[static_cast<int>(Interpolation::Face)];
+
+    pxr::VtArray<int> triangles(3 * kept);
+    std::vector<float> kept_corner_values(3 * kept * corner_stride);
+    std::vector<float> kept_face_values(kept * face_stride);
+    pxr::WorkParallelForN(count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const size_t target = kept_before[f];
+            if (kept_before[f + 1] == kept_before[f]) {
+                continue;
+            }
+            std::copy_n(triangles_.cdata() + 3 * f, 3, triangles.data() + 3 * target);
+            std::copy_n(
+                corner_values.data() + 3 * f * corner_stride,
+                3 * corner_stride,
+                kept_corner_values.data() + 3 * target * corner_stride);
+            std::copy_n(
+                face_values.data() + f * face_stride,
+                face_stride,
+                kept_face_values.data() + target * face_stride);
+        }
+    });
+
+    triangles_ = std::move(triangles);
+    counts_.assign(kept, 3);
+    values_[static_cast<int>(Interpolation::Corner)] = std::move(kept_corner_values);
+    values_[static_cast<int>(Interpolation::Face)] = std::move(kept_face_values);
+}
+
+template<typename Vec>
+void Decimator::scatter(
+    const Attribute& attribute,
+    const std::vector<int>& kept_vertices,
+    const pxr::VtArray<Vec>& input,
+    pxr::VtArray<Vec>& output) const
+{
+    const int kind = static_cast<int>(attribute.interpolation);
+    size_t count = 0;
+    switch (attribute.interpolation) {
+        case Interpolation::Unchanged: output = input; return;
+        case Interpolation::Vertex: count = kept_vertices.size(); break;
+        case Interpolation::Corner: count = triangles_.size(); break;
+        case Interpolation::Face: count = counts_.size(); break;
+    }
+
+    output.resize(count);
+    Vec* values = output.data();
+    pxr::WorkParallelForN(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const size_t source =
+                attribute.interpolation == Interpolation::Vertex ? kept_vertices[i] : i;
+            for (int d = 0; d < attribute.dimension; ++d) {
+                values[i][d] = values_[kind][source * strides_[kind] + attribute.offset + d];
+            }
+        }
+    });
+}
+
+void Decimator::write(MeshComponent& output) const
+{
+    std::vector<int> new_index(positions_.size(), -1);
+    for (int v : triangles_) {
+        new_index[v] = 0;
+    }
+    std::vector<int> kept_vertices;
+    for (size_t v = 0; v < positions_.size(); ++v) {
+        if (new_index[v] == 0) {
+            new_index[v] = static_cast<int>(kept_vertices.size());
+            kept_vertices.push_back(static_cast<int>(v));
+        }
+    }
+
+    output.vertices.resize(kept_vertices.size());
+    pxr::GfVec3f* vertices = output.vertices.data();
+    pxr::WorkParallelForN(kept_vertices.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Eigen::Vector3d& p = positions_[kept_vertices[i]];
+            vertices[i] = pxr::GfVec3f(p.x(), p.y(), p.z());
+        }
+    });
+
+    output.faceVertexCounts = counts_;
+    output.faceVertexIndices.resize(triangles_.size());
+    int* indices = output.faceVertexIndices.data();
+    pxr::WorkParallelForN(triangles_.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            indices[i] = new_index[triangles_[i]];
+        }
+    });
+
+    scatter(normals_, kept_vertices, input_normals_, output.normals);
+    if (normals_.interpolation != Interpolation::Unchanged) {
+        for (auto& normal : output.normals) {
+            normal.Normalize();
+        }
+    }
+    scatter(texcoords_, kept_vertices, input_texcoords_, output.texcoordsArray);
+    scatter(colors_, kept_vertices, input_colors_, output.displayColor);
+}
+
+DecimationReport decimate_mesh(
+    const MeshComponent& mesh,
+    size_t target_triangles,
+    double max_error,
+    MeshComponent& output)
+{
+    Decimator decimator(mesh);
+    auto report = decimator.run(target_triangles, max_error);
+    decimator.write(output);
+    return report;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GCore/Components/MeshOperand.h"
+#include "USTC_CG.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+struct DecimationReport {
+    size_t triangle_count = 0;
+    // Square root of the largest quadric error of the collapses, a distance to the input surface.
+    double error = 0;
+};
+
+// Quadric error simplification (Garland and Heckbert 1997) of the mesh, triangulated, into output.
+//
+// Collapses run in rounds: every round prices all the edges in parallel, picks among the cheapest
+// ones edges that no two touch the same triangle, and collapses them all in parallel. It stops at
+// target_triangles, or when no collapse is left within max_error of the input. A max_error of 0
+// does not bound the error.
+//
+// Normals, texcoordsArray and displayColor are kept, per vertex or per face corner: per vertex
+// values are interpolated along the collapsed edges, and vertices on a seam of face corner values
+// are not moved. Non-manifold vertices are not moved either, and boundaries only collapse along
+// themselves.
+DecimationReport decimate_mesh(
+    const MeshComponent& mesh,
+    size_t target_triangles,
+    double max_error,
+    MeshComponent& output);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,349 @@
+#include "util_laplacian.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include "pxr/base/gf/vec3d.h"
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static std::shared_ptr<LaplacianPattern> build_pattern(const HalfEdgeTopology& topology)
+{
+    auto pattern = std::make_shared<LaplacianPattern>();
+    const size_t vertex_count = topology.n_vertices();
+    const size_t edge_count = topology.n_edges();
+
+    auto edge_ends = [&topology](size_t e) {
+        int h = topology.edge_half_edge[e];
+        return std::make_pair(topology.from_vertex(h), topology.to_vertex(h));
+    };
+
+    auto& row_offsets = pattern->row_offsets;
+    row_offsets.assign(vertex_count + 1, 1);
+    row_offsets[0] = 0;
+    for (size_t e = 0; e < edge_count; ++e) {
+        auto [a, b] = edge_ends(e);
+        if (a != b) {
+            ++row_offsets[a + 1];
+            ++row_offsets[b + 1];
+        }
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        row_offsets[v + 1] += row_offsets[v];
+    }
+
+    auto& columns = pattern->columns;
+    columns.resize(row_offsets.back());
+    std::vector<int> fill(row_offsets.begin(), row_offsets.end() - 1);
+    for (size_t v = 0; v < vertex_count; ++v) {
+        columns[fill[v]++] = static_cast<int>(v);
+    }
+    for (size_t e = 0; e < edge_count; ++e) {
+        auto [a, b] = edge_ends(e);
+        if (a != b) {
+            columns[fill[a]++] = b;
+            columns[fill[b]++] = a;
+        }
+    }
+
+    auto slot = [&](int row, int column) {
+        auto first = columns.begin() + row_offsets[row];
+        auto last = columns.begin() + row_offsets[row + 1];
+        return static_cast<int>(std::lower_bound(first, last, column) - columns.begin());
+    };
+
+    pattern->diagonal_slot.resize(vertex_count);
+    pxr::WorkParallelForN(vertex_count, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            std::sort(columns.begin() + row_offsets[v], columns.begin() + row_offsets[v + 1]);
+            pattern->diagonal_slot[v] = slot(v, v);
+        }
+    });
+
+    pattern->edge_slots.resize(edge_count);
+    pxr::WorkParallelForN(edge_count, [&](size_t begin, size_t end) {
+        for (size_t e = begin; e < end; ++e) {
+            auto [a, b] = edge_ends(e);
+            pattern->edge_slots[e] = a != b ? std::make_pair(slot(a, b), slot(b, a))
+                                            : std::make_pair(-1, -1);
+        }
+    });
+
+    for (size_t f = 0; f < topology.n_faces(); ++f) {
+        if (topology.face_half_edge[f + 1] - topology.face_half_edge[f] != 3) {
+            pattern->triangles = false;
+            break;
+        }
+    }
+    return pattern;
+}
+
+std::shared_ptr<const LaplacianPattern> LaplacianPattern::get(
+    const std::shared_ptr<const HalfEdgeTopology>& topology)
+{
+    static std::mutex mutex;
+    static std::map<
+        const HalfEdgeTopology*,
+        std::pair<std::weak_ptr<const HalfEdgeTopology>, std::shared_ptr<const LaplacianPattern>>>
+        patterns;
+
+    std::lock_guard lock(mutex);
+    std::erase_if(patterns, [](const auto& entry) { return entry.second.first.expired(); });
+
+    auto& entry = patterns[topology.get()];
+    if (!entry.second) {
+        entry = { topology, build_pattern(*topology) };
+    }
+    return entry.second;
+}
+
+// Half the cotangent of the angle opposite to the half-edge in its triangle.
+static double half_cotangent(const HalfEdgeMesh& mesh, int h)
+{
+    const auto& topology = *mesh.topology;
+    pxr::GfVec3d a(mesh.positions[topology.from_vertex(h)]);
+    pxr::GfVec3d b(mesh.positions[topology.to_vertex(h)]);
+    pxr::GfVec3d c(mesh.positions[topology.from_vertex(topology.prev[h])]);
+    double sine = pxr::GfCross(a - c, b - c).GetLength();
+    if (sine < 1e-12) {
+        return 0;
+    }
+    return 0.5 * pxr::GfDot(a - c, b - c) / sine;
+}
+
+LaplacianMatrix assemble_laplacian(const HalfEdgeMesh& mesh, LaplacianWeights weights)
+{
+    const auto& topology = *mesh.topology;
+    auto pattern = LaplacianPattern::get(mesh.topology);
+    if (weights == LaplacianWeights::Cotangent && !pattern->triangles) {
+        throw std::runtime_error("Cotangent weights need a triangle mesh.");
+    }
+
+    const auto vertex_count = static_cast<Eigen::Index>(topology.n_vertices());
+    LaplacianMatrix laplacian(vertex_count, vertex_count);
+    laplacian.resizeNonZeros(static_cast<Eigen::Index>(pattern->columns.size()));
+    std::copy(
+        pattern->row_offsets.begin(), pattern->row_offsets.end(), laplacian.outerIndexPtr());
+    std::copy(pattern->columns.begin(), pattern->columns.end(), laplacian.innerIndexPtr());
+    double* values = laplacian.valuePtr();
+
+    pxr::WorkParallelForN(topology.n_edges(), [&](size_t begin, size_t end) {
+        for (size_t e = begin; e < end; ++e) {
+            auto [forward, backward] = pattern->edge_slots[e];
+            if (forward < 0) {
+                continue;
+            }
+            double weight = 1;
+            if (weights == LaplacianWeights::Cotangent) {
+                int h = topology.edge_half_edge[e];
+                weight = half_cotangent(mesh, h);
+                if (topology.opposite[h] >= 0) {
+                    weight += half_cotangent(mesh, topology.opposite[h]);
+                }
+            }
+            values[forward] = -weight;
+            values[backward] = -weight;
+        }
+    });
+
+    pxr::WorkParallelForN(topology.n_vertices(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            int diagonal = pattern->diagonal_slot[v];
+            double sum = 0;
+            for (int slot = pattern->row_offsets[v]; slot < pattern->row_offsets[v + 1]; ++slot) {
+                if (slot != diagonal) {
+                    sum += values[slot];
+                }
+            }
+            values[diagonal] = -sum;
+        }
+    });
+
+    return laplacian;
+}
+
+static size_t hash_values(const LaplacianMatrix& laplacian)
+{
+    // FNV-1a over the bits of the values.
+    size_t hash = 14695981039346656037ull;
+    auto bytes = reinterpret_cast<const unsigned char*>(laplacian.valuePtr());
+    const size_t size = static_cast<size_t>(laplacian.nonZeros()) * sizeof(double);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// A few factorizations, for the meshes and fixed vertices in use. Factorizing happens outside of
+// the lock, with the entry being refactorized taken out of the cache meanwhile.
+struct LaplacianSolverCache {
+    struct Entry {
+        std::weak_ptr<const HalfEdgeTopology> topology;
+        const HalfEdgeTopology* topology_key;
+        std::vector<int> fixed_vertices;
+        size_t weight_hash;
+        std::shared_ptr<LaplacianSolver> solver;
+        size_t last_used;
+    };
+
+    static constexpr size_t capacity = 8;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    size_t use_counter = 0;
+
+    static LaplacianSolverCache& instance()
+    {
+        static LaplacianSolverCache cache;
+        return cache;
+    }
+
+    void insert(Entry entry)
+    {
+        std::lock_guard lock(mutex);
+        entry.last_used = ++use_counter;
+        entries.push_back(std::move(entry));
+        while (entries.size() > capacity) {
+            auto oldest = std::min_element(
+                entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                    return a.last_used < b.last_used;
+                });
+            entries.erase(oldest);
+        }
+    }
+};
+
+std::shared_ptr<const LaplacianSolver> LaplacianSolver::get(
+    const HalfEdgeMesh& mesh,
+    LaplacianWeights weights,
+    const std::vector<int>& fixed_vertices)
+{
+    auto laplacian = assemble_laplacian(mesh, weights);
+    size_t weight_hash = hash_values(laplacian);
+
+    auto& cache = LaplacianSolverCache::instance();
+    std::unique_lock lock(cache.mutex);
+    std::erase_if(cache.entries, [](const LaplacianSolverCache::Entry& entry) {
+        return entry.topology.expired();
+    });
+
+    auto same_structure = [&](const LaplacianSolverCache::Entry& entry) {
+        return entry.topology_key == mesh.topology.get() &&
+               entry.fixed_vertices == fixed_vertices;
+    };
+    for (auto& entry : cache.entries) {
+        if (same_structure(entry) && entry.weight_hash == weight_hash) {
+            entry.last_used = ++cache.use_counter;
+            return entry.solver;
+        }
+    }
+
+    // The same system with other weights is refactorized in place when nobody is using it.
+    auto reusable =
+        std::find_if(cache.entries.begin(), cache.entries.end(), [&](const auto& entry) {
+            return same_structure(entry) && entry.solver.use_count() == 1;
+        });
+    if (reusable != cache.entries.end()) {
+        auto entry = std::move(*reusable);
+        cache.entries.erase(reusable);
+        lock.unlock();
+
+        entry.solver->factorize(laplacian, false);
+        entry.weight_hash = weight_hash;
+        auto solver = entry.solver;
+        cache.insert(std::move(entry));
+        return solver;
+    }
+    lock.unlock();
+
+    auto solver = std::make_shared<LaplacianSolver>();
+    const size_t vertex_count = mesh->n_vertices();
+    solver->is_fixed_.assign(vertex_count, false);
+    solver->reduced_index_.assign(vertex_count, -1);
+    for (int v : fixed_vertices) {
+        if (v < 0 || v >= vertex_count || solver->is_fixed_[v]) {
+            throw std::runtime_error("Fixed vertices must be distinct vertices of the mesh.");
+        }
+        solver->is_fixed_[v] = true;
+        solver->reduced_index_[v] = static_cast<int>(solver->fixed_vertices_.size());
+        solver->fixed_vertices_.push_back(v);
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        if (!solver->is_fixed_[v]) {
+            solver->reduced_index_[v] = static_cast<int>(solver->free_vertices_.size());
+            solver->free_vertices_.push_back(static_cast<int>(v));
+        }
+    }
+    solver->factorize(laplacian, true);
+
+    cache.insert({ mesh.topology, mesh.topology.get(), fixed_vertices, weight_hash, solver });
+    return solver;
+}
+
+void LaplacianSolver::factorize(const LaplacianMatrix& laplacian, bool analyze)
+{
+    std::vector<Eigen::Triplet<double>> free_triplets, fixed_triplets;
+    free_triplets.reserve(laplacian.nonZeros());
+    for (int i = 0; i < free_vertices_.size(); ++i) {
+        for (LaplacianMatrix::InnerIterator it(laplacian, free_vertices_[i]); it; ++it) {
+            int column = reduced_index_[it.col()];
+            if (is_fixed_[it.col()]) {
+                fixed_triplets.emplace_back(i, column, it.value());
+            }
+            else {
+                free_triplets.emplace_back(i, column, it.value());
+            }
+        }
+    }
+
+    Eigen::SparseMatrix<double> free_free(free_vertices_.size(), free_vertices_.size());
+    free_free.setFromTriplets(free_triplets.begin(), free_triplets.end());
+    free_fixed_.resize(free_vertices_.size(), fixed_vertices_.size());
+    free_fixed_.setFromTriplets(fixed_triplets.begin(), fixed_triplets.end());
+
+    if (free_vertices_.empty()) {
+        return;
+    }
+    if (analyze) {
+        solver_.analyzePattern(free_free);
+    }
+    solver_.factorize(free_free);
+}
+
+Eigen::MatrixXd LaplacianSolver::solve(
+    const Eigen::MatrixXd& rhs,
+    const Eigen::MatrixXd& fixed_values) const
+{
+    const auto vertex_count = static_cast<Eigen::Index>(is_fixed_.size());
+    if (rhs.rows() != vertex_count || fixed_values.rows() != fixed_vertices_.size() ||
+        rhs.cols() != fixed_values.cols()) {
+        throw std::runtime_error("Laplacian solve: mismatched right-hand side.");
+    }
+
+    Eigen::MatrixXd reduced(free_vertices_.size(), rhs.cols());
+    for (int i = 0; i < free_vertices_.size(); ++i) {
+        reduced.row(i) = rhs.row(free_vertices_[i]);
+    }
+    Eigen::MatrixXd result(vertex_count, rhs.cols());
+    if (!free_vertices_.empty()) {
+        reduced -= free_fixed_ * fixed_values;
+        Eigen::MatrixXd free_values = solver_.solve(reduced);
+        for (int i = 0; i < free_vertices_.size(); ++i) {
+            result.row(free_vertices_[i]) = free_values.row(i);
+        }
+    }
+    for (int i = 0; i < fixed_vertices_.size(); ++i) {
+        result.row(fixed_vertices_[i]) = fixed_values.row(i);
+    }
+    return result;
+}
+
+Eigen::MatrixXd LaplacianSolver::solve_with_fixed_values(const Eigen::MatrixXd& fixed_values) const
+{
+    return solve(Eigen::MatrixXd::Zero(is_fixed_.size(), fixed_values.cols()), fixed_values);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
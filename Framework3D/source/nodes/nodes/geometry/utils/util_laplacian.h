@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Eigen/Sparse>
+#include <memory>
+#include <vector>
+
+#include "GCore/HalfEdgeTopology.h"
+#include "USTC_CG.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+enum class LaplacianWeights { Uniform, Cotangent };
+
+using LaplacianMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+// The sparsity of the Laplacian of a topology: one row per vertex, holding the diagonal and the
+// neighbors in increasing order. Built once per topology and shared.
+struct LaplacianPattern {
+    std::vector<int> row_offsets;
+    std::vector<int> columns;
+    std::vector<int> diagonal_slot;
+    // Slots of (a, b) and (b, a) for the edge from a to b of edge_half_edge.
+    std::vector<std::pair<int, int>> edge_slots;
+    bool triangles = true;
+
+    static std::shared_ptr<const LaplacianPattern> get(
+        const std::shared_ptr<const HalfEdgeTopology>& topology);
+};
+
+// L = D - W, with W the edge weights and D their sums per row, so L is positive semi-definite for
+// positive weights. Cotangent weights need a triangle mesh. The values are computed in parallel
+// straight into the compressed rows of the pattern.
+LaplacianMatrix assemble_laplacian(const HalfEdgeMesh& mesh, LaplacianWeights weights);
+
+// A factorization of the Laplacian restricted to the free vertices. Solving only substitutes, so
+// changing the values of the fixed vertices or the right-hand side costs no factorization.
+class LaplacianSolver {
+   public:
+    // Cached by topology, fixed vertices and a hash of the weights. A new weight hash for the same
+    // topology and fixed vertices refactorizes numerically, reusing the symbolic analysis.
+    static std::shared_ptr<const LaplacianSolver> get(
+        const HalfEdgeMesh& mesh,
+        LaplacianWeights weights,
+        const std::vector<int>& fixed_vertices);
+
+    // Solves L X = B on the free vertices, with X given on the fixed ones. B has a row per vertex
+    // and a column per coordinate, its rows of fixed vertices are not used. fixed_values has a row
+    // per fixed vertex, in the order they were given. All the columns are solved together.
+    Eigen::MatrixXd solve(const Eigen::MatrixXd& rhs, const Eigen::MatrixXd& fixed_values) const;
+    Eigen::MatrixXd solve_with_fixed_values(const Eigen::MatrixXd& fixed_values) const;
+
+    bool succeeded() const
+    {
+        return free_vertices_.empty() || solver_.info() == Eigen::Success;
+    }
+
+    size_t free_count() const
+    {
+        return free_vertices_.size();
+    }
+
+   private:
+    void factorize(const LaplacianMatrix& laplacian, bool analyze);
+
+    std::vector<int> free_vertices_;
+    std::vector<int> fixed_vertices_;
+    // Index of each vertex among the free or among the fixed ones.
+    std::vector<int> reduced_index_;
+    std::vector<bool> is_fixed_;
+    Eigen::SparseMatrix<double> free_fixed_;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -3,10 +3,14 @@
 #include "GCore/Components/MeshOperand.h"
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
-std::shared_ptr<PolyMesh> operand_to_openmesh(GOperandBase* mesh_oeprand)
+std::shared_ptr<PolyMesh> operand_to_openmesh(const GOperandBase* mesh_oeprand)
 {
     auto openmesh = std::make_shared<PolyMesh>();
     auto topology = mesh_oeprand->get_component<MeshComponent>();
+    openmesh->reserve(
+        topology->vertices.size(),
+        topology->faceVertexIndices.size() / 2,
+        topology->faceVertexCounts.size());
 
     for (const auto& vv : topology->vertices) {
         OpenMesh::Vec3f v;
@@ -16,13 +20,14 @@ std::shared_ptr<PolyMesh> operand_to_openmesh(GOperandBase* mesh_oeprand)
         openmesh->add_vertex(v);
     }
 
-    auto faceVertexIndices = topology->faceVertexIndices;
-    auto faceVertexCounts = topology->faceVertexCounts;
+    const auto& faceVertexIndices = topology->faceVertexIndices;
+    const auto& faceVertexCounts = topology->faceVertexCounts;
 
     int vertexIndex = 0;
+    std::vector<PolyMesh::VertexHandle> face_vhandles;
     for (int i = 0; i < faceVertexCounts.size(); i++) {
         // Create a vector of vertex handles for the face
-        std::vector<PolyMesh::VertexHandle> face_vhandles;
+        face_vhandles.clear();
         for (int j = 0; j < faceVertexCounts[i]; j++) {
             int index = faceVertexIndices[vertexIndex];
             // Get the vertex handle from the index
@@ -48,6 +53,9 @@ std::shared_ptr<GOperandBase> openmesh_to_operand(PolyMesh* openmesh)
     auto& points = mesh->vertices;
     auto& faceVertexIndices = mesh->faceVertexIndices;
     auto& faceVertexCounts = mesh->faceVertexCounts;
+    points.reserve(openmesh->n_vertices());
+    faceVertexCounts.reserve(openmesh->n_faces());
+    faceVertexIndices.reserve(openmesh->n_halfedges() / 2);
 
     // Set the points
     for (const auto& v : openmesh->vertices()) {
@@ -10,7 +10,7 @@ USTC_CG_NAMESPACE_OPEN_SCOPE
 class GOperandBase;
 using PolyMesh = OpenMesh::PolyMesh_ArrayKernelT<>;
 
-std::shared_ptr<PolyMesh> operand_to_openmesh(GOperandBase* mesh_oeprand);
+std::shared_ptr<PolyMesh> operand_to_openmesh(const GOperandBase* mesh_oeprand);
 
 std::shared_ptr<GOperandBase> openmesh_to_operand(PolyMesh* openmesh);
 
@@ -0,0 +1,419 @@
+#include "util_spatial_query.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include "Utils/Logging/Logging.h"
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+static void report_error(void* user, RTCError code, const char* message)
+{
+    logging(std::string("Embree: ") + message, Error);
+}
+
+// One device for the process, Embree devices are thread-safe.
+static RTCDevice device()
+{
+    static RTCDevice device = [] {
+        RTCDevice device = rtcNewDevice(nullptr);
+        if (!device) {
+            throw std::runtime_error("Failed to create the Embree device.");
+        }
+        rtcSetDeviceErrorFunction(device, report_error, nullptr);
+        return device;
+    }();
+    return device;
+}
+
+// Ericson, Real-Time Collision Detection, 5.1.5.
+static pxr::GfVec3f closest_point_on_triangle(
+    const pxr::GfVec3f& p,
+    const pxr::GfVec3f& a,
+    const pxr::GfVec3f& b,
+    const pxr::GfVec3f& c)
+{
+    const pxr::GfVec3f ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = pxr::GfDot(ab, ap), d2 = pxr::GfDot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        return a;
+    }
+
+    const pxr::GfVec3f bp = p - b;
+    const float d3 = pxr::GfDot(ab, bp), d4 = pxr::GfDot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        return b;
+    }
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        return a + (d1 / (d1 - d3)) * ab;
+    }
+
+    const pxr::GfVec3f cp = p - c;
+    const float d5 = pxr::GfDot(ab, cp), d6 = pxr::GfDot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        return c;
+    }
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        return a + (d2 / (d2 - d6)) * ac;
+    }
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+    }
+
+    const float denominator = 1 / (va + vb + vc);
+    return a + (vb * denominator) * ab + (vc * denominator) * ac;
+}
+
+// What the point query callbacks read the triangles from.
+struct Triangles {
+    const int* vertices;
+    const int* faces;
+    const pxr::GfVec3f* positions;
+
+    void corners(unsigned triangle, pxr::GfVec3f& a, pxr::GfVec3f& b, pxr::GfVec3f& c) const
+    {
+        a = positions[vertices[3 * triangle]];
+        b = positions[vertices[3 * triangle + 1]];
+        c = positions[vertices[3 * triangle + 2]];
+    }
+};
+
+struct ClosestPointQuery {
+    Triangles triangles;
+    pxr::GfVec3f point;
+    ClosestPoint result;
+};
+
+// Shrinks the query radius to the closest triangle so far, which prunes the rest of the BVH.
+static bool closest_point_callback(RTCPointQueryFunctionArguments* args)
+{
+    auto& query = *static_cast<ClosestPointQuery*>(args->userPtr);
+    pxr::GfVec3f a, b, c;
+    query.triangles.corners(args->primID, a, b, c);
+
+    auto closest = closest_point_on_triangle(query.point, a, b, c);
+    float distance = (closest - query.point).GetLength();
+    if (distance >= args->query->radius) {
+        return false;
+    }
+
+    args->query->radius = distance;
+    query.result = { distance,
+                     query.triangles.faces[args->primID],
+                     closest,
+                     pxr::GfGetNormalized(pxr::GfCross(b - a, c - a)) };
+    return true;
+}
+
+struct FacesWithinQuery {
+    Triangles triangles;
+    pxr::GfVec3f point;
+    std::vector<int> faces;
+};
+
+static bool faces_within_callback(RTCPointQueryFunctionArguments* args)
+{
+    auto& query = *static_cast<FacesWithinQuery*>(args->userPtr);
+    pxr::GfVec3f a, b, c;
+    query.triangles.corners(args->primID, a, b, c);
+
+    auto closest = closest_point_on_triangle(query.point, a, b, c);
+    if ((closest - query.point).GetLength() <= args->query->radius) {
+        query.faces.push_back(query.triangles.faces[args->primID]);
+    }
+    return false;
+}
+
+MeshSpatialQuery::MeshSpatialQuery(const HalfEdgeMesh& mesh)
+    : face_count_(mesh.topology->n_faces()),
+      vertex_count_(mesh.topology->n_vertices())
+{
+    auto& topology = *mesh.topology;
+    const size_t face_count = face_count_;
+
+    // Each polygon is fanned from its first corner.
+    std::vector<int> triangle_offsets(face_count + 1, 0);
+    for (size_t f = 0; f < face_count; ++f) {
+        int corners = topology.face_half_edge[f + 1] - topology.face_half_edge[f];
+        triangle_offsets[f + 1] = triangle_offsets[f] + std::max(corners - 2, 0);
+    }
+    const size_t triangle_count = triangle_offsets.back();
+
+    // Embree reads the indices in place, with loads that may go past the last triangle.
+    triangle_vertices_.resize(3 * triangle_count + 1);
+    triangle_face_.resize(triangle_count);
+    const int* indices = topology.face_vertex_indices.cdata();
+    pxr::WorkParallelForN(face_count, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            const int first = topology.face_half_edge[f];
+            int t = triangle_offsets[f];
+            for (int h = first + 1; h + 1 < topology.face_half_edge[f + 1]; ++h, ++t) {
+                triangle_vertices_[3 * t] = indices[first];
+                triangle_vertices_[3 * t + 1] = indices[h];
+                triangle_vertices_[3 * t + 2] = indices[h + 1];
+                triangle_face_[t] = static_cast<int>(f);
+            }
+        }
+    });
+
+    scene_ = rtcNewScene(device());
+    geometry_ = rtcNewGeometry(device(), RTC_GEOMETRY_TYPE_TRIANGLE);
+    // Moving the points later refits the BVH instead of building it again.
+    rtcSetGeometryBuildQuality(geometry_, RTC_BUILD_QUALITY_REFIT);
+    rtcSetSharedGeometryBuffer(
+        geometry_,
+        RTC_BUFFER_TYPE_INDEX,
+        0,
+        RTC_FORMAT_UINT3,
+        triangle_vertices_.data(),
+        0,
+        3 * sizeof(int),
+        triangle_count);
+    rtcSetNewGeometryBuffer(
+        geometry_,
+        RTC_BUFFER_TYPE_VERTEX,
+        0,
+        RTC_FORMAT_FLOAT3,
+        sizeof(pxr::GfVec3f),
+        topology.n_vertices());
+    rtcAttachGeometry(scene_, geometry_);
+
+    set_positions(mesh.positions);
+}
+
+MeshSpatialQuery::~MeshSpatialQuery()
+{
+    rtcReleaseGeometry(geometry_);
+    rtcReleaseScene(scene_);
+}
+
+void MeshSpatialQuery::set_positions(const pxr::VtArray<pxr::GfVec3f>& positions)
+{
+    if (positions.size() != vertex_count_) {
+        throw std::runtime_error("Spatial query: The points do not match the topology.");
+    }
+    positions_ = positions;
+
+    auto* vertices = rtcGetGeometryBufferData(geometry_, RTC_BUFFER_TYPE_VERTEX, 0);
+    std::memcpy(vertices, positions_.cdata(), positions_.size() * sizeof(pxr::GfVec3f));
+    rtcUpdateGeometryBuffer(geometry_, RTC_BUFFER_TYPE_VERTEX, 0);
+    rtcCommitGeometry(geometry_);
+    rtcCommitScene(scene_);
+}
+
+// A few structures, for the meshes in use. Building and refitting happen outside of the lock,
+// with the entry being refitted taken out of the cache meanwhile.
+struct SpatialQueryCache {
+    struct Entry {
+        std::weak_ptr<const HalfEdgeTopology> topology;
+        const HalfEdgeTopology* topology_key;
+        std::shared_ptr<MeshSpatialQuery> query;
+        size_t last_used;
+    };
+
+    static constexpr size_t capacity = 8;
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    size_t use_counter = 0;
+
+    static SpatialQueryCache& instance()
+    {
+        static SpatialQueryCache cache;
+        return cache;
+    }
+
+    void insert(Entry entry)
+    {
+        std::lock_guard lock(mutex);
+        entry.last_used = ++use_counter;
+        entries.push_back(std::move(entry));
+        while (entries.size() > capacity) {
+            auto oldest = std::min_element(
+                entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                    return a.last_used < b.last_used;
+                });
+            entries.erase(oldest);
+        }
+    }
+};
+
+std::shared_ptr<const MeshSpatialQuery> MeshSpatialQuery::get(const HalfEdgeMesh& mesh)
+{
+    auto& cache = SpatialQueryCache::instance();
+    std::unique_lock lock(cache.mutex);
+    std::erase_if(cache.entries, [](const SpatialQueryCache::Entry& entry) {
+        return entry.topology.expired();
+    });
+
+    for (auto& entry : cache.entries) {
+        if (entry.topology_key == mesh.topology.get() &&
+            entry.query->positions_.IsIdentical(mesh.positions)) {
+            entry.last_used = ++cache.use_counter;
+            return entry.query;
+        }
+    }
+
+    auto reusable =
+        std::find_if(cache.entries.begin(), cache.entries.end(), [&](const auto& entry) {
+            return entry.topology_key == mesh.topology.get() && entry.query.use_count() == 1;
+        });
+    if (reusable != cache.entries.end()) {
+        auto entry = std::move(*reusable);
+        cache.entries.erase(reusable);
+        lock.unlock();
+
+        entry.query->set_positions(mesh.positions);
+        auto query = entry.query;
+        cache.insert(std::move(entry));
+        return query;
+    }
+    lock.unlock();
+
+    std::shared_ptr<MeshSpatialQuery> query(new MeshSpatialQuery(mesh));
+    cache.insert({ mesh.topology, mesh.topology.get(), query });
+    return query;
+}
+
+std::vector<RayHit> MeshSpatialQuery::ray_cast(
+    const pxr::VtArray<pxr::GfVec3f>& origins,
+    const pxr::VtArray<pxr::GfVec3f>& directions,
+    float max_distance) const
+{
+    if (directions.size() != 1 && directions.size() != origins.size()) {
+        throw std::runtime_error("Ray cast: Need one direction, or one per origin.");
+    }
+
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+    std::vector<RayHit> hits(origins.size());
+    pxr::WorkParallelForN(origins.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& origin = origins[i];
+            auto direction = pxr::GfGetNormalized(directions[directions.size() == 1 ? 0 : i]);
+
+            RTCRayHit ray_hit;
+            ray_hit.ray.org_x = origin[0];
+            ray_hit.ray.org_y = origin[1];
+            ray_hit.ray.org_z = origin[2];
+            ray_hit.ray.dir_x = direction[0];
+            ray_hit.ray.dir_y = direction[1];
+            ray_hit.ray.dir_z = direction[2];
+            ray_hit.ray.tnear = 0;
+            ray_hit.ray.tfar = max_distance;
+            ray_hit.ray.time = 0;
+            ray_hit.ray.mask = -1;
+            ray_hit.ray.flags = 0;
+            ray_hit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+            ray_hit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+            rtcIntersect1(scene_, &ray_hit);
+
+            auto& hit = hits[i];
+            if (ray_hit.hit.geomID == RTC_INVALID_GEOMETRY_ID) {
+                hit = { infinity, -1, pxr::GfVec3f(0), pxr::GfVec3f(0) };
+                continue;
+            }
+            pxr::GfVec3f normal(ray_hit.hit.Ng_x, ray_hit.hit.Ng_y, ray_hit.hit.Ng_z);
+            normal.Normalize();
+            if (pxr::GfDot(normal, direction) > 0) {
+                normal = -normal;
+            }
+            hit = { ray_hit.ray.tfar,
+                    triangle_face_[ray_hit.hit.primID],
+                    origin + ray_hit.ray.tfar * direction,
+                    normal };
+        }
+    });
+    return hits;
+}
+
+std::vector<ClosestPoint> MeshSpatialQuery::closest_points(
+    const pxr::VtArray<pxr::GfVec3f>& points,
+    float max_distance) const
+{
+    const Triangles triangles{
+        triangle_vertices_.data(), triangle_face_.data(), positions_.cdata()
+    };
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+
+    std::vector<ClosestPoint> results(points.size());
+    pxr::WorkParallelForN(points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& point = points[i];
+            ClosestPointQuery query{
+                triangles, point, { infinity, -1, pxr::GfVec3f(0), pxr::GfVec3f(0) }
+            };
+
+            RTC_ALIGN(16) RTCPointQuery point_query;
+            point_query.x = point[0];
+            point_query.y = point[1];
+            point_query.z = point[2];
+            point_query.time = 0;
+            point_query.radius = max_distance;
+            RTCPointQueryContext context;
+            rtcInitPointQueryContext(&context);
+            rtcPointQuery(scene_, &point_query, &context, closest_point_callback, &query);
+
+            results[i] = query.result;
+        }
+    });
+    return results;
+}
+
+void MeshSpatialQuery::faces_within(
+    const pxr::VtArray<pxr::GfVec3f>& points,
+    float radius,
+    std::vector<int>& offsets,
+    std::vector<int>& faces) const
+{
+    const Triangles triangles{
+        triangle_vertices_.data(), triangle_face_.data(), positions_.cdata()
+    };
+
+    std::vector<std::vector<int>> faces_per_point(points.size());
+    pxr::WorkParallelForN(points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& point = points[i];
+            FacesWithinQuery query{ triangles, point, {} };
+
+            RTC_ALIGN(16) RTCPointQuery point_query;
+            point_query.x = point[0];
+            point_query.y = point[1];
+            point_query.z = point[2];
+            point_query.time = 0;
+            point_query.radius = radius;
+            RTCPointQueryContext context;
+            rtcInitPointQueryContext(&context);
+            rtcPointQuery(scene_, &point_query, &context, faces_within_callback, &query);
+
+            // The triangles of a polygon are found separately.
+            auto& found = query.faces;
+            std::sort(found.begin(), found.end());
+            found.erase(std::unique(found.begin(), found.end()), found.end());
+            faces_per_point[i] = std::move(found);
+        }
+    });
+
+    offsets.assign(points.size() + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        offsets[i + 1] = offsets[i] + static_cast<int>(faces_per_point[i].size());
+    }
+    faces.resize(offsets.back());
+    pxr::WorkParallelForN(points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::copy(
+                faces_per_point[i].begin(), faces_per_point[i].end(), faces.begin() + offsets[i]);
+        }
+    });
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <embree4/rtcore.h>
+
+#include <memory>
+#include <vector>
+
+#include "GCore/HalfEdgeTopology.h"
+#include "USTC_CG.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/vt/array.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+struct RayHit {
+    // Infinite, with face -1, when the ray misses.
+    float distance;
+    int face;
+    pxr::GfVec3f position;
+    // Unit geometric normal, facing the ray.
+    pxr::GfVec3f normal;
+};
+
+struct ClosestPoint {
+    // Infinite, with face -1, when no face is within the search distance.
+    float distance;
+    int face;
+    pxr::GfVec3f position;
+    // Unit geometric normal of the face, along its winding.
+    pxr::GfVec3f normal;
+};
+
+// An Embree BVH over the faces of a mesh, polygons being fanned into triangles. The queries take
+// batches of points or rays and run them in parallel; faces are reported by their index in the
+// mesh.
+class MeshSpatialQuery {
+   public:
+    // Cached by topology and points. For the same topology with moved points, the BVH of the old
+    // points is refitted in place when nothing else uses it, so an animated collider costs a refit
+    // per frame rather than a build.
+    static std::shared_ptr<const MeshSpatialQuery> get(const HalfEdgeMesh& mesh);
+
+    MeshSpatialQuery(const MeshSpatialQuery&) = delete;
+    MeshSpatialQuery& operator=(const MeshSpatialQuery&) = delete;
+    ~MeshSpatialQuery();
+
+    // Directions need not be normalized. A single direction applies to every origin.
+    std::vector<RayHit> ray_cast(
+        const pxr::VtArray<pxr::GfVec3f>& origins,
+        const pxr::VtArray<pxr::GfVec3f>& directions,
+        float max_distance) const;
+
+    std::vector<ClosestPoint> closest_points(
+        const pxr::VtArray<pxr::GfVec3f>& points,
+        float max_distance) const;
+
+    // The faces within radius of each point, those of points[i] being
+    // faces[offsets[i]] to faces[offsets[i + 1] - 1], in increasing order.
+    void faces_within(
+        const pxr::VtArray<pxr::GfVec3f>& points,
+        float radius,
+        std::vector<int>& offsets,
+        std::vector<int>& faces) const;
+
+    size_t n_faces() const
+    {
+        return face_count_;
+    }
+
+   private:
+    explicit MeshSpatialQuery(const HalfEdgeMesh& mesh);
+    void set_positions(const pxr::VtArray<pxr::GfVec3f>& positions);
+
+    // Not the topology itself: the cache drops the structures of topologies no longer in use.
+    size_t face_count_;
+    size_t vertex_count_;
+    // Held so that its buffer, which identifies it in the cache, is not reused by other points.
+    pxr::VtArray<pxr::GfVec3f> positions_;
+    // The corners of each triangle, and the face it was fanned from.
+    std::vector<int> triangle_vertices_;
+    std::vector<int> triangle_face_;
+
+    RTCScene scene_ = nullptr;
+    RTCGeometry geometry_ = nullptr;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,165 @@
+#include "util_volume.h"
+
+#include <map>
+#include <mutex>
+
+#include <openvdb/tools/Activate.h>
+#include <openvdb/tools/ParticlesToLevelSet.h>
+#include <openvdb/tools/Prune.h>
+#include <openvdb/tools/ValueTransformer.h>
+#include <openvdb/tools/VolumeToMesh.h>
+
+#include "pxr/base/work/loops.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// The particle list ParticlesToLevelSet reads the points through.
+class ParticleList {
+   public:
+    using PosType = openvdb::Vec3R;
+
+    ParticleList(const PointsComponent& points) : vertices_(points.vertices), widths_(points.width)
+    {
+    }
+
+    size_t size() const
+    {
+        return vertices_.size();
+    }
+
+    void getPos(size_t n, openvdb::Vec3R& xyz) const
+    {
+        auto& point = vertices_[n];
+        xyz = { point[0], point[1], point[2] };
+    }
+
+    void getPosRad(size_t n, openvdb::Vec3R& xyz, openvdb::Real& radius) const
+    {
+        getPos(n, xyz);
+        radius = widths_.size() == vertices_.size() ? widths_[n] : 0.1f;
+    }
+
+   private:
+    const pxr::VtArray<pxr::GfVec3f>& vertices_;
+    const pxr::VtArray<float>& widths_;
+};
+
+openvdb::FloatGrid::Ptr rasterize_points(
+    const PointsComponent& points,
+    float voxel_size,
+    float half_width,
+    openvdb::FloatGrid::Ptr previous)
+{
+    const float background = voxel_size * half_width;
+
+    openvdb::FloatGrid::Ptr grid;
+    if (previous && previous->voxelSize()[0] == voxel_size &&
+        previous->background() == background) {
+        grid = previous.use_count() == 1 ? std::move(previous) : previous->deepCopy();
+        // Everything starts outside, in the tree of the last frame. The interior tiles are reset
+        // too, the particles may have left them.
+        openvdb::tools::foreach(
+            grid->beginValueAll(),
+            [background](const openvdb::FloatGrid::ValueAllIter& value) {
+                value.setValue(background);
+            });
+    }
+    else {
+        grid = openvdb::createLevelSet<openvdb::FloatGrid>(voxel_size, half_width);
+    }
+
+    ParticleList particles(points);
+    openvdb::tools::ParticlesToLevelSet<openvdb::FloatGrid> raster(*grid);
+    raster.setGrainSize(1);  // a value of zero disables threading
+    raster.rasterizeSpheres(particles);
+    raster.finalize();
+
+    // The voxels only the last frame reached are still at the background. Turned off, the leaves
+    // they fill are pruned away.
+    openvdb::tools::deactivate(grid->tree(), background);
+    openvdb::tools::pruneLevelSet(grid->tree());
+    return grid;
+}
+
+static std::mutex previous_grids_mutex;
+static std::map<const Node*, openvdb::FloatGrid::Ptr> previous_grids;
+
+openvdb::FloatGrid::Ptr take_previous_grid(const Node* node)
+{
+    std::lock_guard lock(previous_grids_mutex);
+    auto found = previous_grids.find(node);
+    if (found == previous_grids.end()) {
+        return nullptr;
+    }
+    auto grid = std::move(found->second);
+    previous_grids.erase(found);
+    return grid;
+}
+
+void keep_grid(const Node* node, openvdb::FloatGrid::Ptr grid)
+{
+    std::lock_guard lock(previous_grids_mutex);
+    previous_grids[node] = std::move(grid);
+}
+
+void volume_to_mesh(
+    const openvdb::FloatGrid& grid,
+    float isovalue,
+    float adaptivity,
+    MeshComponent& mesh)
+{
+    std::vector<openvdb::Vec3s> points;
+    std::vector<openvdb::Vec3I> triangles;
+    std::vector<openvdb::Vec4I> quads;
+    openvdb::tools::volumeToMesh(grid, points, triangles, quads, isovalue, adaptivity);
+
+    pxr::VtArray<pxr::GfVec3f> vertices(points.size());
+    pxr::VtArray<int> face_vertex_counts(quads.size() + triangles.size());
+    pxr::VtArray<int> face_vertex_indices(4 * quads.size() + 3 * triangles.size());
+
+    auto* vertex_data = vertices.data();
+    auto* count_data = face_vertex_counts.data();
+    auto* index_data = face_vertex_indices.data();
+
+    pxr::WorkParallelForN(points.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            vertex_data[i] = pxr::GfVec3f(points[i][0], points[i][1], points[i][2]);
+        }
+    });
+
+    // Quads first, then triangles.
+    const size_t triangle_offset = 4 * quads.size();
+    pxr::WorkParallelForN(quads.size() + triangles.size(), [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; ++f) {
+            if (f < quads.size()) {
+                count_data[f] = 4;
+                for (int j = 0; j < 4; ++j) {
+                    index_data[4 * f + j] = quads[f][j];
+                }
+            }
+            else {
+                const size_t t = f - quads.size();
+                count_data[f] = 3;
+                for (int j = 0; j < 3; ++j) {
+                    index_data[triangle_offset + 3 * t + j] = triangles[t][j];
+                }
+            }
+        }
+    });
+
+    mesh.vertices = std::move(vertices);
+    mesh.faceVertexCounts = std::move(face_vertex_counts);
+    mesh.faceVertexIndices = std::move(face_vertex_indices);
+}
+
+openvdb::FloatGrid::ConstPtr surface_grid(const GOperandBase& operand)
+{
+    auto volume = operand.get_component<VolumeComponent>();
+    auto grid = volume ? volume->grid<openvdb::FloatGrid>(VolumeComponent::surface) : nullptr;
+    if (!grid) {
+        throw std::runtime_error("Need a volume with a signed distance field.");
+    }
+    return grid;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include "GCore/Components/MeshOperand.h"
+#include "GCore/Components/PointsComponent.h"
+#include "GCore/Components/VolumeComponent.h"
+#include "USTC_CG.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+struct Node;
+
+// Narrow-band signed distance field of the union of spheres around the points, their widths being
+// the radii (0.1 when there are none), half_width voxels wide on either side of the surface.
+//
+// previous, the field of the last frame, is reused when it has the same voxel size and band: its
+// sparse tree is reset and rasterized over in place, and only the leaves the points no longer
+// reach are freed, so an animation does not allocate its topology again every frame. It is
+// written to only if nothing else holds it, and copied otherwise.
+openvdb::FloatGrid::Ptr rasterize_points(
+    const PointsComponent& points,
+    float voxel_size,
+    float half_width,
+    openvdb::FloatGrid::Ptr previous = nullptr);
+
+// The field each node rasterized at its last execution, for the next one to reuse. Taking it
+// leaves nothing for the node until it keeps a new one. A field the node also outputs is only
+// reused in place once no output holds it any more.
+openvdb::FloatGrid::Ptr take_previous_grid(const Node* node);
+void keep_grid(const Node* node, openvdb::FloatGrid::Ptr grid);
+
+// Polygonizes the isosurface of the grid into quads and triangles. An adaptivity above 0 merges
+// voxels where the surface is flat into larger faces, up to 1 for the fewest faces.
+void volume_to_mesh(
+    const openvdb::FloatGrid& grid,
+    float isovalue,
+    float adaptivity,
+    MeshComponent& mesh);
+
+// The signed distance field of the operand, throwing if it has none.
+openvdb::FloatGrid::ConstPtr surface_grid(const GOperandBase& operand);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
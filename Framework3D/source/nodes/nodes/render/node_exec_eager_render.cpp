@@ -7,6 +7,13 @@
 
 USTC_CG_NAMESPACE_OPEN_SCOPE
 class EagerNodeTreeExecutorRender : public EagerNodeTreeExecutor {
+   public:
+    EagerNodeTreeExecutorRender()
+    {
+        // The last used inputs are released to the resource allocator after the execution.
+        take_inputs_by_move = false;
+    }
+
    protected:
     bool execute_node(NodeTree* tree, Node* node) override;
 
@@ -0,0 +1,60 @@
+#include <map>
+
+#include "Nodes/node.hpp"
+#include "Nodes/node_declare.hpp"
+#include "Nodes/node_register.h"
+#include "RCore/Backend.hpp"
+#include "RCore/internal/gl/texture_readback.hpp"
+#include "render_node_base.h"
+
+namespace USTC_CG::node_capture {
+static void node_declare(NodeDeclarationBuilder& b)
+{
+    b.add_input<decl::Texture>("Texture");
+    // The first run of '#' is replaced by the zero-padded frame number. .exr and .hdr keep the
+    // float values.
+    b.add_input<decl::String>("File Path").default_val("capture_####.png");
+}
+
+// The path each Capture node writes to and its next frame number there. A new path starts over.
+struct Sequence {
+    std::string path;
+    int frame = 0;
+};
+
+static std::map<const Node*, Sequence> sequences;
+
+static void node_exec(ExeParams params)
+{
+    auto texture = params.get_input<TextureHandle>("Texture");
+    // The string socket holds a fixed size buffer, so the path ends at the first NUL.
+    auto path = std::string(params.get_input<std::string>("File Path").c_str());
+
+    // The copy is only queued here, the file is written a few frames later.
+    auto& sequence = sequences[&params.node_];
+    if (sequence.path != path) {
+        sequence = { path, 0 };
+    }
+    texture_readback.request_to_file(
+        texture->texture_id,
+        texture->desc.size[0],
+        texture->desc.size[1],
+        frame_file_path(path, sequence.frame++));
+}
+
+static void node_register()
+{
+    static NodeTypeInfo ntype;
+
+    strcpy(ntype.ui_name, "Capture");
+    strcpy_s(ntype.id_name, "render_capture");
+
+    render_node_type_base(&ntype);
+    ntype.node_execute = node_exec;
+    ntype.ALWAYS_REQUIRED = true;
+    ntype.declare = node_declare;
+    nodeRegisterType(&ntype);
+}
+
+NOD_REGISTER_NODE(node_register)
+}  // namespace USTC_CG::node_capture
@@ -1,10 +1,14 @@
 // #define __GNUC__
 
+#include <algorithm>
+#include <cmath>
+
 #include "NODES_FILES_DIR.h"
 #include "Nodes/node.hpp"
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
 #include "Nodes/socket_types/basic_socket_types.hpp"
+#include "RCore/internal/gl/gl_release.hpp"
 #include "camera.h"
 #include "light.h"
 #include "pxr/imaging/glf/simpleLight.h"
@@ -13,6 +17,11 @@
 #include "resource_allocator_instance.hpp"
 #include "rich_type_buffer.hpp"
 #include "utils/draw_fullscreen.h"
+#include "utils/ibl_cache.h"
+#include "utils/light_clusters.h"
+#include "utils/mesh_batch.h"
+#include "utils/shadow_views.h"
+#include "utils/storage_buffer.h"
 
 namespace USTC_CG::node_deferred_lighting {
 
@@ -27,6 +36,10 @@ static void node_declare(NodeDeclarationBuilder& b)
     b.add_input<decl::Texture>("Normal");
     b.add_input<decl::Texture>("Shadow Maps");
 
+    // Local lights are ignored where their luminance falls below this, which bounds how many
+    // light clusters they touch.
+    b.add_input<decl::Float>("Light Cutoff").default_val(0.01f).min(0.0001f).max(1.f);
+
     b.add_input<decl::String>("Lighting Shader").default_val("shaders/blinn_phong.fs");
     b.add_output<decl::Texture>("Color");
 }
@@ -38,8 +51,26 @@ struct LightInfo {
     float radius;
     GfVec3f luminance;
     int shadow_map_id;
+    float range;
+    float padding[3];
+};
+
+// std430 layout of the shadowViewsBuffer.
+struct ShadowViewInfo {
+    GfMatrix4f light_view_projection;
+    int light_id;
+    float split_far;
+    float padding[2];
 };
 
+// Kept across frames, only written when the lights or shadow views change.
+static StorageBuffer light_buffer;
+static StorageBuffer shadow_view_buffer;
+static const bool buffers_registered = register_gl_release([] {
+    light_buffer.release();
+    shadow_view_buffer.release();
+});
+
 static void node_exec(ExeParams params)
 {
     // Fetch all the information
@@ -56,7 +87,7 @@ static void node_exec(ExeParams params)
 
     auto cameras = params.get_input<CameraArray>("Camera");
 
-    Hd_USTC_CG_Camera* free_camera;
+    Hd_USTC_CG_Camera* free_camera = nullptr;
 
     for (auto camera : cameras) {
         if (camera->GetId() != SdfPath::EmptyPath()) {
@@ -65,6 +96,9 @@ static void node_exec(ExeParams params)
         }
     }
 
+    // Precomputed on the first frame with a new dome texture only.
+    auto ibl_maps = ibl_cache.get(find_dome_light(lights));
+
     // Creating output textures.
     auto size = position_texture->desc.size;
     TextureDesc color_output_desc;
@@ -116,14 +150,25 @@ static void node_exec(ExeParams params)
     glActiveTexture(GL_TEXTURE4);
     glBindTexture(GL_TEXTURE_2D, position_texture->texture_id);
 
+    unsigned ibl_unit = 5;
+    ibl_cache.bind(shader->shader, ibl_maps, ibl_unit, 4);
+
     GfVec3f camPos = GfMatrix4f(free_camera->GetTransform()).ExtractTranslation();
     shader->shader.setVec3("camPos", camPos);
 
-    GLuint lightBuffer;
-    glGenBuffers(1, &lightBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+    // Same layer layout as the shadow mapping node.
+    auto shadow_views = compute_shadow_views(
+        lights, free_camera, shadow_maps->desc.size[0], MeshBatch::maxLayers);
+
     glViewport(0, 0, size[0], size[1]);
-    std::vector<LightInfo> light_vector;
+
+    auto cutoff = params.get_input<float>("Light Cutoff");
+
+    // Lights without a position (distant lights) reach every pixel and go first, local lights
+    // follow and are binned into clusters.
+    std::vector<LightInfo> global_lights;
+    std::vector<LightInfo> local_lights;
+    std::vector<LightClusters::LocalLight> local_bounds;
 
     for (int i = 0; i < lights.size(); ++i) {
         if (!lights[i]->GetId().IsEmpty()) {
@@ -133,24 +178,53 @@ static void node_exec(ExeParams params)
             auto position4 = light_params.GetPosition();
             pxr::GfVec3f position3(position4[0], position4[1], position4[2]);
 
-            auto radius = lights[i]->Get(HdLightTokens->radius).Get<float>();
-            
-            light_vector.emplace_back(GfMatrix4f(), GfMatrix4f(), position3, 0.f, diffuse3, i);
-
-            // You can add directional light here, and also the corresponding shadow map calculation
-            // part.
+            auto radius = lights[i]->Get(HdLightTokens->radius).GetWithDefault<float>(0.f);
+
+            // Inverse square falloff drops below the cutoff at this distance.
+            float range = std::sqrt(
+                std::max({ diffuse3[0], diffuse3[1], diffuse3[2], 0.f }) / cutoff);
+
+            // Lights point at their first shadow map layer. For a distant light, the cascades
+            // follow in the next layers (see the shadowViewsBuffer in blinn_phong.fs).
+            auto first_view = std::find_if(
+                shadow_views.begin(), shadow_views.end(), [i](const ShadowView& view) {
+                    return view.light_id == i;
+                });
+            LightInfo info = { GfMatrix4f(1), GfMatrix4f(1), position3, radius, diffuse3, -1,
+                               range };
+            if (first_view != shadow_views.end()) {
+                info.light_projection = first_view->light_projection;
+                info.light_view = first_view->light_view;
+                info.shadow_map_id = int(first_view - shadow_views.begin());
+            }
+
+            if (position4[3] == 0) {
+                global_lights.push_back(info);
+            }
+            else {
+                local_lights.push_back(info);
+                local_bounds.push_back({ position3, range });
+            }
         }
     }
 
-    shader->shader.setInt("light_count", light_vector.size());
+    light_clusters.update(local_bounds, free_camera->_viewMatrix, free_camera->_projMatrix, size);
+    light_clusters.bind(shader->shader);
+
+    std::vector<LightInfo> light_vector = std::move(global_lights);
+    shader->shader.setInt("global_light_count", light_vector.size());
+    light_vector.insert(light_vector.end(), local_lights.begin(), local_lights.end());
 
-    glBufferData(
-        GL_SHADER_STORAGE_BUFFER,
-        light_vector.size() * sizeof(LightInfo),
-        light_vector.data(),
-        GL_STATIC_DRAW);
+    light_buffer.update(light_vector);
+    light_buffer.bind(0);
 
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightBuffer);
+    std::vector<ShadowViewInfo> shadow_view_vector;
+    for (auto& view : shadow_views) {
+        shadow_view_vector.push_back(
+            { view.light_view * view.light_projection, view.light_id, view.split_far });
+    }
+    shadow_view_buffer.update(shadow_view_vector);
+    shadow_view_buffer.bind(1);
 
     glBindVertexArray(VAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -158,7 +232,6 @@ static void node_exec(ExeParams params)
     DestroyFullScreenVAO(VAO, VBO);
 
     resource_allocator.destroy(shader);
-    glDeleteBuffers(1, &lightBuffer);
     glDeleteFramebuffers(1, &framebuffer);
     params.set_output("Color", color_texture);
 
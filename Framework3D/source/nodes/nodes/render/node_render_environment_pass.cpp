@@ -13,6 +13,7 @@
 #include "resource_allocator_instance.hpp"
 #include "rich_type_buffer.hpp"
 #include "utils/draw_fullscreen.h"
+#include "utils/ibl_cache.h"
 
 namespace USTC_CG::node_environment_pass {
 static void node_declare(NodeDeclarationBuilder& b)
@@ -31,29 +32,10 @@ static void node_exec(ExeParams params)
     auto lights = params.get_input<LightArray>("Lights");
     auto color = params.get_input<TextureHandle>("Color");
 
-    Hd_USTC_CG_Dome_Light* dome_light = nullptr;
     Hd_USTC_CG_Camera* free_camera = get_free_camera(params);
 
-    for (int i = 0; i < lights.size(); ++i) {
-        auto light = lights[i];
-        if (light->GetId() != SdfPath::EmptyPath()) {
-            if (HdPrimTypeTokens->domeLight == light->GetLightType()) {
-                dome_light = dynamic_cast<Hd_USTC_CG_Dome_Light*>(light);
-                break;
-            }
-        }
-    }
-
-    // Search for the light with name first. If not found, fall back to anonymous lights.
-    if (!dome_light) {
-        for (int i = 0; i < lights.size(); ++i) {
-            auto light = lights[i];
-            if (HdPrimTypeTokens->domeLight == light->GetLightType()) {
-                dome_light = dynamic_cast<Hd_USTC_CG_Dome_Light*>(light);
-                break;
-            }
-        }
-    }
+    // Computed once per dome texture, not per frame.
+    auto ibl_maps = ibl_cache.get(find_dome_light(lights));
 
     auto depth = params.get_input<TextureHandle>("Depth");
 
@@ -90,10 +72,7 @@ static void node_exec(ExeParams params)
     shader_handle->shader.setVec2("iResolution", size);
 
     unsigned id = 0;
-    if (dome_light) {
-        dome_light->RefreshGLBuffer();
-        dome_light->BindTextures(shader_handle->shader, id);
-    }
+    ibl_cache.bind(shader_handle->shader, ibl_maps, id, 4);
 
     shader_handle->shader.setInt("color", id);
     glActiveTexture(GL_TEXTURE0 + id);
@@ -14,6 +14,8 @@
 #include "render_node_base.h"
 #include "resource_allocator_instance.hpp"
 #include "rich_type_buffer.hpp"
+#include "utils/mesh_batch.h"
+#include "utils/mesh_culling.h"
 
 namespace USTC_CG::node_rasterize_impl {
 static void node_declare(NodeDeclarationBuilder& b)
@@ -109,28 +111,20 @@ static void node_exec(ExeParams params)
     shader_handle->shader.setMat4("view", GfMatrix4f(free_camera->_viewMatrix));
     shader_handle->shader.setMat4("projection", GfMatrix4f(free_camera->_projMatrix));
 
-    for (int i = 0; i < meshes.size(); ++i) {
-        auto mesh = meshes[i];
-
-        shader_handle->shader.setMat4("model", mesh->transform);
-        auto material = materials[mesh->GetMaterialId()];
+    mesh_batch.update(meshes, &materials);
+    mesh_culling.update(mesh_batch);
+    mesh_batch.select(
+        mesh_culling.cull(GfMatrix4f(free_camera->_viewMatrix * free_camera->_projMatrix)));
+    mesh_batch.bind();
+    for (auto&& range : mesh_batch.material_ranges()) {
+        auto material = materials[range.material_id];
 
         material->RefreshGLBuffer();
         material->BindTextures(shader_handle->shader);
 
-        TfToken texcoordName = material->requireTexcoordName();
-
-        mesh->RefreshGLBuffer();
-        mesh->RefreshTexcoordGLBuffer(texcoordName);
-
-        glBindVertexArray(mesh->VAO);
-        glDrawElements(
-            GL_TRIANGLES,
-            static_cast<unsigned int>(mesh->triangulatedIndices.size() * 3),
-            GL_UNSIGNED_INT,
-            0);
-        glBindVertexArray(0);
+        mesh_batch.draw(range);
     }
+    mesh_batch.unbind();
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glDeleteFramebuffers(1, &framebuffer);
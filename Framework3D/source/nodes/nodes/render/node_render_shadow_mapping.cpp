@@ -6,17 +6,18 @@
 #include "camera.h"
 #include "geometries/mesh.h"
 #include "light.h"
-#include "pxr/base/gf/frustum.h"
-#include "pxr/imaging/glf/simpleLight.h"
-#include "pxr/imaging/hd/tokens.h"
 #include "render_node_base.h"
 #include "resource_allocator_instance.hpp"
 #include "rich_type_buffer.hpp"
 #include "utils/draw_fullscreen.h"
+#include "utils/mesh_batch.h"
+#include "utils/mesh_culling.h"
+#include "utils/shadow_views.h"
 
 namespace USTC_CG::node_shadow_mapping {
 static void node_declare(NodeDeclarationBuilder& b)
 {
+    b.add_input<decl::Camera>("Camera");
     b.add_input<decl::Meshes>("Meshes");
     b.add_input<decl::Lights>("Lights");
     b.add_input<decl::Int>("resolution").default_val(1024).min(256).max(4096);
@@ -25,17 +26,34 @@ static void node_declare(NodeDeclarationBuilder& b)
     b.add_output<decl::Texture>("Shadow Maps");
 }
 
+// All shadow maps are layers of one depth-only array, see utils/shadow_views.h for which light
+// owns which layer. Every light is culled separately, and the visible casters of all layers are
+// drawn in one layered multi-draw, the vertex shader routing each draw to its gl_Layer. Without
+// GL_ARB_shader_viewport_layer_array, each layer is attached and drawn on its own.
 static void node_exec(ExeParams params)
 {
     auto meshes = params.get_input<MeshArray>("Meshes");
     auto lights = params.get_input<LightArray>("Lights");
     auto resolution = params.get_input<int>("resolution");
+    auto cameras = params.get_input<CameraArray>("Camera");
+
+    Hd_USTC_CG_Camera* free_camera = nullptr;
+
+    for (auto camera : cameras) {
+        if (camera->GetId() != SdfPath::EmptyPath()) {
+            free_camera = camera;
+            break;
+        }
+    }
+
+    auto views = compute_shadow_views(lights, free_camera, resolution, MeshBatch::maxLayers);
 
     TextureDesc texture_desc;
-    texture_desc.array_size = lights.size();
-    // texture_desc.array_size = 1;
+    texture_desc.array_size = std::max<size_t>(views.size(), 1);
+    texture_desc.layered = true;
+    texture_desc.depth_only = true;
     texture_desc.size = GfVec2i(resolution);
-    texture_desc.format = HdFormatUNorm8Vec4;
+    texture_desc.format = HdFormatFloat32;
     auto shadow_map_texture = resource_allocator.create(texture_desc);
 
     auto shaderPath = params.get_input<std::string>("Shader");
@@ -49,85 +67,68 @@ static void node_exec(ExeParams params)
         std::filesystem::path(RENDER_NODES_FILES_DIR) / std::filesystem::path(shaderPath));
     auto shader_handle = resource_allocator.create(shader_desc);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
-
-    std::vector<TextureHandle> depth_textures;
     GLuint framebuffer;
     glGenFramebuffers(1, &framebuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_texture->texture_id, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
 
     glViewport(0, 0, resolution, resolution);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glClear(GL_DEPTH_BUFFER_BIT);
 
-    for (int light_id = 0; light_id < lights.size(); ++light_id) {
-        shader_handle->shader.use();
-
-        if (!lights[light_id]->GetId().IsEmpty()) {
-            GlfSimpleLight light_params =
-                lights[light_id]->Get(HdTokens->params).Get<GlfSimpleLight>();
-
-            // HW6: The matrices for lights information is here! Current value is set that "it just
-            // works". However, you should try to modify the values to see how it affects the
-            // performance of the shadow maps.
-
-            GfMatrix4f light_view_mat;
-            GfMatrix4f light_projection_mat;
-
-            if (lights[light_id]->GetLightType() == HdPrimTypeTokens->sphereLight) {
-                GfFrustum frustum;
-                GfVec3f light_position = { light_params.GetPosition()[0],
-                                           light_params.GetPosition()[1],
-                                           light_params.GetPosition()[2] };
-
-                light_view_mat =
-                    GfMatrix4f().SetLookAt(light_position, GfVec3f(0, 0, 0), GfVec3f(0, 0, 1));
-                frustum.SetPerspective(120.f, 1.0, 1, 25.f);
-                light_projection_mat = GfMatrix4f(frustum.ComputeProjectionMatrix());
-            }
-            // else (lights[light_id]->GetLightType() == HdPrimTypeTokens->distantLight). See
-            // light.cpp under hd_ustc_cg_gl/
-
-            shader_handle->shader.setMat4("light_view", light_view_mat);
-            shader_handle->shader.setMat4("light_projection", GfMatrix4f(light_projection_mat));
-
-            glFramebufferTextureLayer(
-                GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shadow_map_texture->texture_id, 0, light_id);
-
-            texture_desc.format = HdFormatFloat32UInt8;
-            texture_desc.array_size = 1;
-            auto depth_texture_for_opengl = resource_allocator.create(texture_desc);
-            depth_textures.push_back(depth_texture_for_opengl);
-
-            glFramebufferTexture2D(
-                GL_FRAMEBUFFER,
-                GL_DEPTH_STENCIL_ATTACHMENT,
-                GL_TEXTURE_2D,
-                depth_texture_for_opengl->texture_id,
-                0);
-
-            glClearColor(0.f, 0.f, 0.f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    mesh_batch.update(meshes);
+    mesh_culling.update(mesh_batch);
 
-            for (int mesh_id = 0; mesh_id < meshes.size(); ++mesh_id) {
-                auto mesh = meshes[mesh_id];
+    std::vector<GfMatrix4f> view_projections;
+    std::vector<std::vector<GLuint>> layers;
+    for (auto& view : views) {
+        view_projections.push_back(view.light_view * view.light_projection);
+        // Only casters inside the light frustum are drawn.
+        layers.push_back(mesh_culling.cull(view_projections.back()));
+    }
 
-                shader_handle->shader.setMat4("model", mesh->transform);
+    GLuint view_buffer = 0;
+    if (!views.empty()) {
+        glCreateBuffers(1, &view_buffer);
+        glNamedBufferStorage(
+            view_buffer,
+            view_projections.size() * sizeof(GfMatrix4f),
+            view_projections.data(),
+            0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, view_buffer);
 
-                mesh->RefreshGLBuffer();
+        // Slope-scaled bias against shadow acne.
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.1f, 4.f);
 
-                glBindVertexArray(mesh->VAO);
-                glDrawElements(
-                    GL_TRIANGLES,
-                    static_cast<unsigned int>(mesh->triangulatedIndices.size() * 3),
-                    GL_UNSIGNED_INT,
-                    0);
-                glBindVertexArray(0);
+        shader_handle->shader.use();
+        mesh_batch.bind();
+        if (MeshBatch::supports_layered_draws()) {
+            mesh_batch.select_layered(layers);
+            mesh_batch.draw_all();
+        }
+        else {
+            for (GLuint layer = 0; layer < layers.size(); ++layer) {
+                glFramebufferTextureLayer(
+                    GL_FRAMEBUFFER,
+                    GL_DEPTH_ATTACHMENT,
+                    shadow_map_texture->texture_id,
+                    0,
+                    layer);
+                // Earlier layers stay empty, so the draw tags still carry this layer.
+                std::vector<std::vector<GLuint>> single(layer + 1);
+                single[layer] = layers[layer];
+                mesh_batch.select_layered(single);
+                mesh_batch.draw_all();
             }
         }
-    }
+        mesh_batch.unbind();
 
-    for (auto&& depth_texture : depth_textures) {
-        resource_allocator.destroy(depth_texture);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDeleteBuffers(1, &view_buffer);
     }
 
     resource_allocator.destroy(shader_handle);
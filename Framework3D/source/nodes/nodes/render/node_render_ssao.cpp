@@ -1,74 +1,171 @@
+#include <algorithm>
+
 #include "NODES_FILES_DIR.h"
 #include "Nodes/node.hpp"
 #include "Nodes/node_declare.hpp"
 #include "Nodes/node_register.h"
 #include "Nodes/socket_types/basic_socket_types.hpp"
 #include "camera.h"
-#include "light.h"
 #include "pxr/imaging/hd/tokens.h"
 #include "render_node_base.h"
 #include "resource_allocator_instance.hpp"
 #include "rich_type_buffer.hpp"
-#include "utils/draw_fullscreen.h"
+#include "utils/blue_noise.h"
 
 namespace USTC_CG::node_ssao {
+// Compute passes: the G-buffer is reduced to view-space samples at 1/scale resolution, where the AO
+// is evaluated and blurred, then upsampled bilaterally onto the color. The sample count is fixed
+// per tier, so the cost follows the low resolution and not the kernel at full resolution.
+struct QualityTier {
+    int scale;
+    int sample_count;
+    // In low-resolution pixels.
+    int blur_radius;
+};
+
+// Low, medium, high.
+static constexpr QualityTier quality_tiers[] = { { 4, 8, 2 }, { 2, 12, 3 }, { 2, 16, 4 } };
+
 static void node_declare(NodeDeclarationBuilder& b)
 {
+    b.add_input<decl::Camera>("Camera");
     b.add_input<decl::Texture>("Color");
     b.add_input<decl::Texture>("Position");
-    b.add_input<decl::Texture>("Depth");
+    b.add_input<decl::Texture>("Normal");
 
-    // HW6: For HBAO you might need normal texture.
-
-    b.add_input<decl::String>("Shader").default_val("shaders/ssao.fs");
+    b.add_input<decl::Int>("Quality").default_val(1).min(0).max(2);
+    b.add_input<decl::Float>("Radius").default_val(0.5f).min(0.01f).max(5.f);
+    b.add_input<decl::Float>("Intensity").default_val(1.f).min(0.f).max(4.f);
     b.add_output<decl::Texture>("Color");
 }
 
+static ShaderHandle create_compute_shader(const char* path)
+{
+    ShaderDesc shader_desc;
+    shader_desc.set_compute_path(
+        std::filesystem::path(RENDER_NODES_FILES_DIR) / std::filesystem::path(path));
+    return resource_allocator.create(shader_desc);
+}
+
+static void bind_texture(const Shader& shader, const char* name, int unit, GLuint texture)
+{
+    glBindTextureUnit(unit, texture);
+    shader.setInt(name, unit);
+}
+
+// One invocation per pixel, 8x8 groups.
+static void dispatch(const GfVec2i& size)
+{
+    glDispatchCompute((size[0] + 7) / 8, (size[1] + 7) / 8, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
 static void node_exec(ExeParams params)
 {
+    Hd_USTC_CG_Camera* free_camera = get_free_camera(params);
     auto color = params.get_input<TextureHandle>("Color");
+    auto position = params.get_input<TextureHandle>("Position");
+    auto normal = params.get_input<TextureHandle>("Normal");
 
-    auto size = color->desc.size;
-
-    unsigned int VBO, VAO;
+    auto tier = quality_tiers[std::clamp(params.get_input<int>("Quality"), 0, 2)];
+    auto radius = params.get_input<float>("Radius");
+    auto intensity = params.get_input<float>("Intensity");
 
-    CreateFullScreenVAO(VAO, VBO);
+    auto size = color->desc.size;
+    GfVec2i low_size(
+        (size[0] + tier.scale - 1) / tier.scale, (size[1] + tier.scale - 1) / tier.scale);
 
     TextureDesc texture_desc;
+    texture_desc.size = low_size;
+    texture_desc.format = HdFormatFloat32Vec4;
+    auto view_position = resource_allocator.create(texture_desc);
+    auto view_normal = resource_allocator.create(texture_desc);
+    texture_desc.format = HdFormatFloat32;
+    auto ao = resource_allocator.create(texture_desc);
+    auto ao_blurred = resource_allocator.create(texture_desc);
+
     texture_desc.size = size;
     texture_desc.format = HdFormatFloat32Vec4;
     auto color_texture = resource_allocator.create(texture_desc);
 
-    auto shaderPath = params.get_input<std::string>("Shader");
-
-    ShaderDesc shader_desc;
-    shader_desc.set_vertex_path(
-        std::filesystem::path(RENDER_NODES_FILES_DIR) /
-        std::filesystem::path("shaders/fullscreen.vs"));
-
-    shader_desc.set_fragment_path(
-        std::filesystem::path(RENDER_NODES_FILES_DIR) / std::filesystem::path(shaderPath));
-    auto shader = resource_allocator.create(shader_desc);
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    glFramebufferTexture2D(
-        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture->texture_id, 0);
-
-    glClearColor(0.f, 0.f, 0.f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    shader->shader.use();
-    shader->shader.setVec2("iResolution", size);
-
-    // HW6: Bind the textures like other passes here.
-
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-
-    DestroyFullScreenVAO(VAO, VBO);
-    resource_allocator.destroy(shader);
+    GfMatrix4f view(free_camera->_viewMatrix);
+    GfMatrix4f projection(free_camera->_projMatrix);
+
+    auto prepare_shader = create_compute_shader("shaders/ssao_prepare.comp");
+    auto& prepare = prepare_shader->shader;
+    prepare.use();
+    bind_texture(prepare, "position", 0, position->texture_id);
+    bind_texture(prepare, "normal", 1, normal->texture_id);
+    prepare.setMat4("view", view);
+    prepare.setInt("scale", tier.scale);
+    glBindImageTexture(0, view_position->texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glBindImageTexture(1, view_normal->texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    dispatch(low_size);
+
+    auto ao_shader = create_compute_shader("shaders/ssao.comp");
+    auto& occlusion = ao_shader->shader;
+    occlusion.use();
+    bind_texture(occlusion, "view_position", 0, view_position->texture_id);
+    bind_texture(occlusion, "view_normal", 1, view_normal->texture_id);
+    bind_texture(occlusion, "blue_noise", 2, blue_noise.texture());
+    occlusion.setMat4("projection", projection);
+    occlusion.setInt("sample_count", tier.sample_count);
+    occlusion.setFloat("radius", radius);
+    glBindImageTexture(0, ao->texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    dispatch(low_size);
+
+    // Horizontally into ao_blurred, then vertically back into ao.
+    auto blur_shader = create_compute_shader("shaders/ssao_blur.comp");
+    auto& blur = blur_shader->shader;
+    blur.use();
+    bind_texture(blur, "view_position", 1, view_position->texture_id);
+    bind_texture(blur, "view_normal", 2, view_normal->texture_id);
+    blur.setInt("blur_radius", tier.blur_radius);
+    for (bool horizontal : { true, false }) {
+        auto& source = horizontal ? ao : ao_blurred;
+        auto& target = horizontal ? ao_blurred : ao;
+        bind_texture(blur, "ao_input", 0, source->texture_id);
+        blur.setInt("horizontal", horizontal);
+        glBindImageTexture(0, target->texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        dispatch(low_size);
+    }
+
+    auto upsample_shader = create_compute_shader("shaders/ssao_upsample.comp");
+    auto& upsample = upsample_shader->shader;
+    upsample.use();
+    bind_texture(upsample, "color", 0, color->texture_id);
+    bind_texture(upsample, "position", 1, position->texture_id);
+    bind_texture(upsample, "normal", 2, normal->texture_id);
+    bind_texture(upsample, "ao", 3, ao->texture_id);
+    bind_texture(upsample, "view_position", 4, view_position->texture_id);
+    bind_texture(upsample, "view_normal", 5, view_normal->texture_id);
+    upsample.setMat4("view", view);
+    upsample.setInt("scale", tier.scale);
+    upsample.setFloat("intensity", intensity);
+    glBindImageTexture(0, color_texture->texture_id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    dispatch(size);
+
+    std::string shader_error;
+    for (auto* shader_handle : { &prepare_shader, &ao_shader, &blur_shader, &upsample_shader }) {
+        if (shader_error.empty()) {
+            shader_error = (*shader_handle)->shader.get_error();
+        }
+    }
+
+    resource_allocator.destroy(prepare_shader);
+    resource_allocator.destroy(ao_shader);
+    resource_allocator.destroy(blur_shader);
+    resource_allocator.destroy(upsample_shader);
+    resource_allocator.destroy(view_position);
+    resource_allocator.destroy(view_normal);
+    resource_allocator.destroy(ao);
+    resource_allocator.destroy(ao_blurred);
 
     params.set_output("Color", color_texture);
+
+    if (!shader_error.empty()) {
+        throw std::runtime_error(shader_error);
+    }
 }
 
 static void node_register()
@@ -2,21 +2,61 @@
 
 // Define a uniform struct for lights
 struct Light {
-    // The matrices are used for shadow mapping. You need to fill it according to how we are filling it when building the normal maps (node_render_shadow_mapping.cpp). 
-    // Now, they are filled with identity matrix. You need to modify C++ code innode_render_deferred_lighting.cpp.
+    // The matrices are used for shadow mapping. They are the ones of the light's first shadow map layer (see utils/shadow_views.cpp).
     // Position and color are filled.
     mat4 light_projection;
     mat4 light_view;
     vec3 position;
     float radius;
     vec3 color; // Just use the same diffuse and specular color.
-    int shadow_map_id;
+    int shadow_map_id; // First layer in shadow_maps, -1 without shadows.
+    float range; // Local lights contribute less than the node's "Light Cutoff" beyond this distance.
 };
 
+// Global (distant) lights come first, then the local lights.
 layout(binding = 0) buffer lightsBuffer {
-Light lights[4];
+Light lights[];
 };
 
+// One entry per shadow_maps layer. A distant light owns several consecutive layers (cascades):
+// use the first one whose split_far is beyond the view depth of the shaded point.
+struct ShadowView {
+    mat4 light_view_projection;
+    int light_id;
+    float split_far; // 0 for lights without cascades.
+};
+
+layout(binding = 1) buffer shadowViewsBuffer {
+ShadowView shadow_views[];
+};
+
+// Local lights binned per view-space cluster, see utils/light_clusters.h. The indices count from the
+// first local light.
+layout(binding = 2) buffer clusterRangesBuffer {
+uvec2 cluster_ranges[]; // (offset, count) into cluster_light_indices
+};
+
+layout(binding = 3) buffer clusterIndicesBuffer {
+uint cluster_light_indices[];
+};
+
+// Image-based lighting of the dome light, see utils/ibl_cache.h. Each is a single lookup.
+uniform int has_environment;
+uniform samplerCube specular_environment; // GGX-prefiltered, one mip per roughness step
+uniform float specular_max_lod;
+uniform sampler2D brdf_lut; // Split-sum (scale, bias) of F0, by (n.v, roughness)
+layout(binding = 4) buffer irradianceBuffer {
+vec4 irradiance_sh[9];
+};
+
+uniform mat4 view;
+uniform int cluster_tile_size;
+uniform int cluster_count_x;
+uniform int cluster_count_y;
+uniform int cluster_slice_count;
+uniform float cluster_near;
+uniform float cluster_far;
+
 uniform vec2 iResolution;
 
 uniform sampler2D diffuseColorSampler;
@@ -28,7 +68,40 @@ uniform sampler2D position;
 // uniform float alpha;
 uniform vec3 camPos;
 
-uniform int light_count;
+uniform int global_light_count;
+
+uvec2 find_cluster(vec3 world_position)
+{
+    float depth = -(view * vec4(world_position, 1.0)).z;
+    int slice = int(log(max(depth, cluster_near) / cluster_near) / log(cluster_far / cluster_near) * cluster_slice_count);
+    slice = clamp(slice, 0, cluster_slice_count - 1);
+    ivec2 tile = ivec2(gl_FragCoord.xy) / cluster_tile_size;
+    return cluster_ranges[tile.x + cluster_count_x * (tile.y + cluster_count_y * slice)];
+}
+
+vec3 irradiance(vec3 n)
+{
+    return max(
+        irradiance_sh[0].rgb * 0.282095 +
+        (irradiance_sh[1].rgb * n.y + irradiance_sh[2].rgb * n.z + irradiance_sh[3].rgb * n.x) * 0.488603 +
+        (irradiance_sh[4].rgb * n.x * n.y + irradiance_sh[5].rgb * n.y * n.z + irradiance_sh[7].rgb * n.x * n.z) * 1.092548 +
+        irradiance_sh[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0) +
+        irradiance_sh[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y),
+        vec3(0.0));
+}
+
+vec3 environment_lighting(vec3 pos, vec3 normal, vec3 albedo, float metal, float roughness)
+{
+    vec3 n = normalize(normal);
+    vec3 v = normalize(camPos - pos);
+    float n_dot_v = max(dot(n, v), 1e-4);
+    vec3 f0 = mix(vec3(0.04), albedo, metal);
+
+    vec3 diffuse = (1.0 - metal) * albedo * irradiance(n) / 3.14159265359;
+    vec3 prefiltered = textureLod(specular_environment, reflect(-v, n), roughness * specular_max_lod).rgb;
+    vec2 brdf = texture(brdf_lut, vec2(n_dot_v, roughness)).xy;
+    return diffuse + prefiltered * (f0 * brdf.x + brdf.y);
+}
 
 layout(location = 0) out vec4 Color;
 
@@ -42,9 +115,18 @@ vec4 metalnessRoughness = texture2D(metallicRoughnessSampler,uv);
 float metal = metalnessRoughness.x;
 float roughness = metalnessRoughness.y;
 
-for(int i = 0; i < light_count; i ++) {
+// Only the lights of this pixel's cluster are visited, whatever the number of lights in the scene.
+uvec2 cluster = find_cluster(pos);
+int light_count = global_light_count + int(cluster.y);
+
+for(int k = 0; k < light_count; k ++) {
+int i = k < global_light_count ? k : global_light_count + int(cluster_light_indices[cluster.x + uint(k - global_light_count)]);
 
-float shadow_map_value = texture(shadow_maps, vec3(uv, lights[i].shadow_map_id)).x;
+// Shadow maps hold window-space depth in [0, 1]. Lights without a shadow map read the far plane.
+float shadow_map_value = 1.0;
+if (lights[i].shadow_map_id >= 0) {
+shadow_map_value = texture(shadow_maps, vec3(uv, lights[i].shadow_map_id)).x;
+}
 
 // Visualization of shadow map
 Color += vec4(shadow_map_value, 0, 0, 1);
@@ -52,10 +134,15 @@ Color += vec4(shadow_map_value, 0, 0, 1);
 // HW6_TODO: first comment the line above ("Color +=..."). That's for quick Visualization.
 // You should first do the Blinn Phong shading here. You can use roughness to modify alpha. Or you can pass in an alpha value through the uniform above.
 
-// After finishing Blinn Phong shading, you can do shadow mapping with the help of the provided shadow_map_value. You will need to refer to the node, node_render_shadow_mapping.cpp, for the light matrices definition. Then you need to fill the mat4 light_projection; mat4 light_view; with similar approach that we fill position and color.
+// After finishing Blinn Phong shading, you can do shadow mapping with the help of the provided shadow_map_value. You will need to refer to the node, node_render_shadow_mapping.cpp, for the light matrices definition. light_projection and light_view are already filled (the matrices of the first layer; for a distant light pick the cascade layer from shadow_views).
 // For shadow mapping, as is discussed in the course, you should compare the value "position depth from the light's view" against the "blocking object's depth.", then you can decide whether it's shadowed.
 
 // PCSS is also applied here.
 }
 
+if (has_environment != 0) {
+vec3 albedo = texture2D(diffuseColorSampler, uv).xyz;
+Color.rgb += environment_lighting(pos, normal, albedo, metal, roughness);
+}
+
 }
\ No newline at end of file
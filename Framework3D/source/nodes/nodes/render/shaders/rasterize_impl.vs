@@ -1,20 +1,27 @@
 #version 430 core
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
+layout(location = 3) in uint aDrawId;
 layout(std430, binding = 0) buffer buffer0 {
 vec2 data[];
 }
 aTexcoord;
 
+// One model matrix per draw of the batched multi-draw, see utils/mesh_batch.h
+layout(std430, binding = 1) buffer buffer1 {
+mat4 model[];
+}
+aDraw;
+
 out vec3 vertexPosition;
 out vec3 vertexNormal;
 out vec2 vTexcoord;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main() {
+mat4 model = aDraw.model[aDrawId & 0xFFFFFFu];
 gl_Position = projection * view * model * vec4(aPos, 1.0);
 vec4 vPosition = model * vec4(aPos, 1.0);
 vertexPosition = vPosition.xyz / vPosition.w;
@@ -1,11 +1,6 @@
 #version 430 core
 
-uniform mat4 light_view;
-uniform mat4 light_projection;
-in vec3 vertexPosition;
-layout(location = 0) out float shadow_map0;
-
+// The shadow maps are depth-only: each texel holds the window-space depth [0, 1] of the closest
+// caster, as seen through the light_projection * light_view of its layer.
 void main() {
-    vec4 clipPos = light_projection * light_view * (vec4(vertexPosition, 1.0));
-    shadow_map0 = (clipPos.z / clipPos.w);
-}
\ No newline at end of file
+}
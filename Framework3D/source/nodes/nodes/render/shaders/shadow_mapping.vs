@@ -1,13 +1,26 @@
 #version 430 core
+#extension GL_ARB_shader_viewport_layer_array : enable
 layout(location = 0) in vec3 aPos;
+layout(location = 3) in uint aDrawTag;
 
-uniform mat4 light_view;
-uniform mat4 light_projection;
-uniform mat4 model;
-out vec3 vertexPosition;
+// One model matrix per draw of the batched multi-draw, see utils/mesh_batch.h
+layout(std430, binding = 1) buffer buffer1 {
+mat4 model[];
+}
+aDraw;
+
+// light_projection * light_view of every shadow map layer, see utils/shadow_views.h
+layout(std430, binding = 2) buffer buffer2 {
+mat4 view_projection[];
+}
+aLayer;
 
 void main() {
-    gl_Position = light_projection * light_view * model * vec4(aPos, 1.0);
-    vec4 vPosition = model * vec4(aPos, 1.0);
-    vertexPosition = vPosition.xyz / vPosition.w;
-}
\ No newline at end of file
+    uint draw = aDrawTag & 0xFFFFFFu;
+    uint layer = aDrawTag >> 24;
+    // Without the extension, the pass attaches one layer at a time.
+#ifdef GL_ARB_shader_viewport_layer_array
+    gl_Layer = int(layer);
+#endif
+    gl_Position = aLayer.view_projection[layer] * aDraw.model[draw] * vec4(aPos, 1.0);
+}
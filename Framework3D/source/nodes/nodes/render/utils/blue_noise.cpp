@@ -0,0 +1,173 @@
+#include "blue_noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "RCore/internal/gl/gl_release.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+BlueNoise blue_noise;
+static const bool blue_noise_registered = register_gl_release([] { blue_noise.release(); });
+
+namespace {
+constexpr int n = BlueNoise::size;
+constexpr int pixel_count = n * n;
+
+// Sum of Gaussians centered on the pixels of a binary pattern, on a torus so that the map tiles.
+class EnergyField {
+   public:
+    EnergyField() : energy_(pixel_count, 0.f), kernel_(pixel_count)
+    {
+        constexpr float sigma = 1.5f;
+        for (int y = 0; y < n; ++y) {
+            for (int x = 0; x < n; ++x) {
+                float dx = float(std::min(x, n - x));
+                float dy = float(std::min(y, n - y));
+                kernel_[y * n + x] = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+        }
+    }
+
+    void add(int pixel, float sign)
+    {
+        const int px = pixel % n, py = pixel / n;
+        for (int y = 0; y < n; ++y) {
+            const float* row = &kernel_[((y - py + n) % n) * n];
+            for (int x = 0; x < n; ++x) {
+                energy_[y * n + x] += sign * row[(x - px + n) % n];
+            }
+        }
+    }
+
+    // The pixel of the given value with the highest energy.
+    int tightest(const std::vector<char>& pattern, char value) const
+    {
+        int best = -1;
+        for (int i = 0; i < pixel_count; ++i) {
+            if (pattern[i] == value && (best < 0 || energy_[i] > energy_[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // The pixel of the given value with the lowest energy.
+    int emptiest(const std::vector<char>& pattern, char value) const
+    {
+        int best = -1;
+        for (int i = 0; i < pixel_count; ++i) {
+            if (pattern[i] == value && (best < 0 || energy_[i] < energy_[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+   private:
+    std::vector<float> energy_;
+    std::vector<float> kernel_;
+};
+
+// Ulichney's void-and-cluster: every pixel gets the rank at which it joins an evenly spread
+// pattern.
+std::vector<float> void_and_cluster()
+{
+    std::mt19937 rng(0x5eed);
+    std::uniform_int_distribution<int> random_pixel(0, pixel_count - 1);
+
+    const int initial_count = pixel_count / 10;
+    std::vector<char> prototype(pixel_count, 0);
+    EnergyField prototype_energy;
+    for (int placed = 0; placed < initial_count;) {
+        int pixel = random_pixel(rng);
+        if (!prototype[pixel]) {
+            prototype[pixel] = 1;
+            prototype_energy.add(pixel, 1);
+            ++placed;
+        }
+    }
+
+    // Spread the initial points: move the tightest cluster into the largest void until it is the
+    // largest void itself.
+    while (true) {
+        int cluster = prototype_energy.tightest(prototype, 1);
+        prototype[cluster] = 0;
+        prototype_energy.add(cluster, -1);
+        int void_pixel = prototype_energy.emptiest(prototype, 0);
+        prototype[void_pixel] = 1;
+        prototype_energy.add(void_pixel, 1);
+        if (void_pixel == cluster) {
+            break;
+        }
+    }
+
+    std::vector<int> ranks(pixel_count);
+
+    // Ranks below the initial count: take the points away, tightest clusters first.
+    auto pattern = prototype;
+    auto energy = prototype_energy;
+    for (int ones = initial_count; ones > 0;) {
+        int cluster = energy.tightest(pattern, 1);
+        pattern[cluster] = 0;
+        energy.add(cluster, -1);
+        ranks[cluster] = --ones;
+    }
+
+    // Up to half: fill the largest voids.
+    pattern = prototype;
+    energy = prototype_energy;
+    int ones = initial_count;
+    for (; ones < pixel_count / 2; ++ones) {
+        int void_pixel = energy.emptiest(pattern, 0);
+        pattern[void_pixel] = 1;
+        energy.add(void_pixel, 1);
+        ranks[void_pixel] = ones;
+    }
+
+    // Beyond half the empty pixels are the minority: fill the tightest clusters of empty pixels.
+    EnergyField empty_energy;
+    for (int i = 0; i < pixel_count; ++i) {
+        if (!pattern[i]) {
+            empty_energy.add(i, 1);
+        }
+    }
+    for (; ones < pixel_count; ++ones) {
+        int cluster = empty_energy.tightest(pattern, 0);
+        pattern[cluster] = 1;
+        empty_energy.add(cluster, -1);
+        ranks[cluster] = ones;
+    }
+
+    std::vector<float> thresholds(pixel_count);
+    for (int i = 0; i < pixel_count; ++i) {
+        thresholds[i] = (ranks[i] + 0.5f) / pixel_count;
+    }
+    return thresholds;
+}
+}  // namespace
+
+void BlueNoise::release()
+{
+    glDeleteTextures(1, &texture_);
+    texture_ = 0;
+}
+
+GLuint BlueNoise::texture()
+{
+    if (!texture_) {
+        auto thresholds = void_and_cluster();
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture_);
+        glTextureStorage2D(texture_, 1, GL_R32F, n, n);
+        glTextureSubImage2D(texture_, 0, 0, 0, n, n, GL_RED, GL_FLOAT, thresholds.data());
+        glTextureParameteri(texture_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(texture_, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(texture_, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+    return texture_;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
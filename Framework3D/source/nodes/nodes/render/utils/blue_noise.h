@@ -0,0 +1,30 @@
+#pragma once
+
+#include "USTC_CG.h"
+#include "pxr/imaging/garch/glApi.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// A tileable size x size blue-noise threshold map (R32F, values in [0, 1)), generated once with
+// the void-and-cluster method. Screen-space effects tile it over the pixels to decorrelate their
+// per-pixel random rotations without the low-frequency blotches of white noise.
+class BlueNoise {
+   public:
+    static constexpr int size = 64;
+
+    BlueNoise() = default;
+    BlueNoise(const BlueNoise&) = delete;
+    BlueNoise& operator=(const BlueNoise&) = delete;
+
+    // Created on first use, the GL context must be current.
+    GLuint texture();
+    // Frees the texture, registered with register_gl_release. It is created again on next use.
+    void release();
+
+   private:
+    GLuint texture_ = 0;
+};
+
+extern BlueNoise blue_noise;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,220 @@
+#include "ibl_cache.h"
+
+#include <algorithm>
+
+#include "../NODES_FILES_DIR.h"
+#include "../resource_allocator_instance.hpp"
+#include "RCore/internal/gl/gl_release.hpp"
+#include "light.h"
+#include "pxr/imaging/hd/tokens.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+IBLCache ibl_cache;
+static const bool ibl_cache_registered = register_gl_release([] { ibl_cache.release(); });
+
+Hd_USTC_CG_Dome_Light* find_dome_light(const LightArray& lights)
+{
+    Hd_USTC_CG_Dome_Light* anonymous = nullptr;
+    for (auto light : lights) {
+        if (HdPrimTypeTokens->domeLight != light->GetLightType()) {
+            continue;
+        }
+        if (!light->GetId().IsEmpty()) {
+            return dynamic_cast<Hd_USTC_CG_Dome_Light*>(light);
+        }
+        if (!anonymous) {
+            anonymous = dynamic_cast<Hd_USTC_CG_Dome_Light*>(light);
+        }
+    }
+    return anonymous;
+}
+
+static ShaderHandle create_compute_shader(const char* path)
+{
+    ShaderDesc shader_desc;
+    shader_desc.set_compute_path(
+        std::filesystem::path(RENDER_NODES_FILES_DIR) / std::filesystem::path(path));
+    return resource_allocator.create(shader_desc);
+}
+
+// One invocation per texel, 8x8 groups, `layers` deep.
+static void dispatch(int width, int height, int layers)
+{
+    glDispatchCompute((width + 7) / 8, (height + 7) / 8, layers);
+    glMemoryBarrier(
+        GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+static GLuint create_cubemap(int size, int levels)
+{
+    GLuint texture;
+    glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &texture);
+    glTextureStorage2D(texture, levels, GL_RGBA16F, size, size);
+    glTextureParameteri(
+        texture, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+static int mip_count(int size)
+{
+    int levels = 1;
+    while (size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
+void IBLCache::release()
+{
+    for (auto& entry : entries_) {
+        release_maps(entry.maps);
+    }
+    entries_.clear();
+    glDeleteTextures(1, &brdf_lut_);
+    brdf_lut_ = 0;
+}
+
+void IBLCache::release_maps(IBLMaps& maps)
+{
+    glDeleteTextures(1, &maps.environment);
+    glDeleteTextures(1, &maps.specular);
+    glDeleteBuffers(1, &maps.irradiance_sh);
+    maps = {};
+}
+
+const IBLMaps* IBLCache::get(Hd_USTC_CG_Dome_Light* dome_light)
+{
+    if (!dome_light) {
+        return nullptr;
+    }
+    dome_light->RefreshGLBuffer();
+    const size_t version = dome_light->GetTextureVersion();
+
+    ++use_counter_;
+    for (auto& entry : entries_) {
+        if (entry.version == version) {
+            entry.last_used = use_counter_;
+            return &entry.maps;
+        }
+    }
+
+    IBLMaps maps;
+    if (!precompute(dome_light->GetTexture(), maps)) {
+        return nullptr;
+    }
+
+    if (entries_.size() == maxEntries) {
+        auto oldest = std::min_element(
+            entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+                return a.last_used < b.last_used;
+            });
+        release_maps(oldest->maps);
+        entries_.erase(oldest);
+    }
+    entries_.push_back({ version, maps, use_counter_ });
+    return &entries_.back().maps;
+}
+
+bool IBLCache::precompute(GLuint dome_texture, IBLMaps& maps)
+{
+    auto environment_shader = create_compute_shader("shaders/ibl_environment.comp");
+    auto prefilter_shader = create_compute_shader("shaders/ibl_prefilter.comp");
+    auto irradiance_shader = create_compute_shader("shaders/ibl_irradiance.comp");
+
+    // A dispatch with a program still linking would run its placeholder, and the empty result
+    // would stay in the cache.
+    bool ready = environment_shader->shader.ready() && prefilter_shader->shader.ready() &&
+                 irradiance_shader->shader.ready();
+    if (ready) {
+        const int environment_levels = mip_count(environmentSize);
+        maps.environment = create_cubemap(environmentSize, environment_levels);
+        maps.specular = create_cubemap(specularSize, specularLevels);
+        glCreateBuffers(1, &maps.irradiance_sh);
+        glNamedBufferStorage(maps.irradiance_sh, 9 * 4 * sizeof(float), nullptr, 0);
+
+        // Resample the dome texture, then filter the mips that the prefiltering samples.
+        auto& environment = environment_shader->shader;
+        environment.use();
+        glBindTextureUnit(0, dome_texture);
+        environment.setInt("env_texture", 0);
+        glBindImageTexture(0, maps.environment, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        dispatch(environmentSize, environmentSize, 6);
+        glGenerateTextureMipmap(maps.environment);
+
+        auto& prefilter = prefilter_shader->shader;
+        prefilter.use();
+        glBindTextureUnit(0, maps.environment);
+        prefilter.setInt("environment", 0);
+        prefilter.setFloat("environment_size", environmentSize);
+        for (int level = 0; level < specularLevels; ++level) {
+            int size = std::max(specularSize >> level, 1);
+            prefilter.setFloat("roughness", float(level) / (specularLevels - 1));
+            glBindImageTexture(0, maps.specular, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            dispatch(size, size, 6);
+        }
+
+        // A single work group integrates a small mip of the environment.
+        auto& irradiance = irradiance_shader->shader;
+        irradiance.use();
+        glBindTextureUnit(0, maps.environment);
+        irradiance.setInt("environment", 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, maps.irradiance_sh);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    resource_allocator.destroy(environment_shader);
+    resource_allocator.destroy(prefilter_shader);
+    resource_allocator.destroy(irradiance_shader);
+    return ready;
+}
+
+bool IBLCache::compute_brdf_lut()
+{
+    auto brdf_shader = create_compute_shader("shaders/ibl_brdf_lut.comp");
+    bool ready = brdf_shader->shader.ready();
+    if (ready) {
+        glCreateTextures(GL_TEXTURE_2D, 1, &brdf_lut_);
+        glTextureStorage2D(brdf_lut_, 1, GL_RG16F, brdfLutSize, brdfLutSize);
+        glTextureParameteri(brdf_lut_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(brdf_lut_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(brdf_lut_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(brdf_lut_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        brdf_shader->shader.use();
+        glBindImageTexture(0, brdf_lut_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+        dispatch(brdfLutSize, brdfLutSize, 1);
+    }
+    resource_allocator.destroy(brdf_shader);
+    return ready;
+}
+
+void IBLCache::bind(const Shader& shader, const IBLMaps* maps, unsigned& unit, GLuint sh_binding)
+{
+    if (maps && !brdf_lut_ && !compute_brdf_lut()) {
+        maps = nullptr;
+    }
+    shader.use();
+    shader.setInt("has_environment", maps != nullptr);
+    if (!maps) {
+        return;
+    }
+
+    glBindTextureUnit(unit, maps->environment);
+    shader.setInt("environment", unit++);
+    glBindTextureUnit(unit, maps->specular);
+    shader.setInt("specular_environment", unit++);
+    glBindTextureUnit(unit, brdf_lut_);
+    shader.setInt("brdf_lut", unit++);
+    shader.setFloat("specular_max_lod", specularLevels - 1);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, sh_binding, maps->irradiance_sh);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/imaging/garch/glApi.h"
+#include "rich_type_buffer.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+class Shader;
+class Hd_USTC_CG_Dome_Light;
+
+// Image-based lighting data derived from one dome light texture.
+struct IBLMaps {
+    // The dome texture resampled into a cubemap, with mips.
+    GLuint environment = 0;
+    // GGX-prefiltered radiance: level l is filtered for roughness l / (specularLevels - 1).
+    GLuint specular = 0;
+    // Storage buffer of 9 vec4: SH9 coefficients of the irradiance (cosine-convolved radiance).
+    GLuint irradiance_sh = 0;
+};
+
+// Precomputes IBLMaps with compute shaders when a dome light texture is first seen, and keeps the
+// maps of the last few textures so that switching between environments does not recompute them.
+// The split-sum BRDF lookup table does not depend on the environment and is computed once.
+class IBLCache {
+   public:
+    static constexpr int environmentSize = 512;
+    static constexpr int specularSize = 128;
+    static constexpr int specularLevels = 6;
+    static constexpr int brdfLutSize = 256;
+    static constexpr size_t maxEntries = 4;
+
+    IBLCache() = default;
+    IBLCache(const IBLCache&) = delete;
+    IBLCache& operator=(const IBLCache&) = delete;
+
+    // nullptr while the precompute shaders are still being linked, try again next frame.
+    const IBLMaps* get(Hd_USTC_CG_Dome_Light* dome_light);
+
+    // Binds the maps to the samplerCube "environment" and "specular_environment" and the
+    // sampler2D "brdf_lut", from texture unit `unit` on, and the SH coefficients to the given
+    // storage buffer binding. Sets "has_environment" and "specular_max_lod". Without maps, only
+    // has_environment is set, to 0.
+    void bind(const Shader& shader, const IBLMaps* maps, unsigned& unit, GLuint sh_binding);
+
+    // Frees every map and the lookup table, registered with register_gl_release. The destructor
+    // does not touch GL.
+    void release();
+
+   private:
+    struct Entry {
+        size_t version;
+        IBLMaps maps;
+        size_t last_used;
+    };
+
+    bool precompute(GLuint dome_texture, IBLMaps& maps);
+    bool compute_brdf_lut();
+    static void release_maps(IBLMaps& maps);
+
+    std::vector<Entry> entries_;
+    size_t use_counter_ = 0;
+    GLuint brdf_lut_ = 0;
+};
+
+extern IBLCache ibl_cache;
+
+// The dome light of the scene: the first one with a scene path, else the first anonymous one.
+Hd_USTC_CG_Dome_Light* find_dome_light(const LightArray& lights);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,196 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "RCore/internal/gl/GLResources.hpp"
+#include "RCore/internal/gl/gl_release.hpp"
+#include "pxr/base/gf/range2d.h"
+#include "pxr/base/gf/vec4d.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+LightClusters light_clusters;
+static const bool light_clusters_registered =
+    register_gl_release([] { light_clusters.release(); });
+
+// Point of the view frustum at NDC (x, y) and the given view depth, in view space. Depth is linear
+// between the near and far plane points, for perspective and orthographic projections alike.
+static GfVec3d frustum_point(
+    const GfMatrix4d& inverse_projection,
+    double x,
+    double y,
+    double depth,
+    double near_depth,
+    double far_depth)
+{
+    GfVec3d near_point = inverse_projection.Transform(GfVec3d(x, y, -1));
+    GfVec3d far_point = inverse_projection.Transform(GfVec3d(x, y, 1));
+    double t = (depth - near_depth) / (far_depth - near_depth);
+    return near_point + (far_point - near_point) * t;
+}
+
+static bool sphere_intersects(const GfRange3f& box, const GfVec3f& center, float radius)
+{
+    float distance2 = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        float v = std::clamp(center[axis], box.GetMin()[axis], box.GetMax()[axis]) - center[axis];
+        distance2 += v * v;
+    }
+    return distance2 <= radius * radius;
+}
+
+int LightClusters::slice_of(float depth) const
+{
+    if (depth <= near_) {
+        return 0;
+    }
+    int slice = int(std::log(depth / near_) / std::log(far_ / near_) * sliceCount);
+    return std::clamp(slice, 0, sliceCount - 1);
+}
+
+void LightClusters::build_cluster_bounds()
+{
+    GfMatrix4d inverse_projection = projection_.GetInverse();
+    near_ = std::max(float(-inverse_projection.Transform(GfVec3d(0, 0, -1))[2]), 1e-3f);
+    far_ = std::max(float(-inverse_projection.Transform(GfVec3d(0, 0, 1))[2]), near_ * 2);
+
+    count_x_ = (size_[0] + tileSize - 1) / tileSize;
+    count_y_ = (size_[1] + tileSize - 1) / tileSize;
+    cluster_bounds_.resize(size_t(count_x_) * count_y_ * sliceCount);
+
+    for (int z = 0; z < sliceCount; ++z) {
+        double depths[2] = { near_ * std::pow(double(far_) / near_, double(z) / sliceCount),
+                             near_ * std::pow(double(far_) / near_, double(z + 1) / sliceCount) };
+        for (int y = 0; y < count_y_; ++y) {
+            double ys[2] = { 2.0 * y * tileSize / size_[1] - 1,
+                             std::min(2.0 * (y + 1) * tileSize / size_[1] - 1, 1.0) };
+            for (int x = 0; x < count_x_; ++x) {
+                double xs[2] = { 2.0 * x * tileSize / size_[0] - 1,
+                                 std::min(2.0 * (x + 1) * tileSize / size_[0] - 1, 1.0) };
+                GfRange3f bounds;
+                for (int corner = 0; corner < 8; ++corner) {
+                    bounds.UnionWith(GfVec3f(frustum_point(
+                        inverse_projection,
+                        xs[corner & 1],
+                        ys[(corner >> 1) & 1],
+                        depths[corner >> 2],
+                        near_,
+                        far_)));
+                }
+                cluster_bounds_[x + count_x_ * (y + count_y_ * z)] = bounds;
+            }
+        }
+    }
+}
+
+void LightClusters::update(
+    const std::vector<LocalLight>& lights,
+    const GfMatrix4d& view,
+    const GfMatrix4d& projection,
+    const GfVec2i& size)
+{
+    view_ = view;
+    if (projection != projection_ || size != size_ || cluster_bounds_.empty()) {
+        projection_ = projection;
+        size_ = size;
+        build_cluster_bounds();
+    }
+
+    // (cluster, light) pairs, in increasing light order.
+    std::vector<std::pair<GLuint, GLuint>> hits;
+    for (GLuint light_id = 0; light_id < lights.size(); ++light_id) {
+        const auto& light = lights[light_id];
+        GfVec3f center(view.Transform(GfVec3d(light.position)));
+        float radius = light.range;
+        float depth = -center[2];
+        if (depth + radius < near_ || depth - radius > far_) {
+            continue;
+        }
+
+        int x0 = 0, x1 = count_x_ - 1;
+        int y0 = 0, y1 = count_y_ - 1;
+        // A sphere in front of the near plane only covers the screen rectangle of its projected
+        // bounding box. Spheres crossing the near plane may cover any tile.
+        if (depth - radius > near_) {
+            GfRange2d ndc;
+            for (int corner = 0; corner < 8; ++corner) {
+                GfVec3f offset(
+                    corner & 1 ? radius : -radius,
+                    corner & 2 ? radius : -radius,
+                    corner & 4 ? radius : -radius);
+                GfVec3f p = center + offset;
+                GfVec4d clip = GfVec4d(p[0], p[1], p[2], 1) * projection_;
+                ndc.UnionWith(GfVec2d(clip[0] / clip[3], clip[1] / clip[3]));
+            }
+            if (ndc.GetMax()[0] < -1 || ndc.GetMin()[0] > 1 || ndc.GetMax()[1] < -1 ||
+                ndc.GetMin()[1] > 1) {
+                continue;
+            }
+            auto tile = [this](double v, int axis, int count) {
+                return std::clamp(int((v * 0.5 + 0.5) * size_[axis] / tileSize), 0, count - 1);
+            };
+            x0 = tile(ndc.GetMin()[0], 0, count_x_);
+            x1 = tile(ndc.GetMax()[0], 0, count_x_);
+            y0 = tile(ndc.GetMin()[1], 1, count_y_);
+            y1 = tile(ndc.GetMax()[1], 1, count_y_);
+        }
+
+        int z0 = slice_of(depth - radius);
+        int z1 = slice_of(depth + radius);
+        for (int z = z0; z <= z1; ++z) {
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    GLuint cluster = x + count_x_ * (y + count_y_ * z);
+                    if (sphere_intersects(cluster_bounds_[cluster], center, radius)) {
+                        hits.emplace_back(cluster, light_id);
+                    }
+                }
+            }
+        }
+    }
+
+    // Counting sort of the pairs by cluster, which keeps lights ascending within a cluster.
+    const size_t cluster_count = cluster_bounds_.size();
+    ranges_cpu_.assign(2 * cluster_count, 0);
+    for (auto& hit : hits) {
+        ranges_cpu_[2 * hit.first + 1]++;
+    }
+    GLuint offset = 0;
+    for (size_t cluster = 0; cluster < cluster_count; ++cluster) {
+        ranges_cpu_[2 * cluster] = offset;
+        offset += ranges_cpu_[2 * cluster + 1];
+    }
+    indices_cpu_.resize(hits.size());
+    std::vector<GLuint> filled(cluster_count, 0);
+    for (auto& hit : hits) {
+        indices_cpu_[ranges_cpu_[2 * hit.first] + filled[hit.first]++] = hit.second;
+    }
+
+    // Nothing is uploaded while the camera and the lights stand still.
+    ranges_.update(ranges_cpu_);
+    indices_.update(indices_cpu_);
+}
+
+void LightClusters::bind(const Shader& shader) const
+{
+    ranges_.bind(2);
+    indices_.bind(3);
+
+    shader.setMat4("view", GfMatrix4f(view_));
+    shader.setInt("cluster_tile_size", tileSize);
+    shader.setInt("cluster_count_x", count_x_);
+    shader.setInt("cluster_count_y", count_y_);
+    shader.setInt("cluster_slice_count", sliceCount);
+    shader.setFloat("cluster_near", near_);
+    shader.setFloat("cluster_far", far_);
+}
+
+void LightClusters::release()
+{
+    ranges_.release();
+    indices_.release();
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
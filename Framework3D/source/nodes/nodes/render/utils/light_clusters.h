@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/matrix4d.h"
+#include "pxr/base/gf/range3f.h"
+#include "pxr/base/gf/vec2i.h"
+#include "pxr/base/gf/vec3f.h"
+#include "storage_buffer.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+class Shader;
+
+// Bins local lights into view-space froxels: screen tiles of tileSize pixels times sliceCount
+// depth slices, spaced logarithmically between the camera near and far planes. The lighting pass
+// then only loops over the lights of the froxel of each pixel.
+//
+// Storage buffers: 2 = uvec2 (offset, count) per cluster into 3 = light indices. Clusters are
+// laid out x fastest, then y, then the slice.
+class LightClusters {
+   public:
+    static constexpr int tileSize = 64;
+    static constexpr int sliceCount = 24;
+
+    struct LocalLight {
+        pxr::GfVec3f position;
+        // Distance beyond which the light is ignored.
+        float range;
+    };
+
+    // The view matrix is world to camera, both matrices in the row-vector convention of Gf.
+    void update(
+        const std::vector<LocalLight>& lights,
+        const pxr::GfMatrix4d& view,
+        const pxr::GfMatrix4d& projection,
+        const pxr::GfVec2i& size);
+
+    // Binds the cluster buffers and sets the uniforms the shader needs to find its cluster.
+    void bind(const Shader& shader) const;
+
+    // Frees the cluster buffers, registered with register_gl_release.
+    void release();
+
+   private:
+    void build_cluster_bounds();
+    [[nodiscard]] int slice_of(float depth) const;
+
+    pxr::GfMatrix4d view_;
+    pxr::GfMatrix4d projection_;
+    pxr::GfVec2i size_ = { 0, 0 };
+    int count_x_ = 0;
+    int count_y_ = 0;
+    float near_ = 0;
+    float far_ = 0;
+
+    // View-space bounds of every cluster, rebuilt when the projection or the viewport changes.
+    std::vector<pxr::GfRange3f> cluster_bounds_;
+
+    std::vector<GLuint> ranges_cpu_;
+    std::vector<GLuint> indices_cpu_;
+    StorageBuffer ranges_;
+    StorageBuffer indices_;
+};
+
+extern LightClusters light_clusters;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
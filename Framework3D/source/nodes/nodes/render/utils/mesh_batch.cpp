@@ -0,0 +1,424 @@
+#include "mesh_batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+
+#include "RCore/internal/gl/gl_release.hpp"
+#include "geometries/mesh.h"
+#include "material.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+MeshBatch mesh_batch;
+static const bool mesh_batch_registered = register_gl_release([] { mesh_batch.release(); });
+
+static constexpr GLuint drawIdLocation = 3;
+static constexpr GLbitfield persistentMapFlags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+void MeshBatch::release()
+{
+    for (auto& fence : fences_) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mapped_positions_) {
+        glUnmapNamedBuffer(positions_);
+        glUnmapNamedBuffer(normals_);
+        mapped_positions_ = mapped_normals_ = nullptr;
+    }
+    ring_vertex_count_ = 0;
+    region_ = 0;
+
+    glDeleteVertexArrays(1, &vao_);
+    GLuint buffers[] = {
+        positions_, normals_, texcoords_, indices_, draw_tags_, models_, commands_
+    };
+    glDeleteBuffers(std::size(buffers), buffers);
+    vao_ = positions_ = normals_ = texcoords_ = indices_ = draw_tags_ = models_ = commands_ = 0;
+
+    entries_.clear();
+    commands_cpu_.clear();
+    material_ranges_.clear();
+    model_matrices_.clear();
+    selected_count_ = 0;
+}
+
+void MeshBatch::update(const MeshArray& meshes, MaterialMap* materials)
+{
+    std::vector<Entry> entries;
+    entries.reserve(meshes.size());
+    for (auto mesh : meshes) {
+        TfToken texcoord_name;
+        if (materials) {
+            auto material = (*materials)[mesh->GetMaterialId()];
+            texcoord_name = material ? material->requireTexcoordName() : TfToken();
+        }
+        entries.push_back({ mesh->GetId(),
+                            mesh,
+                            mesh->vertexVersion,
+                            mesh->topologyVersion,
+                            mesh->primvarVersion,
+                            texcoord_name,
+                            0,
+                            static_cast<GLsizei>(mesh->points.size()),
+                            0,
+                            static_cast<GLsizei>(mesh->triangulatedIndices.size() * 3) });
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.mesh->GetMaterialId() < rhs.mesh->GetMaterialId();
+    });
+
+    auto same_layout = [this, &entries]() {
+        if (entries.size() != entries_.size() || !vao_) {
+            return false;
+        }
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].id != entries_[i].id ||
+                entries[i].vertex_count != entries_[i].vertex_count ||
+                entries[i].index_count != entries_[i].index_count) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (same_layout()) {
+        bool vertices_moved = false;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            auto& entry = entries_[i];
+            auto mesh = entry.mesh = entries[i].mesh;
+            if (entry.vertex_version != mesh->vertexVersion) {
+                const VertexRange all = { 0, static_cast<size_t>(entry.vertex_count) };
+                if (entry.vertex_version == mesh->previousVertexVersion) {
+                    mark_vertices(entry, mesh->changedPoints, mesh->changedNormals);
+                }
+                else {
+                    mark_vertices(entry, all, all);
+                }
+                entry.vertex_version = mesh->vertexVersion;
+                vertices_moved = true;
+            }
+            if (entry.topology_version != mesh->topologyVersion) {
+                upload_indices(entry);
+                entry.topology_version = mesh->topologyVersion;
+            }
+            bool texcoord_changed = materials && entries[i].texcoord_name != entry.texcoord_name;
+            if (entry.primvar_version != mesh->primvarVersion || texcoord_changed) {
+                if (materials) {
+                    entry.texcoord_name = entries[i].texcoord_name;
+                }
+                upload_texcoords(entry);
+                entry.primvar_version = mesh->primvarVersion;
+            }
+        }
+        if (vertices_moved) {
+            advance_region();
+        }
+    }
+    else {
+        rebuild(std::move(entries));
+    }
+
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        model_matrices_[i] = entries_[i].mesh->transform;
+    }
+    if (!model_matrices_.empty()) {
+        glNamedBufferSubData(
+            models_, 0, model_matrices_.size() * sizeof(GfMatrix4f), model_matrices_.data());
+    }
+}
+
+void MeshBatch::rebuild(std::vector<Entry>&& entries)
+{
+    release();
+    entries_ = std::move(entries);
+    model_matrices_.resize(entries_.size());
+    commands_cpu_.clear();
+    ++layout_version_;
+
+    GLint vertex_count = 0;
+    GLuint index_count = 0;
+    for (auto& entry : entries_) {
+        entry.base_vertex = vertex_count;
+        entry.first_index = index_count;
+        vertex_count += entry.vertex_count;
+        index_count += entry.index_count;
+
+        commands_cpu_.push_back({ static_cast<GLuint>(entry.index_count),
+                                  1,
+                                  entry.first_index,
+                                  entry.base_vertex,
+                                  0 });
+    }
+    if (entries_.empty()) {
+        material_ranges_.clear();
+        selected_count_ = 0;
+        return;
+    }
+
+    // Zero-sized storage is an error, so every buffer gets at least one element.
+    auto create = [](GLuint& buffer, GLsizeiptr size, const void* data = nullptr) {
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, std::max<GLsizeiptr>(size, 16), data, GL_DYNAMIC_STORAGE_BIT);
+    };
+    auto create_ring = [vertex_count](GLuint& buffer) {
+        const GLsizeiptr size =
+            std::max<GLsizeiptr>(vertex_count * sizeof(GfVec3f), 16) * ringRegionCount;
+        glCreateBuffers(1, &buffer);
+        glNamedBufferStorage(buffer, size, nullptr, persistentMapFlags);
+        return static_cast<GfVec3f*>(glMapNamedBufferRange(buffer, 0, size, persistentMapFlags));
+    };
+    mapped_positions_ = create_ring(positions_);
+    mapped_normals_ = create_ring(normals_);
+    ring_vertex_count_ = vertex_count;
+    create(texcoords_, vertex_count * sizeof(GfVec2f));
+    create(indices_, index_count * sizeof(GLuint));
+    create(models_, entries_.size() * sizeof(GfMatrix4f));
+
+    // The command and tag buffers are rewritten by select(), so they keep mutable storage for
+    // orphaning.
+    glCreateBuffers(1, &commands_);
+    glCreateBuffers(1, &draw_tags_);
+    select_all();
+
+    // The position and normal bindings are set by advance_region().
+    glCreateVertexArrays(1, &vao_);
+    glVertexArrayAttribFormat(vao_, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao_, 0, 0);
+    glEnableVertexArrayAttrib(vao_, 0);
+
+    glVertexArrayAttribFormat(vao_, Hd_USTC_CG_Mesh::normalLocation, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(
+        vao_, Hd_USTC_CG_Mesh::normalLocation, Hd_USTC_CG_Mesh::normalLocation);
+    glEnableVertexArrayAttrib(vao_, Hd_USTC_CG_Mesh::normalLocation);
+
+    // The tag is fetched once per instance, and each command starts at its own base instance.
+    glVertexArrayVertexBuffer(vao_, drawIdLocation, draw_tags_, 0, sizeof(GLuint));
+    glVertexArrayAttribIFormat(vao_, drawIdLocation, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vao_, drawIdLocation, drawIdLocation);
+    glVertexArrayBindingDivisor(vao_, drawIdLocation, 1);
+    glEnableVertexArrayAttrib(vao_, drawIdLocation);
+
+    glVertexArrayElementBuffer(vao_, indices_);
+
+    for (auto& entry : entries_) {
+        const VertexRange all = { 0, static_cast<size_t>(entry.vertex_count) };
+        mark_vertices(entry, all, all);
+        upload_indices(entry);
+        upload_texcoords(entry);
+    }
+    advance_region();
+}
+
+void MeshBatch::mark_vertices(Entry& entry, const VertexRange& points, const VertexRange& normals)
+{
+    auto mark = [](VertexRange& pending, const VertexRange& range) {
+        if (range.first >= range.second) {
+            return;
+        }
+        if (pending.first >= pending.second) {
+            pending = range;
+        }
+        else {
+            pending = { std::min(pending.first, range.first),
+                        std::max(pending.second, range.second) };
+        }
+    };
+    for (int region = 0; region < ringRegionCount; ++region) {
+        mark(entry.pending_points[region], points);
+        mark(entry.pending_normals[region], normals);
+    }
+}
+
+void MeshBatch::advance_region()
+{
+    // Every draw reading the current region has been issued by now.
+    if (fences_[region_]) {
+        glDeleteSync(fences_[region_]);
+    }
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    region_ = (region_ + 1) % ringRegionCount;
+    if (fences_[region_]) {
+        while (glClientWaitSync(fences_[region_], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) ==
+               GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fences_[region_]);
+        fences_[region_] = nullptr;
+    }
+
+    const size_t region_offset = static_cast<size_t>(region_) * ring_vertex_count_;
+    auto write = [region_offset](
+                     GfVec3f* mapped,
+                     const Entry& entry,
+                     const VtVec3fArray& values,
+                     VertexRange& pending) {
+        if (pending.first < pending.second &&
+            values.size() == static_cast<size_t>(entry.vertex_count)) {
+            std::memcpy(
+                mapped + region_offset + entry.base_vertex + pending.first,
+                values.cdata() + pending.first,
+                (pending.second - pending.first) * sizeof(GfVec3f));
+        }
+        pending = {};
+    };
+    for (auto& entry : entries_) {
+        write(mapped_positions_, entry, entry.mesh->points, entry.pending_points[region_]);
+        write(mapped_normals_, entry, entry.mesh->computedNormals, entry.pending_normals[region_]);
+    }
+
+    const GLintptr offset = region_offset * sizeof(GfVec3f);
+    glVertexArrayVertexBuffer(vao_, 0, positions_, offset, sizeof(GfVec3f));
+    glVertexArrayVertexBuffer(
+        vao_, Hd_USTC_CG_Mesh::normalLocation, normals_, offset, sizeof(GfVec3f));
+}
+
+void MeshBatch::upload_indices(const Entry& entry)
+{
+    auto mesh = entry.mesh;
+    if (!entry.index_count ||
+        mesh->triangulatedIndices.size() * 3 != static_cast<size_t>(entry.index_count)) {
+        return;
+    }
+    glNamedBufferSubData(
+        indices_,
+        entry.first_index * sizeof(GLuint),
+        entry.index_count * sizeof(GLuint),
+        mesh->triangulatedIndices.cdata());
+}
+
+void MeshBatch::upload_texcoords(const Entry& entry)
+{
+    if (!entry.vertex_count) {
+        return;
+    }
+    VtVec2fArray texcoord = entry.mesh->ComputeVertexTexcoords(entry.texcoord_name);
+    texcoord.resize(entry.vertex_count);
+    glNamedBufferSubData(
+        texcoords_,
+        entry.base_vertex * sizeof(GfVec2f),
+        entry.vertex_count * sizeof(GfVec2f),
+        texcoord.cdata());
+}
+
+void MeshBatch::select(const std::vector<GLuint>& draws)
+{
+    std::vector<DrawElementsIndirectCommand> commands;
+    commands.reserve(draws.size());
+    material_ranges_.clear();
+    for (auto draw : draws) {
+        auto& material_id = entries_[draw].mesh->GetMaterialId();
+        if (material_ranges_.empty() || material_ranges_.back().material_id != material_id) {
+            material_ranges_.push_back({ material_id, static_cast<GLsizei>(commands.size()), 0 });
+        }
+        material_ranges_.back().draw_count++;
+        commands.push_back(commands_cpu_[draw]);
+    }
+    upload_selection(commands, draws);
+}
+
+void MeshBatch::select_layered(const std::vector<std::vector<GLuint>>& layers)
+{
+    assert(layers.size() <= maxLayers);
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<GLuint> tags;
+    material_ranges_.clear();
+    for (GLuint layer = 0; layer < layers.size(); ++layer) {
+        for (auto draw : layers[layer]) {
+            commands.push_back(commands_cpu_[draw]);
+            tags.push_back(draw | layer << layerShift);
+        }
+    }
+    upload_selection(commands, tags);
+}
+
+bool MeshBatch::supports_layered_draws()
+{
+    static const bool supported = [] {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (name && std::strcmp(name, "GL_ARB_shader_viewport_layer_array") == 0) {
+                return true;
+            }
+        }
+        return false;
+    }();
+    return supported;
+}
+
+// Command i reads tags[i] through its base instance.
+void MeshBatch::upload_selection(
+    const std::vector<DrawElementsIndirectCommand>& commands,
+    const std::vector<GLuint>& tags)
+{
+    selected_count_ = static_cast<GLsizei>(commands.size());
+    if (!commands_) {
+        return;
+    }
+
+    std::vector<DrawElementsIndirectCommand> indexed(commands);
+    for (GLuint i = 0; i < indexed.size(); ++i) {
+        indexed[i].base_instance = i;
+    }
+    glNamedBufferData(
+        commands_,
+        std::max<size_t>(indexed.size(), 1) * sizeof(DrawElementsIndirectCommand),
+        indexed.empty() ? nullptr : indexed.data(),
+        GL_STREAM_DRAW);
+    glNamedBufferData(
+        draw_tags_,
+        std::max<size_t>(tags.size(), 1) * sizeof(GLuint),
+        tags.empty() ? nullptr : tags.data(),
+        GL_STREAM_DRAW);
+}
+
+void MeshBatch::select_all()
+{
+    std::vector<GLuint> draws(entries_.size());
+    std::iota(draws.begin(), draws.end(), 0);
+    select(draws);
+}
+
+void MeshBatch::bind() const
+{
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, texcoords_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, models_);
+}
+
+void MeshBatch::unbind() const
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void MeshBatch::draw_all() const
+{
+    if (!selected_count_) {
+        return;
+    }
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, selected_count_, 0);
+}
+
+void MeshBatch::draw(const MaterialRange& range) const
+{
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES,
+        GL_UNSIGNED_INT,
+        reinterpret_cast<const void*>(range.first_draw * sizeof(DrawElementsIndirectCommand)),
+        range.draw_count,
+        0);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
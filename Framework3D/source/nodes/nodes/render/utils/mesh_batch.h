@@ -0,0 +1,157 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/matrix4f.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/imaging/garch/glApi.h"
+#include "pxr/usd/sdf/path.h"
+#include "rich_type_buffer.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// Packs all scene meshes into one shared vertex/index arena so that a pass can submit them with
+// glMultiDrawElementsIndirect instead of one draw call per mesh.
+//
+// Vertex attributes: location 0 = position, 1 = normal, 3 = draw tag (one per command, through
+// the instance divisor). The tag holds the draw index in its low 24 bits and, for layered
+// selections, the target layer in its high 8 bits. Texcoords are bound as SSBO 0 and indexed with
+// gl_VertexID, the per-draw model matrices as SSBO 1 indexed with the draw index.
+//
+// Draws are sorted by material, so textures only need to be rebound once per material range.
+//
+// Positions and normals live in persistently mapped rings of ringRegionCount copies of the whole
+// arena. When vertices move, only their changed ranges are written into the next region, after
+// the fence of the frame that last drew from it, and the vertex bindings are pointed at it.
+class MeshBatch {
+   public:
+    struct MaterialRange {
+        pxr::SdfPath material_id;
+        GLsizei first_draw;
+        GLsizei draw_count;
+    };
+
+    // Re-packs the arena if the set of meshes or their sizes changed. Otherwise only what changed
+    // is written: the moved vertex range of a mesh whose copy is at its previous vertex version
+    // (all of its vertices otherwise) into the next ring region, its indices on topology
+    // changes, and its texcoords on primvar, topology or texcoord name changes. Model matrices
+    // are refreshed every call.
+    // Without materials (e.g. depth-only passes) the texcoord primvars of the last update with
+    // materials are kept.
+    void update(const MeshArray& meshes, MaterialMap* materials = nullptr);
+
+    void bind() const;
+    void unbind() const;
+
+    // Frees the arena and forgets the meshes, registered with register_gl_release. The next
+    // update re-packs it.
+    void release();
+
+    // Restricts the following draws to a subset of the draw indices, given in ascending order
+    // (e.g. the visible list from culling). Material ranges are recomputed over the subset.
+    void select(const std::vector<GLuint>& draws);
+    void select_all();
+
+    // Selects one list of draws per layer (ascending order within each), for passes that write
+    // gl_Layer from the draw tag. All layers go out in a single multi-draw. There are no material
+    // ranges for a layered selection.
+    void select_layered(const std::vector<std::vector<GLuint>>& layers);
+    // Whether a vertex shader may write gl_Layer (GL_ARB_shader_viewport_layer_array). Without
+    // it, layered selections have to be drawn one layer at a time into a single-layer target.
+    static bool supports_layered_draws();
+
+    static constexpr unsigned maxLayers = 256;
+    static constexpr int ringRegionCount = 3;
+    static constexpr unsigned layerShift = 24;
+
+    void draw_all() const;
+    void draw(const MaterialRange& range) const;
+
+    // Material ranges of the current selection.
+    [[nodiscard]] const std::vector<MaterialRange>& material_ranges() const
+    {
+        return material_ranges_;
+    }
+
+    [[nodiscard]] size_t draw_count() const
+    {
+        return entries_.size();
+    }
+
+    // Valid until the next update.
+    [[nodiscard]] Hd_USTC_CG_Mesh* mesh(size_t draw) const
+    {
+        return entries_[draw].mesh;
+    }
+
+    // Changes whenever the arena is re-packed, i.e. draw indices refer to different meshes.
+    [[nodiscard]] unsigned layout_version() const
+    {
+        return layout_version_;
+    }
+
+   private:
+    using VertexRange = std::pair<size_t, size_t>;
+
+    // Entries are matched to meshes by prim path. The mesh pointer is refreshed by every update.
+    struct Entry {
+        pxr::SdfPath id;
+        Hd_USTC_CG_Mesh* mesh;
+        unsigned vertex_version;
+        unsigned topology_version;
+        unsigned primvar_version;
+        pxr::TfToken texcoord_name;
+        GLint base_vertex;
+        GLsizei vertex_count;
+        GLuint first_index;
+        GLsizei index_count;
+        // The vertices each ring region misses, written the next time it becomes current.
+        VertexRange pending_points[ringRegionCount];
+        VertexRange pending_normals[ringRegionCount];
+    };
+
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    void rebuild(std::vector<Entry>&& entries);
+    static void mark_vertices(Entry& entry, const VertexRange& points, const VertexRange& normals);
+    // Fences the current region and moves on to the next one, filling in what it misses.
+    void advance_region();
+    void upload_indices(const Entry& entry);
+    void upload_texcoords(const Entry& entry);
+    void upload_selection(
+        const std::vector<DrawElementsIndirectCommand>& commands,
+        const std::vector<GLuint>& tags);
+
+    std::vector<Entry> entries_;
+    std::vector<DrawElementsIndirectCommand> commands_cpu_;
+    std::vector<MaterialRange> material_ranges_;
+    GLsizei selected_count_ = 0;
+    unsigned layout_version_ = 0;
+    std::vector<pxr::GfMatrix4f> model_matrices_;
+
+    GLuint vao_ = 0;
+    GLuint positions_ = 0;
+    GLuint normals_ = 0;
+    pxr::GfVec3f* mapped_positions_ = nullptr;
+    pxr::GfVec3f* mapped_normals_ = nullptr;
+    GLsizei ring_vertex_count_ = 0;
+    int region_ = 0;
+    GLsync fences_[ringRegionCount] = {};
+    GLuint texcoords_ = 0;
+    GLuint indices_ = 0;
+    GLuint draw_tags_ = 0;
+    GLuint models_ = 0;
+    GLuint commands_ = 0;
+};
+
+extern MeshBatch mesh_batch;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
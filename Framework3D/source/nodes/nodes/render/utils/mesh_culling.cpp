@@ -0,0 +1,177 @@
+#include "mesh_culling.h"
+
+#include <algorithm>
+
+#include "geometries/mesh.h"
+#include "mesh_batch.h"
+#include "pxr/base/gf/bbox3d.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+MeshCulling mesh_culling;
+
+static constexpr unsigned maxLeafSize = 4;
+
+void MeshCulling::update(const MeshBatch& batch)
+{
+    std::vector<GfRange3f> bounds(batch.draw_count());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        auto mesh = batch.mesh(i);
+        if (!mesh->localBounds.IsEmpty()) {
+            GfBBox3d box(GfRange3d(mesh->localBounds), GfMatrix4d(mesh->transform));
+            auto range = box.ComputeAlignedRange();
+            bounds[i] = GfRange3f(GfVec3f(range.GetMin()), GfVec3f(range.GetMax()));
+        }
+    }
+
+    if (batch.layout_version() != layout_version_) {
+        bounds_ = std::move(bounds);
+        layout_version_ = batch.layout_version();
+        build();
+    }
+    else if (bounds != bounds_) {
+        bounds_ = std::move(bounds);
+        refit();
+    }
+}
+
+void MeshCulling::build()
+{
+    order_.resize(bounds_.size());
+    for (unsigned i = 0; i < order_.size(); ++i) {
+        order_[i] = i;
+    }
+    nodes_.clear();
+    if (!order_.empty()) {
+        nodes_.reserve(2 * order_.size());
+        nodes_.emplace_back();
+        build_node(0, 0, order_.size());
+    }
+}
+
+// Fills nodes_[index] with the subtree over the draws order_[first, first + count).
+void MeshCulling::build_node(unsigned index, unsigned first, unsigned count)
+{
+    GfRange3f bounds;
+    for (unsigned i = first; i < first + count; ++i) {
+        bounds.UnionWith(bounds_[order_[i]]);
+    }
+    nodes_[index] = { bounds, first, count, 0 };
+
+    if (count <= maxLeafSize) {
+        return;
+    }
+
+    // Median split along the widest axis.
+    auto extent = bounds.IsEmpty() ? GfVec3f(0) : bounds.GetSize();
+    int axis = extent[0] > extent[1] ? (extent[0] > extent[2] ? 0 : 2)
+                                     : (extent[1] > extent[2] ? 1 : 2);
+    unsigned mid = first + count / 2;
+    std::nth_element(
+        order_.begin() + first,
+        order_.begin() + mid,
+        order_.begin() + first + count,
+        [this, axis](unsigned lhs, unsigned rhs) {
+            return bounds_[lhs].GetMidpoint()[axis] < bounds_[rhs].GetMidpoint()[axis];
+        });
+
+    unsigned left = nodes_.size();
+    nodes_.emplace_back();
+    nodes_.emplace_back();
+    nodes_[index].left = left;
+    build_node(left, first, mid - first);
+    build_node(left + 1, mid, first + count - mid);
+}
+
+void MeshCulling::refit()
+{
+    // Children are always stored after their parent.
+    for (auto it = nodes_.rbegin(); it != nodes_.rend(); ++it) {
+        if (it->left) {
+            it->bounds = GfRange3f::GetUnion(nodes_[it->left].bounds, nodes_[it->left + 1].bounds);
+        }
+        else {
+            it->bounds = GfRange3f();
+            for (unsigned i = it->first; i < it->first + it->count; ++i) {
+                it->bounds.UnionWith(bounds_[order_[i]]);
+            }
+        }
+    }
+}
+
+std::vector<GLuint> MeshCulling::cull(const GfMatrix4f& view_projection) const
+{
+    std::vector<GLuint> visible;
+    if (nodes_.empty()) {
+        return visible;
+    }
+
+    // Gribb-Hartmann plane extraction. With row vectors, clip = p * M, so the planes are sums
+    // and differences of the matrix columns.
+    GfVec4f columns[4];
+    for (int j = 0; j < 4; ++j) {
+        columns[j] = GfVec4f(
+            view_projection[0][j],
+            view_projection[1][j],
+            view_projection[2][j],
+            view_projection[3][j]);
+    }
+    GfVec4f planes[6] = { columns[3] + columns[0], columns[3] - columns[0],
+                          columns[3] + columns[1], columns[3] - columns[1],
+                          columns[3] + columns[2], columns[3] - columns[2] };
+
+    enum class Result { Outside, Intersect, Inside };
+    auto classify = [&planes](const GfRange3f& box) {
+        if (box.IsEmpty()) {
+            return Result::Outside;
+        }
+        const auto& min = box.GetMin();
+        const auto& max = box.GetMax();
+        Result result = Result::Inside;
+        for (const auto& plane : planes) {
+            // Farthest and nearest corners along the plane normal.
+            float far_distance = plane[3];
+            float near_distance = plane[3];
+            for (int k = 0; k < 3; ++k) {
+                float a = plane[k] * min[k];
+                float b = plane[k] * max[k];
+                far_distance += std::max(a, b);
+                near_distance += std::min(a, b);
+            }
+            if (far_distance < 0) {
+                return Result::Outside;
+            }
+            if (near_distance < 0) {
+                result = Result::Intersect;
+            }
+        }
+        return result;
+    };
+
+    std::vector<unsigned> stack = { 0 };
+    while (!stack.empty()) {
+        const BVHNode& node = nodes_[stack.back()];
+        stack.pop_back();
+
+        Result result = classify(node.bounds);
+        if (result == Result::Outside) {
+            continue;
+        }
+        if (result == Result::Inside || !node.left) {
+            for (unsigned i = node.first; i < node.first + node.count; ++i) {
+                if (result == Result::Inside || classify(bounds_[order_[i]]) != Result::Outside) {
+                    visible.push_back(order_[i]);
+                }
+            }
+            continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.left + 1);
+    }
+
+    std::sort(visible.begin(), visible.end());
+    return visible;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
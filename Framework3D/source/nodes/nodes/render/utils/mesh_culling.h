@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/matrix4f.h"
+#include "pxr/base/gf/range3f.h"
+#include "pxr/base/gf/vec4f.h"
+#include "pxr/imaging/garch/glApi.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+class MeshBatch;
+
+// Frustum culling for the draws of a MeshBatch. World-space bounds of every draw are kept in a
+// BVH, which is rebuilt when the batch is re-packed and only refitted when transforms or points
+// move. The result of cull() is a visible list suitable for MeshBatch::select().
+class MeshCulling {
+   public:
+    void update(const MeshBatch& batch);
+
+    // Draw indices, in ascending order, whose bounds intersect the frustum of view_projection
+    // (row-vector convention, as GfMatrix4f).
+    [[nodiscard]] std::vector<GLuint> cull(const pxr::GfMatrix4f& view_projection) const;
+
+   private:
+    struct BVHNode {
+        pxr::GfRange3f bounds;
+        // Draws of this subtree are order_[first, first + count).
+        unsigned first;
+        unsigned count;
+        // Index of the left child, the right one follows it. 0 for leaves.
+        unsigned left;
+    };
+
+    void build();
+    void build_node(unsigned index, unsigned first, unsigned count);
+    void refit();
+
+    std::vector<pxr::GfRange3f> bounds_;
+    std::vector<unsigned> order_;
+    std::vector<BVHNode> nodes_;
+    unsigned layout_version_ = ~0u;
+};
+
+extern MeshCulling mesh_culling;
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
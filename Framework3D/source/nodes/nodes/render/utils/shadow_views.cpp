@@ -0,0 +1,158 @@
+#include "shadow_views.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "camera.h"
+#include "light.h"
+#include "pxr/base/gf/frustum.h"
+#include "pxr/base/gf/range3d.h"
+#include "pxr/imaging/glf/simpleLight.h"
+#include "pxr/imaging/hd/tokens.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+using namespace pxr;
+
+// Blend between logarithmic (1) and uniform (0) cascade splits.
+static constexpr double splitLambda = 0.75;
+
+// The four corner rays of the camera frustum, from the near to the far plane.
+struct CameraRays {
+    GfVec3d near_points[4];
+    GfVec3d far_points[4];
+    double near_depth;
+    double far_depth;
+
+    explicit CameraRays(const Hd_USTC_CG_Camera* camera)
+    {
+        GfMatrix4d inverse = (camera->_viewMatrix * camera->_projMatrix).GetInverse();
+        for (int k = 0; k < 4; ++k) {
+            double x = (k & 1) ? 1 : -1;
+            double y = (k & 2) ? 1 : -1;
+            near_points[k] = inverse.Transform(GfVec3d(x, y, -1));
+            far_points[k] = inverse.Transform(GfVec3d(x, y, 1));
+        }
+        near_depth = -camera->_viewMatrix.Transform(near_points[0])[2];
+        far_depth = -camera->_viewMatrix.Transform(far_points[0])[2];
+    }
+
+    // View depth is linear along each ray, for perspective and orthographic cameras alike.
+    GfVec3d at(int k, double depth) const
+    {
+        double t = (depth - near_depth) / (far_depth - near_depth);
+        return near_points[k] + (far_points[k] - near_points[k]) * t;
+    }
+};
+
+static double split_depth(double near_depth, double far_depth, int i)
+{
+    double fraction = double(i) / shadowCascadeCount;
+    double logarithmic = near_depth * std::pow(far_depth / near_depth, fraction);
+    double uniform = near_depth + (far_depth - near_depth) * fraction;
+    return splitLambda * logarithmic + (1 - splitLambda) * uniform;
+}
+
+// Fits an orthographic projection around the slice corners as seen from the light. The window
+// is square and snapped to whole texels, so the map does not shimmer while the camera moves.
+static GfMatrix4d fit_cascade(const GfMatrix4d& light_view, const GfVec3d* corners, int resolution)
+{
+    GfRange3d range;
+    for (int i = 0; i < 8; ++i) {
+        range.UnionWith(light_view.Transform(corners[i]));
+    }
+    GfVec3d min = range.GetMin();
+    GfVec3d max = range.GetMax();
+
+    double size = std::max(max[0] - min[0], max[1] - min[1]);
+    double texel = size / std::max(resolution - 2, 1);
+    if (texel > 0) {
+        for (int axis = 0; axis < 2; ++axis) {
+            min[axis] = std::floor(min[axis] / texel) * texel;
+            max[axis] = min[axis] + texel * resolution;
+        }
+    }
+
+    // The light looks down -z. Casters between the light and the slice must land in the map too,
+    // so the near plane is pulled towards the light.
+    GfFrustum frustum;
+    frustum.SetOrthographic(
+        min[0], max[0], min[1], max[1], -max[2] - maxShadowDistance, -min[2]);
+    return frustum.ComputeProjectionMatrix();
+}
+
+static void add_cascades(
+    std::vector<ShadowView>& views,
+    int light_id,
+    const GfVec3d& to_light,
+    const CameraRays& rays,
+    int resolution)
+{
+    GfVec3d up = std::abs(to_light[2]) < 0.99 ? GfVec3d(0, 0, 1) : GfVec3d(0, 1, 0);
+    GfMatrix4d light_view = GfMatrix4d().SetLookAt(GfVec3d(0.0), -to_light, up);
+
+    double near_depth = std::max(rays.near_depth, 1e-3);
+    double far_depth = std::min(rays.far_depth, near_depth + maxShadowDistance);
+
+    for (int cascade = 0; cascade < shadowCascadeCount; ++cascade) {
+        double slice_near = split_depth(near_depth, far_depth, cascade);
+        double slice_far = split_depth(near_depth, far_depth, cascade + 1);
+
+        GfVec3d corners[8];
+        for (int k = 0; k < 4; ++k) {
+            corners[k] = rays.at(k, slice_near);
+            corners[k + 4] = rays.at(k, slice_far);
+        }
+        views.push_back({ GfMatrix4f(light_view),
+                          GfMatrix4f(fit_cascade(light_view, corners, resolution)),
+                          light_id,
+                          float(slice_far) });
+    }
+}
+
+std::vector<ShadowView> compute_shadow_views(
+    const LightArray& lights,
+    const Hd_USTC_CG_Camera* camera,
+    int resolution,
+    size_t max_layers)
+{
+    std::vector<ShadowView> views;
+    for (int light_id = 0; light_id < lights.size(); ++light_id) {
+        auto light = lights[light_id];
+        if (light->GetId().IsEmpty()) {
+            continue;
+        }
+        const size_t light_begin = views.size();
+        GlfSimpleLight light_params = light->Get(HdTokens->params).Get<GlfSimpleLight>();
+        auto position = light_params.GetPosition();
+
+        if (light->GetLightType() == HdPrimTypeTokens->sphereLight) {
+            // HW6: The matrices for lights information is here! Current value is set that "it
+            // just works". However, you should try to modify the values to see how it affects the
+            // performance of the shadow maps.
+            GfFrustum frustum;
+            GfVec3f light_position = { position[0], position[1], position[2] };
+
+            GfMatrix4f light_view_mat =
+                GfMatrix4f().SetLookAt(light_position, GfVec3f(0, 0, 0), GfVec3f(0, 0, 1));
+            frustum.SetPerspective(120.f, 1.0, 1, 25.f);
+            views.push_back({ light_view_mat,
+                              GfMatrix4f(frustum.ComputeProjectionMatrix()),
+                              light_id,
+                              0.f });
+        }
+        else if (light->GetLightType() == HdPrimTypeTokens->distantLight && camera) {
+            // See light.cpp: a distant light stores the direction towards it in the position.
+            GfVec3d to_light(position[0], position[1], position[2]);
+            if (to_light.Normalize() > 0) {
+                add_cascades(views, light_id, to_light, CameraRays(camera), resolution);
+            }
+        }
+        if (views.size() > max_layers) {
+            views.resize(light_begin);
+            break;
+        }
+    }
+    return views;
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
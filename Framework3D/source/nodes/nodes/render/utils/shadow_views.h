@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/base/gf/matrix4f.h"
+#include "rich_type_buffer.hpp"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// One layer of the shadow map array. Sphere lights own one layer, distant lights own
+// shadowCascadeCount consecutive layers that split the camera frustum by view depth.
+struct ShadowView {
+    pxr::GfMatrix4f light_view;
+    pxr::GfMatrix4f light_projection;
+    // Index into the LightArray.
+    int light_id;
+    // View-space depth where this cascade ends. 0 for non-cascaded lights.
+    float split_far;
+};
+
+static constexpr int shadowCascadeCount = 4;
+// Cascades never reach further than this from the camera, whatever its far plane.
+static constexpr float maxShadowDistance = 100.f;
+
+// Layer i of the shadow map array is rendered with views[i]. Both the shadow pass and the
+// lighting pass call this, so the layout only depends on the lights, the camera and the shadow
+// map resolution (cascades are snapped to its texels). Lights whose views do not all fit in
+// max_layers, and the lights after them, get no shadow.
+std::vector<ShadowView> compute_shadow_views(
+    const LightArray& lights,
+    const Hd_USTC_CG_Camera* camera,
+    int resolution,
+    size_t max_layers);
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
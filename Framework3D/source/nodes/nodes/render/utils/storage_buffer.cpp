@@ -0,0 +1,45 @@
+#include "storage_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+void StorageBuffer::release()
+{
+    glDeleteBuffers(1, &buffer_);
+    buffer_ = 0;
+    capacity_ = 0;
+    contents_.clear();
+}
+
+bool StorageBuffer::update(const void* data, size_t size)
+{
+    if (buffer_ && size == contents_.size() &&
+        (size == 0 || memcmp(contents_.data(), data, size) == 0)) {
+        return false;
+    }
+
+    auto bytes = static_cast<const unsigned char*>(data);
+    contents_.assign(bytes, bytes + size);
+
+    if (!buffer_ || size > capacity_) {
+        glDeleteBuffers(1, &buffer_);
+        // Some headroom, so that a growing scene does not reallocate every frame. Zero-sized
+        // storage is an error, so there is at least one element.
+        capacity_ = std::max<size_t>(size + size / 2, 16);
+        glCreateBuffers(1, &buffer_);
+        glNamedBufferStorage(buffer_, capacity_, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    if (size) {
+        glNamedBufferSubData(buffer_, 0, size, data);
+    }
+    return true;
+}
+
+void StorageBuffer::bind(GLuint binding) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer_);
+}
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
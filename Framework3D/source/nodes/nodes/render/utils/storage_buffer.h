@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "USTC_CG.h"
+#include "pxr/imaging/garch/glApi.h"
+
+USTC_CG_NAMESPACE_OPEN_SCOPE
+
+// A shader storage buffer that lives across frames. update() keeps a CPU copy of the contents and
+// only touches the GL buffer when they changed; the storage grows but is never shrunk.
+//
+// The destructor leaves the GL buffer alone, as storage buffers live in globals: call release()
+// while the context is current.
+class StorageBuffer {
+   public:
+    StorageBuffer() = default;
+    StorageBuffer(const StorageBuffer&) = delete;
+    StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+    void release();
+
+    // Returns true if the GL buffer was written.
+    bool update(const void* data, size_t size);
+
+    template<typename T>
+    bool update(const std::vector<T>& values)
+    {
+        return update(values.data(), values.size() * sizeof(T));
+    }
+
+    void bind(GLuint binding) const;
+
+   private:
+    GLuint buffer_ = 0;
+    size_t capacity_ = 0;
+    std::vector<unsigned char> contents_;
+};
+
+USTC_CG_NAMESPACE_CLOSE_SCOPE
@@ -50,9 +50,9 @@ void NodeWindow::BuildUI()
     if (time_code_to_render > geonode_system->cached_last_time_code()) {
         auto cached_time = geonode_system->cached_last_time_code();
         renderer->set_current_time_code(cached_time);
-
-        geonode_system->set_required_time_code(time_code_to_render);
     }
+    // Earlier time codes are played from the frame cache.
+    geonode_system->set_required_time_code(time_code_to_render);
 
     file_viewer->ShowFileTree();
     file_viewer->ShowPrimInfo();